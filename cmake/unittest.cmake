@@ -9,3 +9,8 @@ add_executable(pplcommon_unittest ${PPLCOMMON_UNITTEST_SRC})
 
 target_link_libraries(pplcommon_unittest PRIVATE pplcommon_static gtest gtest_main)
 target_include_directories(pplcommon_unittest PRIVATE ${googletest_SOURCE_DIR}/include)
+
+# coroutine.h is available in c++20 only
+if("cxx_std_20" IN_LIST CMAKE_CXX_COMPILE_FEATURES)
+    target_compile_features(pplcommon_unittest PRIVATE cxx_std_20)
+endif()
@@ -0,0 +1,17 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/hpcc-populate"
+  "CMakeFiles/hpcc-populate-complete"
+  "hpcc-populate-prefix/src/hpcc-populate-stamp/hpcc-populate-build"
+  "hpcc-populate-prefix/src/hpcc-populate-stamp/hpcc-populate-configure"
+  "hpcc-populate-prefix/src/hpcc-populate-stamp/hpcc-populate-download"
+  "hpcc-populate-prefix/src/hpcc-populate-stamp/hpcc-populate-install"
+  "hpcc-populate-prefix/src/hpcc-populate-stamp/hpcc-populate-mkdir"
+  "hpcc-populate-prefix/src/hpcc-populate-stamp/hpcc-populate-patch"
+  "hpcc-populate-prefix/src/hpcc-populate-stamp/hpcc-populate-test"
+  "hpcc-populate-prefix/src/hpcc-populate-stamp/hpcc-populate-update"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang )
+  include(CMakeFiles/hpcc-populate.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,22 @@
+# Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+# file Copyright.txt or https://cmake.org/licensing for details.
+
+cmake_minimum_required(VERSION 3.5)
+
+file(MAKE_DIRECTORY
+  "/root/repo/deps/hpcc"
+  "/tmp/cm_try/hpcc-build"
+  "/root/repo/deps/hpcc-subbuild/hpcc-populate-prefix"
+  "/root/repo/deps/hpcc-subbuild/hpcc-populate-prefix/tmp"
+  "/root/repo/deps/hpcc-subbuild/hpcc-populate-prefix/src/hpcc-populate-stamp"
+  "/root/repo/deps/hpcc-subbuild/hpcc-populate-prefix/src"
+  "/root/repo/deps/hpcc-subbuild/hpcc-populate-prefix/src/hpcc-populate-stamp"
+)
+
+set(configSubDirs )
+foreach(subDir IN LISTS configSubDirs)
+    file(MAKE_DIRECTORY "/root/repo/deps/hpcc-subbuild/hpcc-populate-prefix/src/hpcc-populate-stamp/${subDir}")
+endforeach()
+if(cfgdir)
+  file(MAKE_DIRECTORY "/root/repo/deps/hpcc-subbuild/hpcc-populate-prefix/src/hpcc-populate-stamp${cfgdir}") # cfgdir has leading slash
+endif()
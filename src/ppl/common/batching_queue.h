@@ -0,0 +1,235 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#ifndef _ST_HPC_PPL_COMMON_BATCHING_QUEUE_H_
+#define _ST_HPC_PPL_COMMON_BATCHING_QUEUE_H_
+
+#include "ppl/common/typed_mpsc_queue.h"
+#include "ppl/common/event_count.h"
+#include "ppl/common/retcode.h"
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace ppl { namespace common {
+
+/**
+   a multi-producer-single-consumer queue that hands items to the consumer in batches. a batch is ready once
+   the total cost of pending items reaches `max_batch_cost`, or the oldest pending item has waited for
+   `max_delay_us`, whichever comes first. with the default cost 1 for each item, `max_batch_cost` is the max
+   number of items in a batch.
+
+   producers are lock-free, and wake up the consumer only when the first pending item arrives or the budget is
+   reached. the consumer sleeps on an `EventCount` with a timeout for the delay of the oldest item.
+*/
+
+template <typename T>
+class BatchingQueue final {
+public:
+    /** @param node_cache_size @see `TypedMPSCQueue::TypedMPSCQueue()` */
+    BatchingQueue(uint64_t max_batch_cost, uint64_t max_delay_us, uint32_t node_cache_size = 0)
+        : max_batch_cost_(max_batch_cost)
+        , max_delay_ns_(max_delay_us * 1000)
+        , pending_cost_(0)
+        , queue_(node_cache_size)
+        , staged_cost_(0) {}
+
+    /** `cost` MUST be greater than 0, e.g. the number of tokens of a request. */
+    template <typename ValueType>
+    ppl::common::RetCode Push(ValueType&& value, uint32_t cost = 1) {
+        if (cost == 0) {
+            return ppl::common::RC_INVALID_VALUE;
+        }
+
+        auto rc = queue_.Push(Entry(std::forward<ValueType>(value), cost, Now()));
+        if (rc != ppl::common::RC_SUCCESS) {
+            return rc;
+        }
+
+        // the item MUST be visible in `queue_` before it is counted. see `WaitForBatch()`.
+        const uint64_t prev = pending_cost_.fetch_add(cost, std::memory_order_acq_rel);
+        if (prev == 0 || (prev < max_batch_cost_ && prev + cost >= max_batch_cost_)) {
+            not_empty_.NotifyOneIfWaiting();
+        }
+        return ppl::common::RC_SUCCESS;
+    }
+
+    /**
+       @brief MUST be called by the consumer. blocks until a batch is ready, then appends it to `batch`.
+       a single item whose cost exceeds `max_batch_cost` forms a batch by itself.
+       @return number of items appended
+    */
+    uint32_t PopBatch(std::vector<T>* batch) {
+        WaitForBatch(false, 0);
+        return TakeBatch(batch);
+    }
+
+    /** MUST be called by the consumer. returns 0 if no batch is ready within `timeout_us`. */
+    uint32_t PopBatch(std::vector<T>* batch, uint64_t timeout_us) {
+        if (!WaitForBatch(true, Now() + (int64_t)timeout_us * 1000)) {
+            return 0;
+        }
+        return TakeBatch(batch);
+    }
+
+    /**
+       @brief MUST be called by the consumer. appends all pending items that are ready to `batch` regardless of
+       the cost budget and delay, e.g. when shutting down.
+       @return number of items appended
+    */
+    uint32_t Flush(std::vector<T>* batch) {
+        Drain();
+        const uint32_t n = staged_.size();
+        for (auto x = staged_.begin(); x != staged_.end(); ++x) {
+            batch->push_back(std::move(x->value));
+        }
+        staged_.clear();
+        pending_cost_.fetch_sub(staged_cost_, std::memory_order_relaxed);
+        staged_cost_ = 0;
+        return n;
+    }
+
+    // approximate total cost of items that are not handed to the consumer
+    uint64_t GetPendingCost() const {
+        return pending_cost_.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Entry final {
+        Entry() : cost(0), timestamp(0) {}
+        template <typename ValueType>
+        Entry(ValueType&& v, uint32_t c, int64_t ts) : value(std::forward<ValueType>(v)), cost(c), timestamp(ts) {}
+        T value;
+        uint32_t cost;
+        int64_t timestamp; // in nanoseconds
+    };
+
+    static int64_t Now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    /** moves items from `queue_` to `staged_` */
+    void Drain() {
+        Entry entry;
+        while (queue_.TryPop(&entry)) {
+            staged_cost_ += entry.cost;
+            staged_.push_back(std::move(entry));
+        }
+    }
+
+    bool IsReady(int64_t now) const {
+        return (!staged_.empty() &&
+                (staged_cost_ >= max_batch_cost_ || now - staged_.front().timestamp >= (int64_t)max_delay_ns_));
+    }
+
+    /** returns false if `deadline` is reached and no batch is ready */
+    bool WaitForBatch(bool has_deadline, int64_t deadline) {
+        Drain();
+        if (IsReady(Now())) {
+            return true;
+        }
+
+        while (true) {
+            auto key = not_empty_.PrepareWait();
+            Drain();
+            const int64_t now = Now();
+            if (IsReady(now)) {
+                not_empty_.CancelWait();
+                return true;
+            }
+            if (has_deadline && now >= deadline) {
+                not_empty_.CancelWait();
+                return false;
+            }
+
+            // some counted items are not poppable yet because they are behind items that are being inserted.
+            // producers will not notify for them again.
+            if (pending_cost_.load(std::memory_order_acquire) > staged_cost_) {
+                not_empty_.CancelWait();
+                std::this_thread::yield();
+                continue;
+            }
+
+            int64_t wake_at = deadline;
+            if (!staged_.empty()) {
+                const int64_t expire = staged_.front().timestamp + (int64_t)max_delay_ns_;
+                if (!has_deadline || expire < wake_at) {
+                    wake_at = expire;
+                }
+            } else if (!has_deadline) {
+                not_empty_.CommitWait(key);
+                continue;
+            }
+            not_empty_.CommitWait(key, (wake_at - now) / 1000 + 1);
+        }
+    }
+
+    uint32_t TakeBatch(std::vector<T>* batch) {
+        uint32_t n = 0;
+        uint64_t cost = 0;
+        while (!staged_.empty()) {
+            auto& entry = staged_.front();
+            if (n > 0 && cost + entry.cost > max_batch_cost_) {
+                break;
+            }
+            cost += entry.cost;
+            batch->push_back(std::move(entry.value));
+            staged_.pop_front();
+            ++n;
+        }
+        staged_cost_ -= cost;
+        pending_cost_.fetch_sub(cost, std::memory_order_relaxed);
+        return n;
+    }
+
+private:
+    const uint64_t max_batch_cost_;
+    const uint64_t max_delay_ns_;
+
+    // l1 cache line size for most CPUs
+    static constexpr int CACHELINE_SIZE = 64;
+
+    /** cost of items that are pushed and not taken by `TakeBatch()` or `Flush()` yet */
+    union {
+        std::atomic<uint64_t> pending_cost_;
+        char padding[CACHELINE_SIZE];
+    };
+
+    TypedMPSCQueue<Entry> queue_;
+    EventCount not_empty_;
+
+    // accessed by the consumer only
+    std::deque<Entry> staged_;
+    uint64_t staged_cost_;
+
+private:
+    BatchingQueue(const BatchingQueue&) = delete;
+    BatchingQueue(BatchingQueue&&) = delete;
+    void operator=(const BatchingQueue&) = delete;
+    void operator=(BatchingQueue&&) = delete;
+};
+
+}} // namespace ppl::common
+
+#endif
@@ -0,0 +1,137 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "ppl/common/batching_queue.h"
+#include "gtest/gtest.h"
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+using namespace std;
+using namespace ppl::common;
+
+TEST(BatchingQueueTest, max_batch) {
+    BatchingQueue<int> queue(4, 10000000);
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_EQ(RC_SUCCESS, queue.Push(i));
+    }
+
+    vector<int> batch;
+    ASSERT_EQ(4u, queue.PopBatch(&batch));
+    ASSERT_EQ(4u, queue.PopBatch(&batch));
+    for (int i = 0; i < 8; ++i) {
+        ASSERT_EQ(i, batch[i]);
+    }
+
+    // the remaining 2 items are not enough for a batch and have not waited long enough
+    ASSERT_EQ(0u, queue.PopBatch(&batch, 1000));
+    ASSERT_EQ(2u, queue.GetPendingCost());
+    ASSERT_EQ(2u, queue.Flush(&batch));
+    ASSERT_EQ(10u, batch.size());
+    ASSERT_EQ(9, batch[9]);
+    ASSERT_EQ(0u, queue.GetPendingCost());
+}
+
+TEST(BatchingQueueTest, max_delay) {
+    BatchingQueue<int> queue(100, 20000);
+    vector<int> batch;
+    ASSERT_EQ(0u, queue.PopBatch(&batch, 1000));
+
+    const auto begin = chrono::steady_clock::now();
+    ASSERT_EQ(RC_SUCCESS, queue.Push(1));
+    ASSERT_EQ(RC_SUCCESS, queue.Push(2));
+    ASSERT_EQ(2u, queue.PopBatch(&batch));
+    const auto elapsed = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - begin);
+    ASSERT_GE(elapsed.count(), 20000);
+    ASSERT_EQ(1, batch[0]);
+    ASSERT_EQ(2, batch[1]);
+}
+
+TEST(BatchingQueueTest, cost) {
+    BatchingQueue<unique_ptr<int>> queue(10, 10000000);
+    ASSERT_EQ(RC_INVALID_VALUE, queue.Push(unique_ptr<int>(new int(0)), 0));
+    ASSERT_EQ(RC_SUCCESS, queue.Push(unique_ptr<int>(new int(1)), 4));
+    ASSERT_EQ(RC_SUCCESS, queue.Push(unique_ptr<int>(new int(2)), 5));
+    ASSERT_EQ(RC_SUCCESS, queue.Push(unique_ptr<int>(new int(3)), 3));
+    // larger than the budget
+    ASSERT_EQ(RC_SUCCESS, queue.Push(unique_ptr<int>(new int(4)), 20));
+
+    vector<unique_ptr<int>> batch;
+    ASSERT_EQ(2u, queue.PopBatch(&batch));
+    ASSERT_EQ(1, *batch[0]);
+    ASSERT_EQ(2, *batch[1]);
+
+    batch.clear();
+    ASSERT_EQ(1u, queue.PopBatch(&batch));
+    ASSERT_EQ(3, *batch[0]);
+
+    batch.clear();
+    ASSERT_EQ(1u, queue.PopBatch(&batch));
+    ASSERT_EQ(4, *batch[0]);
+    ASSERT_EQ(0u, queue.GetPendingCost());
+}
+
+TEST(BatchingQueueTest, wake_up_consumer) {
+    BatchingQueue<int> queue(3, 10000000);
+    thread producer([&queue]() {
+        for (int i = 0; i < 3; ++i) {
+            this_thread::sleep_for(chrono::milliseconds(5));
+            ASSERT_EQ(RC_SUCCESS, queue.Push(i));
+        }
+    });
+
+    vector<int> batch;
+    ASSERT_EQ(3u, queue.PopBatch(&batch, 5000000));
+    producer.join();
+}
+
+TEST(BatchingQueueTest, producers_consumer) {
+    const uint32_t producer_num = 4;
+    const uint64_t n = 20000;
+    BatchingQueue<uint64_t> queue(32, 100, 1024);
+
+    vector<thread> producers;
+    for (uint32_t p = 0; p < producer_num; ++p) {
+        producers.emplace_back([&queue, p]() {
+            for (uint64_t i = 0; i < n; ++i) {
+                ASSERT_EQ(RC_SUCCESS, queue.Push((uint64_t)p * n + i, (uint32_t)(i % 8) + 1));
+            }
+        });
+    }
+
+    vector<uint64_t> batch;
+    vector<uint64_t> last(producer_num, 0);
+    uint64_t count = 0;
+    while (count < producer_num * n) {
+        batch.clear();
+        queue.PopBatch(&batch);
+        for (auto v : batch) {
+            // items from the same producer are in order
+            const uint64_t p = v / n;
+            ASSERT_TRUE(v % n == 0 || v > last[p]);
+            last[p] = v;
+        }
+        count += batch.size();
+    }
+
+    for (auto& t : producers) {
+        t.join();
+    }
+    ASSERT_EQ(producer_num * n, count);
+    ASSERT_EQ(0u, queue.GetPendingCost());
+}
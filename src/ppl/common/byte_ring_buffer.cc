@@ -0,0 +1,236 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "ppl/common/byte_ring_buffer.h"
+#include "ppl/common/sys.h"
+#include "ppl/common/log.h"
+#include <new>
+using namespace std;
+
+namespace ppl { namespace common {
+
+ByteRingBufferBase::~ByteRingBufferBase() {
+    if (buffer_) {
+        AlignedFree(buffer_);
+    }
+}
+
+RetCode ByteRingBufferBase::Init(uint64_t capacity) {
+    uint64_t cap = 2 * RECORD_ALIGNMENT;
+    while (cap < capacity) {
+        cap <<= 1;
+    }
+    if (cap / 2 > (uint64_t)UINT32_MAX) {
+        LOG(ERROR) << "capacity [" << capacity << "] is too large.";
+        return RC_INVALID_VALUE;
+    }
+
+    buffer_ = (char*)AlignedAlloc(cap, CACHELINE_SIZE);
+    if (!buffer_) {
+        LOG(ERROR) << "allocate [" << cap << "] bytes failed.";
+        return RC_OUT_OF_MEMORY;
+    }
+    // every slot where a header may be placed starts with an invalid `commit_pos`. see `MPSCByteRingBuffer`.
+    for (uint64_t i = 0; i < cap; i += RECORD_ALIGNMENT) {
+        new (buffer_ + i) RecordHeader();
+        reinterpret_cast<RecordHeader*>(buffer_ + i)->commit_pos.store(INVALID_POS, std::memory_order_relaxed);
+    }
+
+    mask_ = cap - 1;
+    // a record of at most half of the capacity always fits either before the end or from the beginning
+    max_len_ = cap / 2 - sizeof(RecordHeader);
+    return RC_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+ByteRingBuffer::ByteRingBuffer() {
+    producer_.tail.store(0, std::memory_order_relaxed);
+    producer_.head_cache = 0;
+    producer_.reserved_pos = 0;
+    consumer_.head.store(0, std::memory_order_relaxed);
+    consumer_.tail_cache = 0;
+}
+
+RetCode ByteRingBuffer::Init(uint64_t capacity) {
+    return ByteRingBufferBase::Init(capacity);
+}
+
+void* ByteRingBuffer::Reserve(uint32_t len) {
+    if (len > max_len_) {
+        return nullptr;
+    }
+
+    const uint64_t tail = producer_.tail.load(std::memory_order_relaxed);
+    const uint32_t size = GetRecordSize(len);
+    const uint64_t contiguous = GetContiguousSize(tail);
+    const uint64_t padding = (size > contiguous) ? contiguous : 0;
+    const uint64_t needed = padding + size;
+
+    if (tail + needed - producer_.head_cache > GetCapacity()) {
+        producer_.head_cache = consumer_.head.load(std::memory_order_acquire);
+        if (tail + needed - producer_.head_cache > GetCapacity()) {
+            return nullptr;
+        }
+    }
+
+    if (padding > 0) {
+        auto header = GetHeader(tail);
+        header->len = PADDING_LEN;
+        header->size = padding;
+    }
+
+    const uint64_t pos = tail + padding;
+    auto header = GetHeader(pos);
+    header->len = len;
+    header->size = size;
+    producer_.reserved_pos = pos;
+    return header + 1;
+}
+
+void ByteRingBuffer::Commit() {
+    const uint64_t pos = producer_.reserved_pos;
+    producer_.tail.store(pos + GetHeader(pos)->size, std::memory_order_release);
+}
+
+void ByteRingBuffer::Commit(uint32_t len) {
+    auto header = GetHeader(producer_.reserved_pos);
+    header->len = len;
+    header->size = GetRecordSize(len);
+    Commit();
+}
+
+const void* ByteRingBuffer::Peek(uint32_t* len) {
+    uint64_t head = consumer_.head.load(std::memory_order_relaxed);
+    while (true) {
+        if (head == consumer_.tail_cache) {
+            consumer_.tail_cache = producer_.tail.load(std::memory_order_acquire);
+            if (head == consumer_.tail_cache) {
+                return nullptr;
+            }
+        }
+
+        auto header = GetHeader(head);
+        if (header->len != PADDING_LEN) {
+            *len = header->len;
+            return header + 1;
+        }
+        head += header->size;
+        consumer_.head.store(head, std::memory_order_release);
+    }
+}
+
+void ByteRingBuffer::Release() {
+    const uint64_t head = consumer_.head.load(std::memory_order_relaxed);
+    consumer_.head.store(head + GetHeader(head)->size, std::memory_order_release);
+}
+
+/* ------------------------------------------------------------------------- */
+
+MPSCByteRingBuffer::MPSCByteRingBuffer() {
+    tail_.store(0, std::memory_order_relaxed);
+    head_.store(0, std::memory_order_relaxed);
+}
+
+RetCode MPSCByteRingBuffer::Init(uint64_t capacity) {
+    return ByteRingBufferBase::Init(capacity);
+}
+
+void* MPSCByteRingBuffer::Reserve(uint32_t len) {
+    if (len > max_len_) {
+        return nullptr;
+    }
+
+    const uint32_t size = GetRecordSize(len);
+    uint64_t tail = tail_.load(std::memory_order_relaxed);
+    uint64_t contiguous, padding;
+    while (true) {
+        contiguous = GetContiguousSize(tail);
+        padding = (size > contiguous) ? contiguous : 0;
+        // acquire pairs with `Release()`, after which the consumer no longer reads the space
+        if (tail + padding + size - head_.load(std::memory_order_acquire) > GetCapacity()) {
+            return nullptr;
+        }
+        if (tail_.compare_exchange_weak(tail, tail + padding + size, std::memory_order_relaxed)) {
+            break;
+        }
+    }
+
+    if (padding > 0) {
+        auto header = GetHeader(tail);
+        header->len = PADDING_LEN;
+        header->size = padding;
+        header->commit_pos.store(tail, std::memory_order_release);
+    }
+
+    const uint64_t pos = tail + padding;
+    auto header = GetHeader(pos);
+    header->len = len;
+    header->size = size;
+    // not a valid position before the record is committed. `Commit()` gets the position from it.
+    header->commit_pos.store(~pos, std::memory_order_relaxed);
+    return header + 1;
+}
+
+void MPSCByteRingBuffer::Commit(void* data) {
+    auto header = static_cast<RecordHeader*>(data) - 1;
+    header->commit_pos.store(~header->commit_pos.load(std::memory_order_relaxed), std::memory_order_release);
+}
+
+void MPSCByteRingBuffer::Commit(void* data, uint32_t len) {
+    auto header = static_cast<RecordHeader*>(data) - 1;
+    header->len = len;
+    Commit(data);
+}
+
+const void* MPSCByteRingBuffer::Peek(uint32_t* len) {
+    uint64_t head = head_.load(std::memory_order_relaxed);
+    while (true) {
+        auto header = GetHeader(head);
+        if (header->commit_pos.load(std::memory_order_acquire) != head) {
+            return nullptr;
+        }
+        if (header->len != PADDING_LEN) {
+            *len = header->len;
+            return header + 1;
+        }
+        head += Invalidate(head);
+        head_.store(head, std::memory_order_release);
+    }
+}
+
+void MPSCByteRingBuffer::Release() {
+    const uint64_t head = head_.load(std::memory_order_relaxed);
+    head_.store(head + Invalidate(head), std::memory_order_release);
+}
+
+/*
+  the consumer treats the slot at `head_` as a committed header if its `commit_pos` equals `head_`. a header of the
+  next lap may be placed at any aligned slot in a released record, where payload bytes of this lap may happen to
+  equal that position. so every slot of a record is reset to an invalid position before its space is returned to
+  producers, and a slot is either invalid or written by the producer that owns it.
+*/
+uint32_t MPSCByteRingBuffer::Invalidate(uint64_t pos) {
+    const uint32_t size = GetHeader(pos)->size;
+    for (uint32_t offset = 0; offset < size; offset += RECORD_ALIGNMENT) {
+        GetHeader(pos + offset)->commit_pos.store(INVALID_POS, std::memory_order_relaxed);
+    }
+    return size;
+}
+
+}} // namespace ppl::common
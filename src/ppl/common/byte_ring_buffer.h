@@ -0,0 +1,207 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#ifndef _ST_HPC_PPL_COMMON_BYTE_RING_BUFFER_H_
+#define _ST_HPC_PPL_COMMON_BYTE_RING_BUFFER_H_
+
+#include "ppl/common/retcode.h"
+#include <stdint.h>
+#include <atomic>
+
+namespace ppl { namespace common {
+
+/**
+   ring buffers of variable-length records in a contiguous byte array. producers write records in place by
+   `Reserve()` and `Commit()`, and the consumer reads them in place by `Peek()` and `Release()`, so no memory is
+   allocated per record. each record starts with a header and is aligned to `RECORD_ALIGNMENT` bytes. a record
+   never wraps around the end of the buffer. if it does not fit in the rest of the buffer, the rest is filled
+   with a padding record which is skipped by the consumer.
+*/
+
+class ByteRingBufferBase {
+public:
+    static constexpr uint32_t RECORD_ALIGNMENT = 16;
+
+public:
+    uint64_t GetCapacity() const {
+        return mask_ + 1;
+    }
+    /** the max `len` accepted by `Reserve()` */
+    uint32_t GetMaxLength() const {
+        return max_len_;
+    }
+
+protected:
+    struct RecordHeader final {
+        /** used by `MPSCByteRingBuffer` only. it equals the position of the record after the record is committed. */
+        std::atomic<uint64_t> commit_pos;
+        /** length of the payload, or PADDING_LEN */
+        uint32_t len;
+        /** total bytes of the record, including the header */
+        uint32_t size;
+    };
+    static_assert(sizeof(RecordHeader) == RECORD_ALIGNMENT, "unexpected size of RecordHeader");
+
+    static constexpr uint32_t PADDING_LEN = UINT32_MAX;
+    /** not a position of any record */
+    static constexpr uint64_t INVALID_POS = UINT64_MAX;
+
+    // l1 cache line size for most CPUs
+    static constexpr int CACHELINE_SIZE = 64;
+
+protected:
+    ByteRingBufferBase() : buffer_(nullptr), mask_(0), max_len_(0) {}
+    ~ByteRingBufferBase();
+
+    ppl::common::RetCode Init(uint64_t capacity);
+
+    RecordHeader* GetHeader(uint64_t pos) const {
+        return reinterpret_cast<RecordHeader*>(buffer_ + (pos & mask_));
+    }
+    static uint32_t GetRecordSize(uint32_t len) {
+        return (sizeof(RecordHeader) + len + RECORD_ALIGNMENT - 1) & ~(RECORD_ALIGNMENT - 1);
+    }
+    /** bytes from `pos` to the end of the buffer */
+    uint64_t GetContiguousSize(uint64_t pos) const {
+        return (mask_ + 1) - (pos & mask_);
+    }
+
+protected:
+    char* buffer_;
+    uint64_t mask_;
+    uint32_t max_len_;
+
+private:
+    ByteRingBufferBase(const ByteRingBufferBase&) = delete;
+    ByteRingBufferBase(ByteRingBufferBase&&) = delete;
+    void operator=(const ByteRingBufferBase&) = delete;
+    void operator=(ByteRingBufferBase&&) = delete;
+};
+
+/** a single-producer-single-consumer byte ring buffer */
+class ByteRingBuffer final : public ByteRingBufferBase {
+public:
+    ByteRingBuffer();
+
+    /**
+       @brief `capacity` is rounded up to a power of 2. records of up to half of the capacity, including their
+       headers, are accepted.
+    */
+    ppl::common::RetCode Init(uint64_t capacity);
+
+    /**
+       @brief returns a contiguous writable span of `len` bytes, or nullptr if there is not enough space or `len`
+       exceeds `GetMaxLength()`. the span is published to the consumer by `Commit()`. one record can be reserved
+       at a time.
+    */
+    void* Reserve(uint32_t len);
+    /** publishes the reserved record */
+    void Commit();
+    /** publishes the first `len` bytes of the reserved record, which MUST NOT exceed the reserved length */
+    void Commit(uint32_t len);
+
+    /**
+       @brief returns the payload of the next record and sets `len` to its length, or returns nullptr if the
+       buffer is empty. the record is valid until `Release()`.
+    */
+    const void* Peek(uint32_t* len);
+    /** returns the space of the record returned by `Peek()` to the producer */
+    void Release();
+
+    // approximate
+    bool IsEmpty() const {
+        return (consumer_.head.load(std::memory_order_relaxed) == producer_.tail.load(std::memory_order_relaxed));
+    }
+
+private:
+    struct ProducerIndex final {
+        std::atomic<uint64_t> tail;
+        /** a copy of the consumer's head, which may be older than the real one */
+        uint64_t head_cache;
+        /** the position of the reserved record. padding before it is published with it. */
+        uint64_t reserved_pos;
+    };
+    struct ConsumerIndex final {
+        std::atomic<uint64_t> head;
+        /** a copy of the producer's tail, which may be older than the real one */
+        uint64_t tail_cache;
+    };
+
+    union {
+        ProducerIndex producer_;
+        char padding1[CACHELINE_SIZE];
+    };
+    union {
+        ConsumerIndex consumer_;
+        char padding2[CACHELINE_SIZE];
+    };
+};
+
+/**
+   a multi-producer-single-consumer byte ring buffer. producers claim space by a CAS on a shared position, and each
+   record is committed separately by setting its `commit_pos`, so a slow producer only delays the records after its
+   own. the consumer reads records in the order they are reserved.
+*/
+class MPSCByteRingBuffer final : public ByteRingBufferBase {
+public:
+    MPSCByteRingBuffer();
+
+    /** @see `ByteRingBuffer::Init()` */
+    ppl::common::RetCode Init(uint64_t capacity);
+
+    /**
+       @brief returns a contiguous writable span of `len` bytes, or nullptr if there is not enough space or `len`
+       exceeds `GetMaxLength()`. can be called by any thread, and each thread can reserve many records at a time.
+    */
+    void* Reserve(uint32_t len);
+    /** publishes the record `data` returned by `Reserve()` */
+    void Commit(void* data);
+    /**
+       @brief publishes the first `len` bytes of the record `data`, which MUST NOT exceed the reserved length.
+       the space of the rest is not reused until the record is released.
+    */
+    void Commit(void* data, uint32_t len);
+
+    /** @see `ByteRingBuffer::Peek()`. MUST be called by the consumer. */
+    const void* Peek(uint32_t* len);
+    /** @see `ByteRingBuffer::Release()`. MUST be called by the consumer. */
+    void Release();
+
+    // approximate
+    bool IsEmpty() const {
+        return (head_.load(std::memory_order_relaxed) == tail_.load(std::memory_order_relaxed));
+    }
+
+private:
+    /** resets `commit_pos` of all slots of the record at `pos` and returns its size */
+    uint32_t Invalidate(uint64_t pos);
+
+private:
+    union {
+        std::atomic<uint64_t> tail_;
+        char padding1[CACHELINE_SIZE];
+    };
+    union {
+        std::atomic<uint64_t> head_;
+        char padding2[CACHELINE_SIZE];
+    };
+};
+
+}} // namespace ppl::common
+
+#endif
@@ -0,0 +1,221 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "ppl/common/byte_ring_buffer.h"
+#include "gtest/gtest.h"
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+using namespace ppl::common;
+
+TEST(ByteRingBufferTest, reserve_commit) {
+    ByteRingBuffer ring;
+    ASSERT_EQ(RC_SUCCESS, ring.Init(200));
+    ASSERT_EQ(256u, ring.GetCapacity());
+    ASSERT_EQ(112u, ring.GetMaxLength());
+    ASSERT_TRUE(ring.IsEmpty());
+    ASSERT_EQ(nullptr, ring.Reserve(113));
+
+    uint32_t len;
+    ASSERT_EQ(nullptr, ring.Peek(&len));
+
+    // records of 60 bytes take 80 bytes with headers. the one of 100 bytes takes 128 bytes and does not fit
+    // before the end in the first round.
+    for (int round = 0; round < 10; ++round) {
+        for (int i = 0; i < 2; ++i) {
+            auto data = (char*)ring.Reserve(60);
+            ASSERT_NE(nullptr, data);
+            memset(data, 'a' + i, 60);
+            // not visible before committed
+            if (i == 0) {
+                ASSERT_EQ(nullptr, ring.Peek(&len));
+            }
+            ring.Commit();
+        }
+        ASSERT_EQ(nullptr, ring.Reserve(100));
+
+        for (int i = 0; i < 2; ++i) {
+            auto data = (const char*)ring.Peek(&len);
+            ASSERT_NE(nullptr, data);
+            ASSERT_EQ(60u, len);
+            ASSERT_EQ('a' + i, data[0]);
+            ASSERT_EQ('a' + i, data[59]);
+            ring.Release();
+        }
+        ASSERT_EQ(nullptr, ring.Peek(&len));
+
+        auto wdata = (char*)ring.Reserve(100);
+        ASSERT_NE(nullptr, wdata);
+        memcpy(wdata, "hello", 5);
+        ring.Commit(5);
+
+        auto data = (const char*)ring.Peek(&len);
+        ASSERT_NE(nullptr, data);
+        ASSERT_EQ(5u, len);
+        ASSERT_EQ(0, memcmp(data, "hello", 5));
+        ring.Release();
+        ASSERT_EQ(nullptr, ring.Peek(&len));
+        ASSERT_TRUE(ring.IsEmpty());
+    }
+}
+
+TEST(ByteRingBufferTest, producer_consumer) {
+    ByteRingBuffer ring;
+    ASSERT_EQ(RC_SUCCESS, ring.Init(4096));
+
+    const uint32_t n = 100000;
+    thread producer([&ring]() {
+        for (uint32_t i = 0; i < n; ++i) {
+            const uint32_t len = sizeof(uint32_t) * (1 + i % 50);
+            uint32_t* data;
+            while (!(data = (uint32_t*)ring.Reserve(len))) {
+                this_thread::yield();
+            }
+            for (uint32_t j = 0; j < len / sizeof(uint32_t); ++j) {
+                data[j] = i + j;
+            }
+            ring.Commit();
+        }
+    });
+
+    for (uint32_t i = 0; i < n; ++i) {
+        uint32_t len;
+        const uint32_t* data;
+        while (!(data = (const uint32_t*)ring.Peek(&len))) {
+            this_thread::yield();
+        }
+        ASSERT_EQ(sizeof(uint32_t) * (1 + i % 50), len);
+        for (uint32_t j = 0; j < len / sizeof(uint32_t); ++j) {
+            ASSERT_EQ(i + j, data[j]);
+        }
+        ring.Release();
+    }
+    producer.join();
+}
+
+TEST(MPSCByteRingBufferTest, out_of_order_commit) {
+    MPSCByteRingBuffer ring;
+    ASSERT_EQ(RC_SUCCESS, ring.Init(256));
+
+    auto first = (char*)ring.Reserve(10);
+    auto second = (char*)ring.Reserve(20);
+    ASSERT_NE(nullptr, first);
+    ASSERT_NE(nullptr, second);
+    memset(second, 'b', 20);
+    ring.Commit(second);
+
+    // records are consumed in the order they are reserved
+    uint32_t len;
+    ASSERT_EQ(nullptr, ring.Peek(&len));
+    memset(first, 'a', 10);
+    ring.Commit(first, 5);
+
+    auto data = (const char*)ring.Peek(&len);
+    ASSERT_EQ(5u, len);
+    ASSERT_EQ('a', data[0]);
+    ring.Release();
+    data = (const char*)ring.Peek(&len);
+    ASSERT_EQ(20u, len);
+    ASSERT_EQ('b', data[19]);
+    ring.Release();
+    ASSERT_EQ(nullptr, ring.Peek(&len));
+    ASSERT_TRUE(ring.IsEmpty());
+}
+
+TEST(MPSCByteRingBufferTest, stale_payload) {
+    MPSCByteRingBuffer ring;
+    ASSERT_EQ(RC_SUCCESS, ring.Init(128));
+
+    // the first payload word is at position 16 and holds 144, where the header after the third record will be
+    auto data = (char*)ring.Reserve(48);
+    ASSERT_NE(nullptr, data);
+    const uint64_t fake_pos = 144;
+    memcpy(data, &fake_pos, sizeof(fake_pos));
+    ring.Commit(data);
+
+    uint32_t len;
+    ASSERT_NE(nullptr, ring.Peek(&len));
+    ring.Release();
+
+    data = (char*)ring.Reserve(48);
+    ASSERT_NE(nullptr, data);
+    ring.Commit(data);
+    ASSERT_NE(nullptr, ring.Peek(&len));
+    ring.Release();
+
+    data = (char*)ring.Reserve(0);
+    ASSERT_NE(nullptr, data);
+    ring.Commit(data);
+    ASSERT_NE(nullptr, ring.Peek(&len));
+    ASSERT_EQ(0u, len);
+    ring.Release();
+
+    ASSERT_TRUE(ring.IsEmpty());
+    ASSERT_EQ(nullptr, ring.Peek(&len));
+}
+
+TEST(MPSCByteRingBufferTest, producers_consumer) {
+    MPSCByteRingBuffer ring;
+    ASSERT_EQ(RC_SUCCESS, ring.Init(4096));
+
+    const uint32_t producer_num = 4;
+    const uint32_t n = 20000;
+    vector<thread> producers;
+    for (uint32_t p = 0; p < producer_num; ++p) {
+        producers.emplace_back([&ring, p]() {
+            for (uint32_t i = 0; i < n; ++i) {
+                const uint32_t len = sizeof(uint32_t) * (2 + i % 30);
+                uint32_t* data;
+                while (!(data = (uint32_t*)ring.Reserve(len))) {
+                    this_thread::yield();
+                }
+                data[0] = p;
+                for (uint32_t j = 1; j < len / sizeof(uint32_t); ++j) {
+                    data[j] = i;
+                }
+                ring.Commit(data);
+            }
+        });
+    }
+
+    // records of each producer arrive in order
+    vector<uint32_t> next(producer_num, 0);
+    for (uint32_t k = 0; k < producer_num * n; ++k) {
+        uint32_t len;
+        const uint32_t* data;
+        while (!(data = (const uint32_t*)ring.Peek(&len))) {
+            this_thread::yield();
+        }
+        const uint32_t p = data[0];
+        ASSERT_LT(p, producer_num);
+        const uint32_t i = next[p]++;
+        ASSERT_EQ(sizeof(uint32_t) * (2 + i % 30), len);
+        for (uint32_t j = 1; j < len / sizeof(uint32_t); ++j) {
+            ASSERT_EQ(i, data[j]);
+        }
+        ring.Release();
+    }
+    for (auto t = producers.begin(); t != producers.end(); ++t) {
+        t->join();
+    }
+    for (uint32_t p = 0; p < producer_num; ++p) {
+        ASSERT_EQ(n, next[p]);
+    }
+}
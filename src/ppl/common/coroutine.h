@@ -0,0 +1,646 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#ifndef _ST_HPC_PPL_COMMON_COROUTINE_H_
+#define _ST_HPC_PPL_COMMON_COROUTINE_H_
+
+/**
+   c++20 coroutine support on top of `ThreadPool`. this header is optional: it is empty unless compiled as c++20
+   or later with coroutine support, so that the core library can still be built as c++11.
+   `PPLCOMMON_HAS_COROUTINE` is defined if the content is available.
+*/
+
+#if defined(_MSVC_LANG)
+#define PPLCOMMON_CPLUSPLUS _MSVC_LANG
+#else
+#define PPLCOMMON_CPLUSPLUS __cplusplus
+#endif
+
+#if PPLCOMMON_CPLUSPLUS >= 202002L && defined(__has_include)
+#if __has_include(<coroutine>) && defined(__cpp_impl_coroutine)
+#define PPLCOMMON_HAS_COROUTINE 1
+#endif
+#endif
+
+#undef PPLCOMMON_CPLUSPLUS
+
+#ifdef PPLCOMMON_HAS_COROUTINE
+
+#include "ppl/common/threadpool.h"
+#include <stdint.h>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace ppl { namespace common {
+
+/**
+   allocates coroutine frames of `Task<T>` from per-thread free lists of size classes, so that frames are
+   recycled without touching the heap in steady state. a frame released by another thread goes to the free
+   list of that thread. frames larger than `MAX_SIZE` go to the heap directly.
+*/
+class CoroutineFrameAllocator final {
+public:
+    static void* Alloc(size_t size) {
+        if (size > MAX_SIZE) {
+            return ::operator new(size);
+        }
+        auto list = &GetCache()->lists[GetClass(size)];
+        auto block = list->head;
+        if (block) {
+            list->head = block->next;
+            --list->size;
+            return block;
+        }
+        return ::operator new((GetClass(size) + 1) * SIZE_STEP);
+    }
+
+    static void Free(void* p, size_t size) {
+        if (size > MAX_SIZE) {
+            ::operator delete(p);
+            return;
+        }
+        auto list = &GetCache()->lists[GetClass(size)];
+        if (list->size >= MAX_CACHED_PER_CLASS) {
+            ::operator delete(p);
+            return;
+        }
+        auto block = static_cast<Block*>(p);
+        block->next = list->head;
+        list->head = block;
+        ++list->size;
+    }
+
+public:
+    static constexpr size_t SIZE_STEP = 64;
+    static constexpr size_t MAX_SIZE = 1024;
+    static constexpr uint32_t MAX_CACHED_PER_CLASS = 256;
+
+private:
+    struct Block final {
+        Block* next;
+    };
+
+    struct FreeList final {
+        Block* head = nullptr;
+        uint32_t size = 0;
+    };
+
+    struct Cache final {
+        ~Cache() {
+            for (size_t i = 0; i < CLASS_NUM; ++i) {
+                while (lists[i].head) {
+                    auto next = lists[i].head->next;
+                    ::operator delete(lists[i].head);
+                    lists[i].head = next;
+                }
+            }
+        }
+        static constexpr size_t CLASS_NUM = MAX_SIZE / SIZE_STEP;
+        FreeList lists[CLASS_NUM];
+    };
+
+    static size_t GetClass(size_t size) {
+        return (size + SIZE_STEP - 1) / SIZE_STEP - 1;
+    }
+
+    static Cache* GetCache() {
+        static thread_local Cache cache;
+        return &cache;
+    }
+};
+
+/* ------------------------------------------------------------------------- */
+
+namespace detail {
+
+/** the intrusive task that resumes a coroutine. embedded in awaiters, which live in coroutine frames. */
+class ResumeTask final : public IntrusiveThreadTask {
+public:
+    IntrusiveThreadTask* Run() override {
+        // the frame, including this object, may be destroyed during `resume()`
+        handle.resume();
+        return nullptr;
+    }
+
+    std::coroutine_handle<> handle;
+};
+
+/** the fallback of `ResumeTask` for pools without intrusive task support */
+class SharedResumeTask final : public ThreadTask {
+public:
+    SharedResumeTask(std::coroutine_handle<> h) : handle_(h) {}
+    std::shared_ptr<ThreadTask> Run() override {
+        handle_.resume();
+        return std::shared_ptr<ThreadTask>();
+    }
+
+private:
+    std::coroutine_handle<> handle_;
+};
+
+/** schedules `h` to be resumed by `pool`. returns false if the pool refuses it. */
+inline bool ResumeOn(ThreadPool* pool, uint32_t queue_idx, ResumeTask* task, std::coroutine_handle<> h) {
+    if (pool->IsIntrusiveTaskSupported()) {
+        task->handle = h;
+        return (pool->AddTask(task, queue_idx) == RC_SUCCESS);
+    }
+    auto shared_task = std::make_shared<SharedResumeTask>(h);
+    return (pool->AddTask(shared_task, queue_idx) == RC_SUCCESS);
+}
+
+} // namespace detail
+
+/**
+   `co_await Schedule(pool)` suspends the current coroutine and resumes it on a worker thread of `pool`.
+   no allocation is needed if `pool->IsIntrusiveTaskSupported()`. if the task cannot be added, the coroutine
+   continues on the current thread.
+*/
+class ScheduleAwaiter final {
+public:
+    ScheduleAwaiter(ThreadPool* pool, uint32_t queue_idx) : pool_(pool), queue_idx_(queue_idx) {}
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+    bool await_suspend(std::coroutine_handle<> h) {
+        return detail::ResumeOn(pool_, queue_idx_, &task_, h);
+    }
+    void await_resume() const noexcept {}
+
+private:
+    ThreadPool* pool_;
+    uint32_t queue_idx_;
+    detail::ResumeTask task_;
+};
+
+/** `queue_idx` has the same meaning as in `ThreadPool::AddTask()` */
+inline ScheduleAwaiter Schedule(ThreadPool* pool, uint32_t queue_idx = 0) {
+    return ScheduleAwaiter(pool, queue_idx);
+}
+
+/* ------------------------------------------------------------------------- */
+
+template <typename T>
+class Task;
+
+namespace detail {
+
+class TaskPromiseBase {
+public:
+    struct FinalAwaiter final {
+        bool await_ready() const noexcept {
+            return false;
+        }
+        /** transfers control to the awaiting coroutine directly, on the same thread and without scheduling */
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept {
+            auto continuation = h.promise().continuation_;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+        void await_resume() const noexcept {}
+    };
+
+    static void* operator new(size_t size) {
+        return CoroutineFrameAllocator::Alloc(size);
+    }
+    static void operator delete(void* p, size_t size) {
+        CoroutineFrameAllocator::Free(p, size);
+    }
+
+    std::suspend_always initial_suspend() const noexcept {
+        return {};
+    }
+    FinalAwaiter final_suspend() const noexcept {
+        return {};
+    }
+    void unhandled_exception() noexcept {
+        exception_ = std::current_exception();
+    }
+
+    void SetContinuation(std::coroutine_handle<> h) {
+        continuation_ = h;
+    }
+
+protected:
+    void RethrowIfFailed() {
+        if (exception_) {
+            std::rethrow_exception(exception_);
+        }
+    }
+
+private:
+    std::coroutine_handle<> continuation_;
+    std::exception_ptr exception_;
+};
+
+template <typename T>
+class TaskPromise final : public TaskPromiseBase {
+public:
+    Task<T> get_return_object() noexcept;
+
+    template <typename U>
+    void return_value(U&& value) {
+        value_.emplace(std::forward<U>(value));
+    }
+
+    T GetResult() {
+        RethrowIfFailed();
+        return std::move(*value_);
+    }
+
+private:
+    std::optional<T> value_;
+};
+
+template <>
+class TaskPromise<void> final : public TaskPromiseBase {
+public:
+    Task<void> get_return_object() noexcept;
+
+    void return_void() const noexcept {}
+
+    void GetResult() {
+        RethrowIfFailed();
+    }
+};
+
+} // namespace detail
+
+/**
+   a lazily started coroutine returning `T`. it starts when it is awaited, and runs on the thread of the
+   awaiting coroutine until it suspends. when it completes, the awaiting coroutine is resumed in place by
+   symmetric transfer, i.e. on the thread that completes the task, with no extra scheduling. use
+   `co_await Schedule(pool)` inside to move to a pool explicitly.
+*/
+template <typename T = void>
+class [[nodiscard]] Task final {
+public:
+    typedef detail::TaskPromise<T> promise_type;
+
+public:
+    Task() noexcept {}
+    Task(Task&& rhs) noexcept : handle_(std::exchange(rhs.handle_, nullptr)) {}
+    Task& operator=(Task&& rhs) noexcept {
+        if (this != &rhs) {
+            if (handle_) {
+                handle_.destroy();
+            }
+            handle_ = std::exchange(rhs.handle_, nullptr);
+        }
+        return *this;
+    }
+    ~Task() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    bool IsValid() const {
+        return (bool)handle_;
+    }
+
+    auto operator co_await() && noexcept {
+        struct Awaiter final {
+            bool await_ready() const noexcept {
+                return false;
+            }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                handle.promise().SetContinuation(awaiting);
+                return handle;
+            }
+            T await_resume() {
+                return handle.promise().GetResult();
+            }
+            std::coroutine_handle<promise_type> handle;
+        };
+        return Awaiter{handle_};
+    }
+
+private:
+    friend class detail::TaskPromise<T>;
+    explicit Task(std::coroutine_handle<promise_type> h) noexcept : handle_(h) {}
+
+private:
+    std::coroutine_handle<promise_type> handle_;
+
+private:
+    Task(const Task&) = delete;
+    void operator=(const Task&) = delete;
+};
+
+namespace detail {
+
+template <typename T>
+inline Task<T> TaskPromise<T>::get_return_object() noexcept {
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() noexcept {
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+/** a coroutine which starts eagerly and destroys itself when it completes */
+class DetachedTask final {
+public:
+    class promise_type final {
+    public:
+        static void* operator new(size_t size) {
+            return CoroutineFrameAllocator::Alloc(size);
+        }
+        static void operator delete(void* p, size_t size) {
+            CoroutineFrameAllocator::Free(p, size);
+        }
+        DetachedTask get_return_object() const noexcept {
+            return {};
+        }
+        std::suspend_never initial_suspend() const noexcept {
+            return {};
+        }
+        std::suspend_never final_suspend() const noexcept {
+            return {};
+        }
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept {
+            std::terminate();
+        }
+    };
+};
+
+template <typename T>
+inline DetachedTask RunDetached(ThreadPool* pool, uint32_t queue_idx, Task<T> task) {
+    co_await Schedule(pool, queue_idx);
+    co_await std::move(task);
+}
+
+/** runs `task` and calls `notify()` at last. the result or exception of `task` is stored before notifying. */
+template <typename T, typename Func>
+inline DetachedTask RunAndNotify(Task<T> task, std::optional<T>* result, std::exception_ptr* exception,
+                                 Func notify) {
+    try {
+        result->emplace(co_await std::move(task));
+    } catch (...) {
+        *exception = std::current_exception();
+    }
+    notify();
+}
+
+template <typename Func>
+inline DetachedTask RunAndNotify(Task<void> task, std::exception_ptr* exception, Func notify) {
+    try {
+        co_await std::move(task);
+    } catch (...) {
+        *exception = std::current_exception();
+    }
+    notify();
+}
+
+} // namespace detail
+
+/**
+   runs `task` on `pool` without waiting for it. the result is dropped, and an exception escaping from it
+   terminates the program.
+*/
+template <typename T>
+inline void Spawn(ThreadPool* pool, Task<T> task, uint32_t queue_idx = 0) {
+    detail::RunDetached(pool, queue_idx, std::move(task));
+}
+
+/** starts `task` on the current thread and blocks until it completes. MUST NOT be called by worker threads. */
+template <typename T>
+T SyncWait(Task<T> task) {
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool done = false;
+    // notifies with the lock held, so that the waiter cannot return and destroy `cond` before it is notified
+    auto notify = [&mutex, &cond, &done]() {
+        std::lock_guard<std::mutex> guard(mutex);
+        done = true;
+        cond.notify_one();
+    };
+    auto wait = [&mutex, &cond, &done]() {
+        std::unique_lock<std::mutex> lock(mutex);
+        cond.wait(lock, [&done]() -> bool {
+            return done;
+        });
+    };
+
+    std::exception_ptr exception;
+    if constexpr (std::is_void<T>::value) {
+        detail::RunAndNotify(std::move(task), &exception, notify);
+        wait();
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+    } else {
+        std::optional<T> result;
+        detail::RunAndNotify(std::move(task), &result, &exception, notify);
+        wait();
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+        return std::move(*result);
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+   the coroutine counterpart of `EventCount`. `co_await ec.Wait(pool, stop_waiting)` suspends the coroutine
+   until `stop_waiting()` returns true, without blocking any thread. a notified coroutine is resumed on `pool`.
+*/
+class AsyncEventCount final {
+private:
+    struct WaiterNode final {
+        detail::ResumeTask task;
+        std::coroutine_handle<> handle;
+        ThreadPool* pool = nullptr;
+    };
+
+public:
+    AsyncEventCount() {}
+
+    /** a single attempt to wait. `IsSatisfied()` is false if it is notified before `stop_waiting()` holds. */
+    template <typename Predicate>
+    class WaitAwaiter final {
+    public:
+        WaitAwaiter(AsyncEventCount* ec, ThreadPool* pool, Predicate* pred) : ec_(ec), pool_(pool), pred_(pred) {}
+
+        bool await_ready() {
+            satisfied_ = (*pred_)();
+            return satisfied_;
+        }
+        bool await_suspend(std::coroutine_handle<> h) {
+            node_.handle = h;
+            node_.pool = pool_;
+            std::lock_guard<std::mutex> guard(ec_->mutex_);
+            // checks again with the lock held, so that a notification after `await_ready()` is not lost
+            satisfied_ = (*pred_)();
+            if (satisfied_) {
+                return false;
+            }
+            ec_->waiters_.push_back(&node_);
+            return true;
+        }
+        void await_resume() {
+            if (!satisfied_) {
+                satisfied_ = (*pred_)();
+            }
+        }
+        bool IsSatisfied() const {
+            return satisfied_;
+        }
+
+    private:
+        AsyncEventCount* ec_;
+        ThreadPool* pool_;
+        Predicate* pred_;
+        WaiterNode node_;
+        bool satisfied_ = false;
+    };
+
+    /**
+       returns a `Task` which completes when `stop_waiting()` returns true. `stop_waiting()` is never called again
+       after it returns true, so it may consume the state it checks, e.g. pop an item.
+    */
+    template <typename Predicate>
+    Task<void> Wait(ThreadPool* pool, Predicate stop_waiting) {
+        while (true) {
+            WaitAwaiter<Predicate> awaiter(this, pool, &stop_waiting);
+            co_await awaiter;
+            if (awaiter.IsSatisfied()) {
+                co_return;
+            }
+        }
+    }
+
+    void NotifyOne() {
+        WaiterNode* node = nullptr;
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            if (waiters_.empty()) {
+                return;
+            }
+            node = waiters_.front();
+            waiters_.pop_front();
+        }
+        Resume(node);
+    }
+
+    void NotifyAll() {
+        std::deque<WaiterNode*> waiters;
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            waiters.swap(waiters_);
+        }
+        for (auto x = waiters.begin(); x != waiters.end(); ++x) {
+            Resume(*x);
+        }
+    }
+
+private:
+    static void Resume(WaiterNode* node) {
+        if (!detail::ResumeOn(node->pool, 0, &node->task, node->handle)) {
+            node->handle.resume();
+        }
+    }
+
+private:
+    std::mutex mutex_;
+    std::deque<WaiterNode*> waiters_;
+
+private:
+    AsyncEventCount(const AsyncEventCount&) = delete;
+    AsyncEventCount(AsyncEventCount&&) = delete;
+    void operator=(const AsyncEventCount&) = delete;
+    void operator=(AsyncEventCount&&) = delete;
+};
+
+/**
+   an unbounded multi-producer-multi-consumer queue whose `Pop()` suspends the calling coroutine instead of
+   blocking the thread if the queue is empty.
+*/
+template <typename T>
+class AsyncQueue final {
+public:
+    AsyncQueue() {}
+
+    template <typename ItemType>
+    void Push(ItemType&& item) {
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            items_.push_back(std::forward<ItemType>(item));
+        }
+        not_empty_.NotifyOne();
+    }
+
+    bool TryPop(T* item) {
+        std::lock_guard<std::mutex> guard(mutex_);
+        if (items_.empty()) {
+            return false;
+        }
+        *item = std::move(items_.front());
+        items_.pop_front();
+        return true;
+    }
+
+    /** `co_await queue.Pop(pool)` returns the next item. the coroutine is resumed on `pool` if it suspends. */
+    Task<T> Pop(ThreadPool* pool) {
+        std::optional<T> item;
+        co_await not_empty_.Wait(pool, [this, &item]() -> bool {
+            std::lock_guard<std::mutex> guard(mutex_);
+            if (items_.empty()) {
+                return false;
+            }
+            item.emplace(std::move(items_.front()));
+            items_.pop_front();
+            return true;
+        });
+        co_return std::move(*item);
+    }
+
+    size_t Size() {
+        std::lock_guard<std::mutex> guard(mutex_);
+        return items_.size();
+    }
+
+private:
+    std::mutex mutex_;
+    std::deque<T> items_;
+    AsyncEventCount not_empty_;
+
+private:
+    AsyncQueue(const AsyncQueue&) = delete;
+    AsyncQueue(AsyncQueue&&) = delete;
+    void operator=(const AsyncQueue&) = delete;
+    void operator=(AsyncQueue&&) = delete;
+};
+
+}} // namespace ppl::common
+
+#endif // PPLCOMMON_HAS_COROUTINE
+
+#endif
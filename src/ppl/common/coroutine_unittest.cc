@@ -0,0 +1,175 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "ppl/common/coroutine.h"
+
+#ifdef PPLCOMMON_HAS_COROUTINE
+
+#include "gtest/gtest.h"
+#include <pthread.h>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace ppl::common;
+
+static Task<int> Add(int a, int b) {
+    co_return a + b;
+}
+
+static Task<int> SumOnPool(ThreadPool* pool, int n) {
+    co_await Schedule(pool);
+    int sum = 0;
+    for (int i = 0; i < n; ++i) {
+        sum += co_await Add(i, 1);
+    }
+    co_return sum;
+}
+
+TEST(CoroutineTest, task) {
+    ASSERT_EQ(3, SyncWait(Add(1, 2)));
+}
+
+static Task<bool> RunsOnOtherThread(ThreadPool* pool, pthread_t caller) {
+    co_await Schedule(pool);
+    co_return !pthread_equal(caller, pthread_self());
+}
+
+TEST(CoroutineTest, schedule) {
+    const ThreadPool::SchedPolicy policies[] = {ThreadPool::SCHED_SHARED_QUEUE, ThreadPool::SCHED_WORK_STEALING};
+    for (auto policy : policies) {
+        ThreadPool pool;
+        ASSERT_EQ(RC_SUCCESS, pool.Init(2, policy));
+        ASSERT_TRUE(SyncWait(RunsOnOtherThread(&pool, pthread_self())));
+        ASSERT_EQ(100 * 99 / 2 + 100, SyncWait(SumOnPool(&pool, 100)));
+    }
+}
+
+static Task<void> Throw() {
+    throw std::runtime_error("test");
+    co_return;
+}
+
+TEST(CoroutineTest, exception) {
+    ASSERT_THROW(SyncWait(Throw()), std::runtime_error);
+}
+
+static Task<void> Increase(ThreadPool* pool, std::atomic<uint32_t>* counter) {
+    co_await Schedule(pool);
+    counter->fetch_add(1);
+}
+
+TEST(CoroutineTest, spawn) {
+    ThreadPool pool;
+    ASSERT_EQ(RC_SUCCESS, pool.Init(4, ThreadPool::SCHED_WORK_STEALING));
+
+    const uint32_t n = 1000;
+    std::atomic<uint32_t> counter(0);
+    for (uint32_t i = 0; i < n; ++i) {
+        Spawn(&pool, Increase(&pool, &counter));
+    }
+    while (counter.load() < n) {
+        std::this_thread::yield();
+    }
+}
+
+static Task<void> Consume(ThreadPool* pool, AsyncQueue<int>* queue, uint32_t n, std::atomic<uint64_t>* sum,
+                          std::atomic<uint32_t>* consumed) {
+    for (uint32_t i = 0; i < n; ++i) {
+        sum->fetch_add(co_await queue->Pop(pool));
+    }
+    consumed->fetch_add(n);
+}
+
+TEST(CoroutineTest, async_queue) {
+    ThreadPool pool;
+    ASSERT_EQ(RC_SUCCESS, pool.Init(4, ThreadPool::SCHED_WORK_STEALING));
+
+    const uint32_t consumer_num = 4;
+    const uint32_t item_num = 10000;
+    AsyncQueue<int> queue;
+    std::atomic<uint64_t> sum(0);
+    std::atomic<uint32_t> consumed(0);
+    for (uint32_t i = 0; i < consumer_num; ++i) {
+        Spawn(&pool, Consume(&pool, &queue, item_num / consumer_num, &sum, &consumed));
+    }
+
+    std::vector<std::thread> producers;
+    for (uint32_t i = 0; i < 2; ++i) {
+        producers.emplace_back([&queue, i]() {
+            for (uint32_t j = i; j < item_num; j += 2) {
+                queue.Push(j);
+            }
+        });
+    }
+    for (auto t = producers.begin(); t != producers.end(); ++t) {
+        t->join();
+    }
+
+    while (consumed.load() < item_num) {
+        std::this_thread::yield();
+    }
+    ASSERT_EQ((uint64_t)item_num * (item_num - 1) / 2, sum.load());
+    ASSERT_EQ(0, queue.Size());
+}
+
+static Task<void> WaitFlag(ThreadPool* pool, AsyncEventCount* ec, std::atomic<bool>* flag,
+                           std::atomic<uint32_t>* woken) {
+    co_await ec->Wait(pool, [flag]() -> bool {
+        return flag->load();
+    });
+    woken->fetch_add(1);
+}
+
+TEST(CoroutineTest, async_event_count) {
+    ThreadPool pool;
+    ASSERT_EQ(RC_SUCCESS, pool.Init(2, ThreadPool::SCHED_WORK_STEALING));
+
+    const uint32_t waiter_num = 16;
+    AsyncEventCount ec;
+    std::atomic<bool> flag(false);
+    std::atomic<uint32_t> woken(0);
+    for (uint32_t i = 0; i < waiter_num; ++i) {
+        Spawn(&pool, WaitFlag(&pool, &ec, &flag, &woken));
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ASSERT_EQ(0, woken.load());
+
+    flag.store(true);
+    ec.NotifyAll();
+    while (woken.load() < waiter_num) {
+        std::this_thread::yield();
+    }
+}
+
+TEST(CoroutineTest, frame_allocator) {
+    auto p = CoroutineFrameAllocator::Alloc(100);
+    CoroutineFrameAllocator::Free(p, 100);
+    // recycled by the same size class
+    auto q = CoroutineFrameAllocator::Alloc(128);
+    ASSERT_EQ(p, q);
+    CoroutineFrameAllocator::Free(q, 128);
+
+    auto big = CoroutineFrameAllocator::Alloc(CoroutineFrameAllocator::MAX_SIZE + 1);
+    ASSERT_NE(nullptr, big);
+    CoroutineFrameAllocator::Free(big, CoroutineFrameAllocator::MAX_SIZE + 1);
+}
+
+#endif
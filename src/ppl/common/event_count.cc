@@ -17,6 +17,7 @@
 
 #include "event_count.h"
 #include "futex_wrapper.h"
+#include <chrono>
 using namespace std;
 
 // based on https://github.com/facebook/folly/blob/main/folly/experimental/EventCount.h
@@ -41,7 +42,8 @@ static inline uint32_t* GetEpochAddr(uint64_t* v) {
 #define WAITER_MASK ((uint64_t)0xffffffff)
 
 EventCount::Key EventCount::PrepareWait() {
-    uint64_t prev = val_.fetch_add(ONE_WAITER, std::memory_order_acq_rel);
+    // seq_cst pairs with the fence in `NotifyOneIfWaiting()`
+    uint64_t prev = val_.fetch_add(ONE_WAITER, std::memory_order_seq_cst);
     return (prev >> EPOCH_SHIFT);
 }
 
@@ -56,7 +58,11 @@ void EventCount::CancelWait() {
 void EventCount::CommitWait(EventCount::Key v) {
     volatile uint32_t* epoch = GetEpochAddr(reinterpret_cast<uint64_t*>(&val_));
     while (*epoch == v) {
-        FutexWait(const_cast<uint32_t*>(epoch), v);
+        if (process_shared_) {
+            FutexWaitShared(const_cast<uint32_t*>(epoch), v);
+        } else {
+            FutexWait(const_cast<uint32_t*>(epoch), v);
+        }
     }
     /*
       the faster #waiters gets to 0, the less likely it is that we'll do spurious wakeups
@@ -65,17 +71,65 @@ void EventCount::CommitWait(EventCount::Key v) {
     val_.fetch_sub(ONE_WAITER, std::memory_order_seq_cst);
 }
 
+bool EventCount::CommitWait(EventCount::Key v, uint64_t timeout_us) {
+    const auto deadline = chrono::steady_clock::now() + chrono::microseconds(timeout_us);
+    volatile uint32_t* epoch = GetEpochAddr(reinterpret_cast<uint64_t*>(&val_));
+    while (*epoch == v) {
+        const auto now = chrono::steady_clock::now();
+        if (now >= deadline) {
+            break;
+        }
+        const uint64_t remaining_us = chrono::duration_cast<chrono::microseconds>(deadline - now).count() + 1;
+        if (process_shared_) {
+            FutexWaitShared(const_cast<uint32_t*>(epoch), v, remaining_us);
+        } else {
+            FutexWait(const_cast<uint32_t*>(epoch), v, remaining_us);
+        }
+    }
+    const bool notified = (*epoch != v);
+    val_.fetch_sub(ONE_WAITER, std::memory_order_seq_cst);
+    return notified;
+}
+
 void EventCount::NotifyOne() {
     auto prev = val_.fetch_add(ONE_EPOCH, std::memory_order_acq_rel);
     if (prev & WAITER_MASK) {
-        FutexWakeOne(GetEpochAddr(reinterpret_cast<uint64_t*>(&val_)));
+        auto epoch = GetEpochAddr(reinterpret_cast<uint64_t*>(&val_));
+        if (process_shared_) {
+            FutexWakeOneShared(epoch);
+        } else {
+            FutexWakeOne(epoch);
+        }
+    }
+}
+
+void EventCount::NotifyOneIfWaiting() {
+    /*
+      either the waiter sees the state change after `PrepareWait()`, or we see the waiter here.
+      a fence is much cheaper than a read-modify-write on a cache line shared by all threads.
+    */
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (val_.load(std::memory_order_relaxed) & WAITER_MASK) {
+        NotifyOne();
+    }
+}
+
+void EventCount::NotifyAllIfWaiting() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (val_.load(std::memory_order_relaxed) & WAITER_MASK) {
+        NotifyAll();
     }
 }
 
 void EventCount::NotifyAll() {
     auto prev = val_.fetch_add(ONE_EPOCH, std::memory_order_acq_rel);
     if (prev & WAITER_MASK) {
-        FutexWakeAll(GetEpochAddr(reinterpret_cast<uint64_t*>(&val_)));
+        auto epoch = GetEpochAddr(reinterpret_cast<uint64_t*>(&val_));
+        if (process_shared_) {
+            FutexWakeAllShared(epoch);
+        } else {
+            FutexWakeAll(epoch);
+        }
     }
 }
 
@@ -30,15 +30,28 @@ public:
     typedef uint32_t Key;
 
 public:
-    EventCount() : val_(0) {
+    /**
+       `process_shared` MUST be true if the event count is placed in memory shared among processes,
+       e.g. by `Mmap::InitShared()`.
+    */
+    explicit EventCount(bool process_shared = false) : val_(0), process_shared_(process_shared) {
         static_assert(sizeof(val_) == sizeof(uint64_t), "atomic size mismatch");
     }
 
     Key PrepareWait();
     void CancelWait();
     void CommitWait(Key);
+    /** returns false if it is not notified within `timeout_us` */
+    bool CommitWait(Key, uint64_t timeout_us);
     void NotifyOne();
     void NotifyAll();
+    /**
+       same as `NotifyOne()`, but skips the atomic read-modify-write on the shared counter if there are no waiters.
+       the state change that waiters check MUST be done before calling this function.
+    */
+    void NotifyOneIfWaiting();
+    /** the `NotifyAll()` counterpart of `NotifyOneIfWaiting()` */
+    void NotifyAllIfWaiting();
 
     template <typename Predicate>
     void Wait(Predicate&& stop_waiting) {
@@ -59,6 +72,7 @@ public:
 private:
     // the epoch in the most significant 32 bits and the waiter count in the least significant 32 bits
     std::atomic<uint64_t> val_;
+    const bool process_shared_;
 
 private:
     EventCount(const EventCount&) = delete;
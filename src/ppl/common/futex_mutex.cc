@@ -0,0 +1,200 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "futex_mutex.h"
+#include "futex_wrapper.h"
+#include "cpu_relax.h"
+
+namespace ppl { namespace common {
+
+static constexpr uint32_t SPIN_COUNT = 100;
+
+static inline uint32_t* GetFutexAddr(std::atomic<uint32_t>* v) {
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "atomic size mismatch");
+    return reinterpret_cast<uint32_t*>(v);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void FutexMutex::LockContended() {
+    // spins for a while in case the holder releases it soon
+    for (uint32_t i = 0; i < SPIN_COUNT; ++i) {
+        CpuRelax();
+        uint32_t c = state_.load(std::memory_order_relaxed);
+        if (c == UNLOCKED &&
+            state_.compare_exchange_weak(c, LOCKED, std::memory_order_acquire, std::memory_order_relaxed)) {
+            return;
+        }
+        if (c == CONTENDED) {
+            break;
+        }
+    }
+
+    // marks the lock as contended so that the holder will wake us up
+    while (state_.exchange(CONTENDED, std::memory_order_acquire) != UNLOCKED) {
+        FutexWait(GetFutexAddr(&state_), CONTENDED);
+    }
+}
+
+void FutexMutex::UnlockContended() {
+    state_.store(UNLOCKED, std::memory_order_release);
+    FutexWakeOne(GetFutexAddr(&state_));
+}
+
+/* -------------------------------------------------------------------------- */
+
+template <typename Predicate>
+static uint32_t SpinUntil(std::atomic<uint32_t>* state, Predicate&& f) {
+    uint32_t s = state->load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < SPIN_COUNT && !f(s); ++i) {
+        CpuRelax();
+        s = state->load(std::memory_order_relaxed);
+    }
+    return s;
+}
+
+void FutexSharedMutex::ReadLockContended() {
+    auto spin_read = [this]() -> uint32_t {
+        return SpinUntil(&state_, [](uint32_t s) -> bool {
+            return ((s & MASK) != WRITE_LOCKED || (s & (READERS_WAITING | WRITERS_WAITING)) != 0);
+        });
+    };
+
+    uint32_t state = spin_read();
+    while (true) {
+        if (IsReadLockable(state)) {
+            if (state_.compare_exchange_weak(state, state + 1, std::memory_order_acquire,
+                                             std::memory_order_relaxed)) {
+                return;
+            }
+            continue;
+        }
+
+        if ((state & READERS_WAITING) == 0) {
+            if (!state_.compare_exchange_weak(state, state | READERS_WAITING, std::memory_order_relaxed)) {
+                continue;
+            }
+        }
+
+        FutexWait(GetFutexAddr(&state_), state | READERS_WAITING);
+        state = spin_read();
+    }
+}
+
+void FutexSharedMutex::WriteLockContended() {
+    auto spin_write = [this]() -> uint32_t {
+        return SpinUntil(&state_, [](uint32_t s) -> bool {
+            return ((s & MASK) == 0 || (s & WRITERS_WAITING) != 0);
+        });
+    };
+
+    uint32_t state = spin_write();
+    /*
+      once this writer has waited, it cannot tell whether other writers are waiting, so it keeps
+      `WRITERS_WAITING` when acquiring the lock. the worst case is a spurious wakeup on unlocking.
+    */
+    uint32_t other_writers_waiting = 0;
+    while (true) {
+        if ((state & MASK) == 0) {
+            if (state_.compare_exchange_weak(state, state | WRITE_LOCKED | other_writers_waiting,
+                                             std::memory_order_acquire, std::memory_order_relaxed)) {
+                return;
+            }
+            continue;
+        }
+
+        if ((state & WRITERS_WAITING) == 0) {
+            if (!state_.compare_exchange_weak(state, state | WRITERS_WAITING, std::memory_order_relaxed)) {
+                continue;
+            }
+        }
+        other_writers_waiting = WRITERS_WAITING;
+
+        // seq_cst pairs with `WakeWriter()`: either it sees this writer, or this writer sees the flag cleared
+        writers_sleeping_.fetch_add(1, std::memory_order_seq_cst);
+        const uint32_t seq = writer_notify_.load(std::memory_order_seq_cst);
+        state = state_.load(std::memory_order_seq_cst);
+        if ((state & MASK) == 0 || (state & WRITERS_WAITING) == 0) {
+            writers_sleeping_.fetch_sub(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        FutexWait(GetFutexAddr(&writer_notify_), seq);
+        writers_sleeping_.fetch_sub(1, std::memory_order_relaxed);
+        state = spin_write();
+    }
+}
+
+void FutexSharedMutex::ReadUnlock() {
+    const uint32_t state = state_.fetch_sub(1, std::memory_order_release) - 1;
+    // readers waiting with no writer waiting is impossible, because they would have taken the lock
+    if ((state & MASK) == 0 && (state & WRITERS_WAITING) != 0) {
+        WakeWriterOrReaders(state);
+    }
+}
+
+void FutexSharedMutex::WriteUnlock() {
+    const uint32_t state = state_.fetch_sub(WRITE_LOCKED, std::memory_order_release) - WRITE_LOCKED;
+    if ((state & (READERS_WAITING | WRITERS_WAITING)) != 0) {
+        WakeWriterOrReaders(state);
+    }
+}
+
+/** `state` MUST be unlocked. writers are woken up before readers. */
+void FutexSharedMutex::WakeWriterOrReaders(uint32_t state) {
+    if (state == WRITERS_WAITING) {
+        if (state_.compare_exchange_strong(state, 0, std::memory_order_seq_cst)) {
+            WakeWriter();
+            return;
+        }
+    }
+
+    if (state == (READERS_WAITING | WRITERS_WAITING)) {
+        if (!state_.compare_exchange_strong(state, READERS_WAITING, std::memory_order_seq_cst)) {
+            // the lock is taken by someone else, who will wake up waiters on unlocking
+            return;
+        }
+        // readers stay asleep until the writer unlocks
+        if (WakeWriter()) {
+            return;
+        }
+        // `WRITERS_WAITING` was left by a writer that has acquired the lock, and no writer is waiting now
+        state = READERS_WAITING;
+    }
+
+    if (state == READERS_WAITING) {
+        if (state_.compare_exchange_strong(state, 0, std::memory_order_relaxed)) {
+            FutexWakeAll(GetFutexAddr(&state_));
+        }
+    }
+}
+
+/**
+   returns false if no writer is in `WriteLockContended()`. otherwise the writer will take the lock, either
+   woken up here or by seeing `WRITERS_WAITING` cleared before sleeping.
+*/
+bool FutexSharedMutex::WakeWriter() {
+    writer_notify_.fetch_add(1, std::memory_order_seq_cst);
+    if (writers_sleeping_.load(std::memory_order_seq_cst) == 0) {
+        return false;
+    }
+    FutexWakeOne(GetFutexAddr(&writer_notify_));
+    return true;
+}
+
+}} // namespace ppl::common
@@ -0,0 +1,172 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#ifndef _ST_HPC_PPL_COMMON_FUTEX_MUTEX_H_
+#define _ST_HPC_PPL_COMMON_FUTEX_MUTEX_H_
+
+#include <stdint.h>
+#include <atomic>
+
+namespace ppl { namespace common {
+
+/**
+   a mutex built on futexes, implementing the `LockType` interface used by `ReadLockGuard`/`WriteLockGuard`.
+   `ReadLock()` is the same as `WriteLock()`.
+   based on "mutex2" in Ulrich Drepper, Futexes Are Tricky.
+*/
+
+class FutexMutex final {
+public:
+    FutexMutex() : state_(UNLOCKED) {}
+
+    void WriteLock() {
+        uint32_t c = UNLOCKED;
+        if (!state_.compare_exchange_strong(c, LOCKED, std::memory_order_acquire, std::memory_order_relaxed)) {
+            LockContended();
+        }
+    }
+
+    void ReadLock() {
+        WriteLock();
+    }
+
+    bool TryLock() {
+        uint32_t c = UNLOCKED;
+        return state_.compare_exchange_strong(c, LOCKED, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    void Unlock() {
+        if (state_.fetch_sub(1, std::memory_order_release) != LOCKED) {
+            UnlockContended();
+        }
+    }
+
+private:
+    void LockContended();
+    void UnlockContended();
+
+private:
+    static constexpr uint32_t UNLOCKED = 0;
+    static constexpr uint32_t LOCKED = 1;
+    static constexpr uint32_t CONTENDED = 2; // locked, and there may be waiters
+
+    std::atomic<uint32_t> state_;
+
+private:
+    FutexMutex(const FutexMutex&) = delete;
+    FutexMutex(FutexMutex&&) = delete;
+    void operator=(const FutexMutex&) = delete;
+    void operator=(FutexMutex&&) = delete;
+};
+
+/**
+   a writer-preferring reader-writer lock built on futexes, implementing the `LockType` interface used by
+   `ReadLockGuard`/`WriteLockGuard`. the reader count and waiting flags are kept in one 32-bit word, and
+   waiting writers sleep on another word so that they can be woken up without waking readers.
+   new readers are blocked once a writer is waiting.
+   based on the futex rwlock in the rust standard library.
+*/
+
+class FutexSharedMutex final {
+public:
+    FutexSharedMutex() : state_(0), writer_notify_(0), writers_sleeping_(0) {}
+
+    void ReadLock() {
+        uint32_t state = state_.load(std::memory_order_relaxed);
+        if (!IsReadLockable(state) ||
+            !state_.compare_exchange_weak(state, state + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+            ReadLockContended();
+        }
+    }
+
+    void WriteLock() {
+        uint32_t state = 0;
+        if (!state_.compare_exchange_weak(state, WRITE_LOCKED, std::memory_order_acquire,
+                                          std::memory_order_relaxed)) {
+            WriteLockContended();
+        }
+    }
+
+    bool TryReadLock() {
+        uint32_t state = state_.load(std::memory_order_relaxed);
+        while (IsReadLockable(state)) {
+            if (state_.compare_exchange_weak(state, state + 1, std::memory_order_acquire,
+                                             std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool TryWriteLock() {
+        uint32_t state = state_.load(std::memory_order_relaxed);
+        while ((state & MASK) == 0) {
+            if (state_.compare_exchange_weak(state, state | WRITE_LOCKED, std::memory_order_acquire,
+                                             std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /** releases either a read lock or the write lock held by the caller */
+    void Unlock() {
+        if ((state_.load(std::memory_order_relaxed) & MASK) == WRITE_LOCKED) {
+            WriteUnlock();
+        } else {
+            ReadUnlock();
+        }
+    }
+
+private:
+    static bool IsReadLockable(uint32_t state) {
+        // readers wait if a writer holds or waits for the lock
+        return ((state & MASK) < MAX_READERS && (state & (READERS_WAITING | WRITERS_WAITING)) == 0);
+    }
+
+    void ReadLockContended();
+    void WriteLockContended();
+    void ReadUnlock();
+    void WriteUnlock();
+    void WakeWriterOrReaders(uint32_t state);
+    bool WakeWriter();
+
+private:
+    /** number of readers, or `WRITE_LOCKED` */
+    static constexpr uint32_t MASK = (1u << 30) - 1;
+    static constexpr uint32_t WRITE_LOCKED = MASK;
+    static constexpr uint32_t MAX_READERS = MASK - 1;
+    static constexpr uint32_t READERS_WAITING = 1u << 30;
+    static constexpr uint32_t WRITERS_WAITING = 1u << 31;
+
+    std::atomic<uint32_t> state_;
+    /** bumped each time a writer is woken up */
+    std::atomic<uint32_t> writer_notify_;
+    /** number of writers that may sleep on `writer_notify_` */
+    std::atomic<uint32_t> writers_sleeping_;
+
+private:
+    FutexSharedMutex(const FutexSharedMutex&) = delete;
+    FutexSharedMutex(FutexSharedMutex&&) = delete;
+    void operator=(const FutexSharedMutex&) = delete;
+    void operator=(FutexSharedMutex&&) = delete;
+};
+
+}} // namespace ppl::common
+
+#endif
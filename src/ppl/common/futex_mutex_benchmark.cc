@@ -0,0 +1,124 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "ppl/common/futex_mutex.h"
+#include "ppl/common/lock_utils.h"
+#include <benchmark/benchmark.h>
+#include <thread>
+#include <vector>
+
+#ifdef _MSC_VER
+#include "ppl/common/windows/pthread.h"
+#else
+#include <pthread.h>
+#endif
+
+using namespace std;
+using namespace ppl::common;
+
+class PthreadMutex final {
+public:
+    PthreadMutex() {
+        pthread_mutex_init(&mutex_, nullptr);
+    }
+    ~PthreadMutex() {
+        pthread_mutex_destroy(&mutex_);
+    }
+    void ReadLock() {
+        pthread_mutex_lock(&mutex_);
+    }
+    void WriteLock() {
+        pthread_mutex_lock(&mutex_);
+    }
+    void Unlock() {
+        pthread_mutex_unlock(&mutex_);
+    }
+
+private:
+    pthread_mutex_t mutex_;
+};
+
+#ifndef _MSC_VER
+class PthreadRWLock final {
+public:
+    PthreadRWLock() {
+        pthread_rwlock_init(&lock_, nullptr);
+    }
+    ~PthreadRWLock() {
+        pthread_rwlock_destroy(&lock_);
+    }
+    void ReadLock() {
+        pthread_rwlock_rdlock(&lock_);
+    }
+    void WriteLock() {
+        pthread_rwlock_wrlock(&lock_);
+    }
+    void Unlock() {
+        pthread_rwlock_unlock(&lock_);
+    }
+
+private:
+    pthread_rwlock_t lock_;
+};
+#endif
+
+static constexpr uint32_t OP_NUM = 1 << 18;
+static constexpr uint32_t TABLE_SIZE = 64;
+
+/**
+   `state.range(0)` threads look up a small table, and one in `state.range(1)` operations updates it.
+   ops are split among threads, so items/s is comparable across thread counts.
+*/
+template <typename LockType>
+static void BM_ReadHeavy(benchmark::State& state) {
+    const uint32_t thread_num = state.range(0);
+    const uint32_t write_interval = state.range(1);
+    for (auto _ : state) {
+        LockType lock;
+        vector<uint64_t> table(TABLE_SIZE, 0);
+        vector<thread> threads;
+        for (uint32_t i = 0; i < thread_num; ++i) {
+            threads.emplace_back([&lock, &table, i, thread_num, write_interval]() {
+                uint64_t sum = 0;
+                for (uint32_t j = i; j < OP_NUM; j += thread_num) {
+                    if (j % write_interval == 0) {
+                        WriteLockGuard<LockType> guard(&lock);
+                        ++table[j % TABLE_SIZE];
+                    } else {
+                        ReadLockGuard<LockType> guard(&lock);
+                        sum += table[j % TABLE_SIZE];
+                    }
+                }
+                benchmark::DoNotOptimize(sum);
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * OP_NUM);
+}
+
+#define READ_HEAVY_ARGS ArgsProduct({{1, 2, 4, 8}, {10, 100}})->UseRealTime()
+
+BENCHMARK_TEMPLATE(BM_ReadHeavy, PthreadMutex)->READ_HEAVY_ARGS;
+BENCHMARK_TEMPLATE(BM_ReadHeavy, FutexMutex)->READ_HEAVY_ARGS;
+#ifndef _MSC_VER
+BENCHMARK_TEMPLATE(BM_ReadHeavy, PthreadRWLock)->READ_HEAVY_ARGS;
+#endif
+BENCHMARK_TEMPLATE(BM_ReadHeavy, FutexSharedMutex)->READ_HEAVY_ARGS;
@@ -0,0 +1,145 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "ppl/common/futex_mutex.h"
+#include "ppl/common/lock_utils.h"
+#include "ppl/common/object_pool.h"
+#include "gtest/gtest.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+using namespace std;
+using namespace ppl::common;
+
+TEST(FutexMutexTest, try_lock) {
+    FutexMutex m;
+    ASSERT_TRUE(m.TryLock());
+    ASSERT_FALSE(m.TryLock());
+    m.Unlock();
+    ASSERT_TRUE(m.TryLock());
+    m.Unlock();
+}
+
+TEST(FutexMutexTest, counter) {
+    const uint32_t thread_num = 8;
+    const uint32_t n = 20000;
+    FutexMutex m;
+    uint64_t counter = 0;
+
+    vector<thread> threads;
+    for (uint32_t i = 0; i < thread_num; ++i) {
+        threads.emplace_back([&m, &counter, n]() {
+            for (uint32_t j = 0; j < n; ++j) {
+                WriteLockGuard<FutexMutex> guard(&m);
+                ++counter;
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    ASSERT_EQ((uint64_t)thread_num * n, counter);
+}
+
+TEST(FutexMutexTest, object_pool) {
+    ObjectPool<int, FutexMutex> pool;
+    auto p = pool.Alloc(5);
+    ASSERT_NE(nullptr, p);
+    ASSERT_EQ(5, *p);
+    pool.Free(p);
+}
+
+TEST(FutexSharedMutexTest, try_lock) {
+    FutexSharedMutex m;
+    ASSERT_TRUE(m.TryReadLock());
+    ASSERT_TRUE(m.TryReadLock());
+    ASSERT_FALSE(m.TryWriteLock());
+    m.Unlock();
+    m.Unlock();
+
+    ASSERT_TRUE(m.TryWriteLock());
+    ASSERT_FALSE(m.TryReadLock());
+    ASSERT_FALSE(m.TryWriteLock());
+    m.Unlock();
+    ASSERT_TRUE(m.TryReadLock());
+    m.Unlock();
+}
+
+TEST(FutexSharedMutexTest, writer_preferring) {
+    FutexSharedMutex m;
+    m.ReadLock();
+
+    atomic<bool> locked(false);
+    thread writer([&m, &locked]() {
+        m.WriteLock();
+        locked.store(true);
+        m.Unlock();
+    });
+
+    // a waiting writer blocks new readers
+    while (m.TryReadLock()) {
+        m.Unlock();
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    ASSERT_FALSE(locked.load());
+
+    m.Unlock();
+    writer.join();
+    ASSERT_TRUE(locked.load());
+    ASSERT_TRUE(m.TryReadLock());
+    m.Unlock();
+}
+
+TEST(FutexSharedMutexTest, readers_writers) {
+    const uint32_t reader_num = 6;
+    const uint32_t writer_num = 2;
+    const uint32_t n = 20000;
+    FutexSharedMutex m;
+    // always equal when observed under the lock
+    uint64_t a = 0, b = 0;
+    atomic<uint32_t> nr_error(0);
+
+    vector<thread> threads;
+    for (uint32_t i = 0; i < writer_num; ++i) {
+        threads.emplace_back([&m, &a, &b, n]() {
+            for (uint32_t j = 0; j < n; ++j) {
+                WriteLockGuard<FutexSharedMutex> guard(&m);
+                ++a;
+                ++b;
+            }
+        });
+    }
+    for (uint32_t i = 0; i < reader_num; ++i) {
+        threads.emplace_back([&m, &a, &b, &nr_error, n]() {
+            for (uint32_t j = 0; j < n; ++j) {
+                ReadLockGuard<FutexSharedMutex> guard(&m);
+                if (a != b) {
+                    nr_error.fetch_add(1);
+                }
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    ASSERT_EQ(0u, nr_error.load());
+    ASSERT_EQ((uint64_t)writer_num * n, a);
+    ASSERT_EQ((uint64_t)writer_num * n, b);
+}
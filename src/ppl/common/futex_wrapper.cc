@@ -17,6 +17,11 @@
 
 #include "futex_wrapper.h"
 
+#ifndef _MSC_VER
+#include <cerrno> // errno
+#include <ctime> // struct timespec
+#endif
+
 namespace ppl { namespace common {
 
 #ifdef _MSC_VER
@@ -27,6 +32,14 @@ void FutexWait(uint32_t* addr, uint32_t value) {
     WaitOnAddress(addr, &value, sizeof(uint32_t), INFINITE);
 }
 
+bool FutexWait(uint32_t* addr, uint32_t value, uint64_t timeout_us) {
+    const DWORD timeout_ms = (DWORD)((timeout_us + 999) / 1000);
+    if (!WaitOnAddress(addr, &value, sizeof(uint32_t), timeout_ms)) {
+        return (GetLastError() != ERROR_TIMEOUT);
+    }
+    return true;
+}
+
 void FutexWakeOne(uint32_t* addr) {
     WakeByAddressSingle(addr);
 }
@@ -35,6 +48,22 @@ void FutexWakeAll(uint32_t* addr) {
     WakeByAddressAll(addr);
 }
 
+void FutexWaitShared(uint32_t* addr, uint32_t value) {
+    FutexWait(addr, value);
+}
+
+bool FutexWaitShared(uint32_t* addr, uint32_t value, uint64_t timeout_us) {
+    return FutexWait(addr, value, timeout_us);
+}
+
+void FutexWakeOneShared(uint32_t* addr) {
+    FutexWakeOne(addr);
+}
+
+void FutexWakeAllShared(uint32_t* addr) {
+    FutexWakeAll(addr);
+}
+
 #else
 
 #include <linux/futex.h>
@@ -48,6 +77,15 @@ void FutexWait(uint32_t* addr, uint32_t value) {
 	syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, value, nullptr, nullptr, 0);
 }
 
+bool FutexWait(uint32_t* addr, uint32_t value, uint64_t timeout_us) {
+	struct timespec ts;
+	ts.tv_sec = timeout_us / 1000000;
+	ts.tv_nsec = (timeout_us % 1000000) * 1000;
+	// the timeout of FUTEX_WAIT is relative
+	auto ret = syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, value, &ts, nullptr, 0);
+	return !(ret == -1 && errno == ETIMEDOUT);
+}
+
 void FutexWakeOne(uint32_t* addr) {
 	syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
 }
@@ -56,6 +94,26 @@ void FutexWakeAll(uint32_t* addr) {
 	syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
 }
 
+void FutexWaitShared(uint32_t* addr, uint32_t value) {
+	syscall(SYS_futex, addr, FUTEX_WAIT, value, nullptr, nullptr, 0);
+}
+
+bool FutexWaitShared(uint32_t* addr, uint32_t value, uint64_t timeout_us) {
+	struct timespec ts;
+	ts.tv_sec = timeout_us / 1000000;
+	ts.tv_nsec = (timeout_us % 1000000) * 1000;
+	auto ret = syscall(SYS_futex, addr, FUTEX_WAIT, value, &ts, nullptr, 0);
+	return !(ret == -1 && errno == ETIMEDOUT);
+}
+
+void FutexWakeOneShared(uint32_t* addr) {
+	syscall(SYS_futex, addr, FUTEX_WAKE, 1, nullptr, nullptr, 0);
+}
+
+void FutexWakeAllShared(uint32_t* addr) {
+	syscall(SYS_futex, addr, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
 #endif
 
 }}
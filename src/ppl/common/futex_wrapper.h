@@ -23,9 +23,20 @@
 namespace ppl { namespace common {
 
 void FutexWait(uint32_t*, uint32_t);
+/** returns false if `timeout_us` expires. may return true spuriously. */
+bool FutexWait(uint32_t*, uint32_t, uint64_t timeout_us);
 void FutexWakeOne(uint32_t*);
 void FutexWakeAll(uint32_t*);
 
+/**
+   versions of the functions above for futexes in memory shared among processes, e.g. by `Mmap::InitShared()`.
+   on windows they are the same as the ones above, which work within a process only.
+*/
+void FutexWaitShared(uint32_t*, uint32_t);
+bool FutexWaitShared(uint32_t*, uint32_t, uint64_t timeout_us);
+void FutexWakeOneShared(uint32_t*);
+void FutexWakeAllShared(uint32_t*);
+
 }}
 
 #endif
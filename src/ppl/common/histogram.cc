@@ -0,0 +1,69 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "ppl/common/histogram.h"
+using namespace std;
+
+namespace ppl { namespace common {
+
+uint64_t HistogramSnapshot::GetPercentile(double p) const {
+    if (count == 0) {
+        return 0;
+    }
+
+    uint64_t rank = (uint64_t)(p * count);
+    if (rank >= count) {
+        rank = count - 1;
+    }
+
+    uint64_t accumulated = 0;
+    for (uint32_t i = 0; i < BUCKET_NUM; ++i) {
+        accumulated += buckets[i];
+        if (accumulated > rank) {
+            if (i == 0) {
+                return 0;
+            }
+            const uint64_t upper = (i == 64) ? UINT64_MAX : (((uint64_t)1 << i) - 1);
+            return (upper < max) ? upper : max;
+        }
+    }
+    return max;
+}
+
+void HistogramSnapshot::Merge(const HistogramSnapshot& other) {
+    count += other.count;
+    sum += other.sum;
+    if (other.max > max) {
+        max = other.max;
+    }
+    for (uint32_t i = 0; i < BUCKET_NUM; ++i) {
+        buckets[i] += other.buckets[i];
+    }
+}
+
+void LogHistogram::GetSnapshot(HistogramSnapshot* snapshot) const {
+    snapshot->count = 0;
+    for (uint32_t i = 0; i < HistogramSnapshot::BUCKET_NUM; ++i) {
+        snapshot->buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+        // keeps `count` consistent with buckets
+        snapshot->count += snapshot->buckets[i];
+    }
+    snapshot->sum = sum_.load(std::memory_order_relaxed);
+    snapshot->max = max_.load(std::memory_order_relaxed);
+}
+
+}} // namespace ppl::common
@@ -0,0 +1,105 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef _ST_HPC_PPL_COMMON_HISTOGRAM_H_
+#define _ST_HPC_PPL_COMMON_HISTOGRAM_H_
+
+#include <stdint.h>
+#include <atomic>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace ppl { namespace common {
+
+/** a snapshot of `LogHistogram`. bucket 0 holds value 0, and bucket i (i > 0) holds values in [2^(i-1), 2^i). */
+struct HistogramSnapshot final {
+    static constexpr uint32_t BUCKET_NUM = 65;
+
+    HistogramSnapshot() : count(0), sum(0), max(0) {
+        for (uint32_t i = 0; i < BUCKET_NUM; ++i) {
+            buckets[i] = 0;
+        }
+    }
+
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+    uint64_t buckets[BUCKET_NUM];
+
+    double GetMean() const {
+        return (count > 0) ? ((double)sum / count) : 0;
+    }
+    /** returns the upper bound of the bucket where the `p`-th (0 <= p <= 1) quantile lies */
+    uint64_t GetPercentile(double p) const;
+    /** accumulates another snapshot, e.g. to merge stats of threads */
+    void Merge(const HistogramSnapshot&);
+};
+
+/**
+   a lock-free histogram with log2 buckets. `Record()` MUST be called by one thread, while
+   `GetSnapshot()` can be called by any thread at any time and returns approximate values.
+*/
+class LogHistogram final {
+public:
+    LogHistogram() : sum_(0), max_(0) {
+        for (uint32_t i = 0; i < HistogramSnapshot::BUCKET_NUM; ++i) {
+            buckets_[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    /** no read-modify-write operations because there is only one writer */
+    void Record(uint64_t value) {
+        auto bucket = &buckets_[GetBucketIndex(value)];
+        bucket->store(bucket->load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        sum_.store(sum_.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        if (value > max_.load(std::memory_order_relaxed)) {
+            max_.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    void GetSnapshot(HistogramSnapshot*) const;
+
+    static uint32_t GetBucketIndex(uint64_t value) {
+        if (value == 0) {
+            return 0;
+        }
+#ifdef _MSC_VER
+        unsigned long idx;
+        _BitScanReverse64(&idx, value);
+        return idx + 1;
+#else
+        return 64 - __builtin_clzll(value);
+#endif
+    }
+
+private:
+    std::atomic<uint64_t> sum_;
+    std::atomic<uint64_t> max_;
+    std::atomic<uint64_t> buckets_[HistogramSnapshot::BUCKET_NUM];
+
+private:
+    LogHistogram(const LogHistogram&) = delete;
+    LogHistogram(LogHistogram&&) = delete;
+    void operator=(const LogHistogram&) = delete;
+    void operator=(LogHistogram&&) = delete;
+};
+
+}} // namespace ppl::common
+
+#endif
@@ -0,0 +1,60 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "ppl/common/histogram.h"
+#include "gtest/gtest.h"
+using namespace std;
+using namespace ppl::common;
+
+TEST(HistogramTest, bucket_index) {
+    EXPECT_EQ(0u, LogHistogram::GetBucketIndex(0));
+    EXPECT_EQ(1u, LogHistogram::GetBucketIndex(1));
+    EXPECT_EQ(2u, LogHistogram::GetBucketIndex(2));
+    EXPECT_EQ(2u, LogHistogram::GetBucketIndex(3));
+    EXPECT_EQ(3u, LogHistogram::GetBucketIndex(4));
+    EXPECT_EQ(11u, LogHistogram::GetBucketIndex(1024));
+    EXPECT_EQ(64u, LogHistogram::GetBucketIndex(UINT64_MAX));
+}
+
+TEST(HistogramTest, snapshot) {
+    LogHistogram h;
+    for (uint64_t i = 1; i <= 100; ++i) {
+        h.Record(i);
+    }
+
+    HistogramSnapshot s;
+    h.GetSnapshot(&s);
+    EXPECT_EQ(100u, s.count);
+    EXPECT_EQ(5050u, s.sum);
+    EXPECT_EQ(100u, s.max);
+    EXPECT_DOUBLE_EQ(50.5, s.GetMean());
+    // 50th value is 50, in bucket [32, 64)
+    EXPECT_EQ(63u, s.GetPercentile(0.5));
+    // capped by max
+    EXPECT_EQ(100u, s.GetPercentile(0.99));
+    EXPECT_EQ(1u, s.GetPercentile(0));
+
+    HistogramSnapshot merged;
+    merged.Merge(s);
+    merged.Merge(s);
+    EXPECT_EQ(200u, merged.count);
+    // 2 and 3
+    EXPECT_EQ(4u, merged.buckets[2]);
+    EXPECT_EQ(100u, merged.max);
+
+    EXPECT_EQ(0u, HistogramSnapshot().GetPercentile(0.5));
+}
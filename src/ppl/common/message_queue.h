@@ -1,48 +1,189 @@
 #ifndef _ST_HPC_PPL_COMMON_MESSAGE_QUEUE_H_
 #define _ST_HPC_PPL_COMMON_MESSAGE_QUEUE_H_
 
-#include <list>
-
-#ifdef _MSC_VER
-#include "ppl/common/windows/pthread.h"
-#else
-#include <pthread.h>
-#endif
+#include <stdint.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
 
 namespace ppl { namespace common {
 
+/**
+   a blocking queue protected by a mutex. items are kept in a ring buffer which grows on demand, so no memory is
+   allocated for each item once the buffer is large enough.
+*/
+
 template <typename T>
 class MessageQueue final {
 public:
-    MessageQueue() {
-        pthread_mutex_init(&mutex_, nullptr);
-        pthread_cond_init(&cond_, nullptr);
-    }
+    /** @param capacity max number of items, after which `Push()` blocks. 0 means unlimited. */
+    MessageQueue(size_t capacity = 0) : items_(nullptr), mask_(0), head_(0), size_(0), capacity_(capacity) {}
+
     ~MessageQueue() {
-        pthread_cond_destroy(&cond_);
-        pthread_mutex_destroy(&mutex_);
+        for (size_t i = 0; i < size_; ++i) {
+            items_[(head_ + i) & mask_].~T();
+        }
+        ::operator delete(items_);
     }
-    void Push(const T& item) {
-        pthread_mutex_lock(&mutex_);
-        items_.push_back(item);
-        pthread_cond_signal(&cond_);
-        pthread_mutex_unlock(&mutex_);
+
+    /** blocks while the queue is full */
+    template <typename ItemType>
+    void Push(ItemType&& item) {
+        std::unique_lock<std::mutex> lck(mutex_);
+        if (capacity_ > 0) {
+            not_full_.wait(lck, [this]() -> bool {
+                return (size_ < capacity_);
+            });
+        }
+        DoPush(std::forward<ItemType>(item));
+        lck.unlock();
+        not_empty_.notify_one();
+    }
+
+    /** returns false if the queue is full */
+    template <typename ItemType>
+    bool TryPush(ItemType&& item) {
+        std::unique_lock<std::mutex> lck(mutex_);
+        if (capacity_ > 0 && size_ >= capacity_) {
+            return false;
+        }
+        DoPush(std::forward<ItemType>(item));
+        lck.unlock();
+        not_empty_.notify_one();
+        return true;
     }
+
+    /** blocks until an item is available */
     T Pop() {
-        pthread_mutex_lock(&mutex_);
-        while (items_.empty()) {
-            pthread_cond_wait(&cond_, &mutex_);
+        std::unique_lock<std::mutex> lck(mutex_);
+        not_empty_.wait(lck, [this]() -> bool {
+            return (size_ > 0);
+        });
+        T item(DoPop());
+        lck.unlock();
+        NotifyNotFull(1);
+        return item;
+    }
+
+    /** returns false if the queue is empty */
+    bool TryPop(T* item) {
+        std::unique_lock<std::mutex> lck(mutex_);
+        if (size_ == 0) {
+            return false;
+        }
+        *item = DoPop();
+        lck.unlock();
+        NotifyNotFull(1);
+        return true;
+    }
+
+    /** returns false if no item is available within `timeout_us` */
+    bool Pop(T* item, uint64_t timeout_us) {
+        std::unique_lock<std::mutex> lck(mutex_);
+        if (!not_empty_.wait_for(lck, std::chrono::microseconds(timeout_us), [this]() -> bool {
+                return (size_ > 0);
+            })) {
+            return false;
+        }
+        *item = DoPop();
+        lck.unlock();
+        NotifyNotFull(1);
+        return true;
+    }
+
+    /**
+       @brief blocks until an item is available, then moves up to `max_num` items to the end of `items` while the
+       lock is held once. returns the number of items popped.
+    */
+    size_t PopBatch(std::vector<T>* items, size_t max_num) {
+        if (max_num == 0) {
+            return 0;
+        }
+
+        std::unique_lock<std::mutex> lck(mutex_);
+        not_empty_.wait(lck, [this]() -> bool {
+            return (size_ > 0);
+        });
+        const size_t n = (size_ < max_num) ? size_ : max_num;
+        items->reserve(items->size() + n);
+        for (size_t i = 0; i < n; ++i) {
+            items->push_back(DoPop());
+        }
+        lck.unlock();
+        NotifyNotFull(n);
+        return n;
+    }
+
+    size_t Size() {
+        std::lock_guard<std::mutex> lck(mutex_);
+        return size_;
+    }
+
+    /** 0 means unlimited */
+    size_t GetCapacity() const {
+        return capacity_;
+    }
+
+private:
+    template <typename ItemType>
+    void DoPush(ItemType&& item) {
+        if (size_ == mask_ + 1 || !items_) {
+            Grow();
         }
-        auto item = items_.front();
-        items_.pop_front();
-        pthread_mutex_unlock(&mutex_);
+        new (&items_[(head_ + size_) & mask_]) T(std::forward<ItemType>(item));
+        ++size_;
+    }
+
+    T DoPop() {
+        T* slot = &items_[head_];
+        T item(std::move(*slot));
+        slot->~T();
+        head_ = (head_ + 1) & mask_;
+        --size_;
         return item;
     }
 
+    /** doubles the buffer. items are moved to the beginning of the new one. */
+    void Grow() {
+        const size_t old_size = items_ ? (mask_ + 1) : 0;
+        const size_t new_size = items_ ? (old_size << 1) : INIT_BUFFER_SIZE;
+        T* new_items = static_cast<T*>(::operator new(new_size * sizeof(T)));
+        for (size_t i = 0; i < size_; ++i) {
+            T* slot = &items_[(head_ + i) & mask_];
+            new (&new_items[i]) T(std::move(*slot));
+            slot->~T();
+        }
+        ::operator delete(items_);
+        items_ = new_items;
+        mask_ = new_size - 1;
+        head_ = 0;
+    }
+
+    void NotifyNotFull(size_t n) {
+        if (capacity_ > 0) {
+            if (n == 1) {
+                not_full_.notify_one();
+            } else {
+                not_full_.notify_all();
+            }
+        }
+    }
+
 private:
-    pthread_mutex_t mutex_;
-    pthread_cond_t cond_;
-    std::list<T> items_;
+    static constexpr size_t INIT_BUFFER_SIZE = 16;
+
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    T* items_;
+    size_t mask_;
+    size_t head_;
+    size_t size_;
+    const size_t capacity_;
 
 private:
     MessageQueue(const MessageQueue&) = delete;
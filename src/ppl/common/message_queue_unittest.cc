@@ -1,5 +1,9 @@
 #include "ppl/common/message_queue.h"
 #include "gtest/gtest.h"
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
 using namespace ppl::common;
 
 TEST(MessageQueueTest, all) {
@@ -9,3 +13,148 @@ TEST(MessageQueueTest, all) {
     ASSERT_EQ(1, mq.Pop());
     ASSERT_EQ(5, mq.Pop());
 }
+
+TEST(MessageQueueTest, grow) {
+    MessageQueue<int> mq;
+    // wrap around before growing
+    for (int i = 0; i < 10; ++i) {
+        mq.Push(i);
+    }
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_EQ(i, mq.Pop());
+    }
+    for (int i = 0; i < 1000; ++i) {
+        mq.Push(i);
+    }
+    ASSERT_EQ(1000u, mq.Size());
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_EQ(i, mq.Pop());
+    }
+    ASSERT_EQ(0u, mq.Size());
+}
+
+TEST(MessageQueueTest, move_only) {
+    MessageQueue<std::unique_ptr<int>> mq;
+    for (int i = 0; i < 100; ++i) {
+        mq.Push(std::unique_ptr<int>(new int(i)));
+    }
+    for (int i = 0; i < 50; ++i) {
+        auto item = mq.Pop();
+        ASSERT_EQ(i, *item);
+    }
+    // the rest are released in destructor
+}
+
+TEST(MessageQueueTest, try_pop_and_timeout) {
+    MessageQueue<int> mq;
+    int value = 0;
+    ASSERT_FALSE(mq.TryPop(&value));
+    ASSERT_FALSE(mq.Pop(&value, 1000));
+
+    mq.Push(3);
+    ASSERT_TRUE(mq.TryPop(&value));
+    ASSERT_EQ(3, value);
+
+    std::thread producer([&mq]() -> void {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        mq.Push(7);
+    });
+    ASSERT_TRUE(mq.Pop(&value, 10000000));
+    ASSERT_EQ(7, value);
+    producer.join();
+}
+
+TEST(MessageQueueTest, pop_batch) {
+    MessageQueue<int> mq;
+    for (int i = 0; i < 10; ++i) {
+        mq.Push(i);
+    }
+
+    std::vector<int> items;
+    ASSERT_EQ(0u, mq.PopBatch(&items, 0));
+    ASSERT_EQ(4u, mq.PopBatch(&items, 4));
+    ASSERT_EQ(6u, mq.PopBatch(&items, 100));
+    ASSERT_EQ(10u, items.size());
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_EQ(i, items[i]);
+    }
+    ASSERT_EQ(0u, mq.Size());
+}
+
+TEST(MessageQueueTest, bounded) {
+    MessageQueue<int> mq(4);
+    ASSERT_EQ(4u, mq.GetCapacity());
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(mq.TryPush(i));
+    }
+    ASSERT_FALSE(mq.TryPush(4));
+
+    std::atomic<bool> pushed(false);
+    std::thread producer([&mq, &pushed]() -> void {
+        mq.Push(4);
+        pushed.store(true);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ASSERT_FALSE(pushed.load());
+    ASSERT_EQ(0, mq.Pop());
+    producer.join();
+    ASSERT_TRUE(pushed.load());
+    ASSERT_EQ(4u, mq.Size());
+}
+
+TEST(MessageQueueTest, producers_consumers) {
+    static constexpr int PRODUCER_NUM = 4;
+    static constexpr int CONSUMER_NUM = 4;
+    static constexpr int ITEM_NUM = 10000;
+
+    MessageQueue<int> mq(64);
+    std::atomic<int64_t> sum(0);
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCER_NUM; ++p) {
+        producers.emplace_back([&mq]() -> void {
+            for (int i = 1; i <= ITEM_NUM; ++i) {
+                mq.Push(i);
+            }
+        });
+    }
+
+    std::vector<std::thread> consumers;
+    for (int c = 0; c < CONSUMER_NUM; ++c) {
+        consumers.emplace_back([&mq, &sum]() -> void {
+            std::vector<int> items;
+            while (true) {
+                items.clear();
+                mq.PopBatch(&items, 16);
+                int nr_stop = 0;
+                for (auto x = items.begin(); x != items.end(); ++x) {
+                    if (*x == 0) {
+                        ++nr_stop;
+                    } else {
+                        sum.fetch_add(*x);
+                    }
+                }
+                if (nr_stop > 0) {
+                    // give back stop signals that belong to other consumers
+                    for (int i = 1; i < nr_stop; ++i) {
+                        mq.Push(0);
+                    }
+                    return;
+                }
+            }
+        });
+    }
+
+    for (auto t = producers.begin(); t != producers.end(); ++t) {
+        t->join();
+    }
+    for (int c = 0; c < CONSUMER_NUM; ++c) {
+        mq.Push(0);
+    }
+    for (auto t = consumers.begin(); t != consumers.end(); ++t) {
+        t->join();
+    }
+
+    ASSERT_EQ((int64_t)PRODUCER_NUM * ITEM_NUM * (ITEM_NUM + 1) / 2, sum.load());
+    ASSERT_EQ(0u, mq.Size());
+}
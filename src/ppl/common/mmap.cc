@@ -20,8 +20,12 @@
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <sys/syscall.h> // SYS_memfd_create
 #include <fcntl.h>
 #include <errno.h>
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 1U
+#endif
 #endif //! non windows
 #include <cstring>
 #include <cstdlib>
@@ -136,6 +140,78 @@ RetCode Mmap::Init(uint64_t size) {
     return RC_SUCCESS;
 }
 
+#ifdef _MSC_VER
+RetCode Mmap::InitShared(const char*, uint64_t) {
+    LOG(ERROR) << "shared mapping is not supported on windows.";
+    return RC_UNSUPPORTED;
+}
+#else
+RetCode Mmap::InitShared(const char* filename, uint64_t size) {
+    if (start_) {
+        LOG(ERROR) << "duplicated init.";
+        return RC_UNSUPPORTED;
+    }
+
+    int fd;
+    if (filename) {
+        fd = (size > 0) ? open(filename, O_RDWR | O_CREAT | O_CLOEXEC, 0600) : open(filename, O_RDWR | O_CLOEXEC);
+        if (fd < 0) {
+            LOG(ERROR) << "open file [" << filename << "] failed: " << strerror(errno);
+            return RC_OTHER_ERROR;
+        }
+    } else {
+#ifdef SYS_memfd_create
+        fd = syscall(SYS_memfd_create, "pplcommon", MFD_CLOEXEC);
+        if (fd < 0) {
+            LOG(ERROR) << "memfd_create failed: " << strerror(errno);
+            return RC_OTHER_ERROR;
+        }
+#else
+        LOG(ERROR) << "memfd_create is not supported.";
+        return RC_UNSUPPORTED;
+#endif
+    }
+
+    {
+        struct stat file_stat_info;
+        memset(&file_stat_info, 0, sizeof(file_stat_info));
+        if (fstat(fd, &file_stat_info) < 0) {
+            LOG(ERROR) << "get stat of shared file failed: " << strerror(errno);
+            goto errout;
+        }
+
+        const uint64_t file_size = file_stat_info.st_size;
+        if (size == 0) {
+            size = file_size;
+            if (size == 0) {
+                LOG(ERROR) << "size of shared file is 0.";
+                goto errout;
+            }
+        } else if (file_size < size) {
+            if (ftruncate(fd, size) < 0) {
+                LOG(ERROR) << "resize shared file to [" << size << "] failed: " << strerror(errno);
+                goto errout;
+            }
+        }
+    }
+
+    base_ = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base_ != MAP_FAILED) {
+        fd_ = fd;
+        start_ = base_;
+        size_ = size;
+        permission_ = READ | WRITE;
+        return RC_SUCCESS;
+    }
+    base_ = nullptr;
+    LOG(ERROR) << "mmap shared file with size [" << size << "] failed: " << strerror(errno);
+
+errout:
+    close(fd);
+    return RC_OTHER_ERROR;
+}
+#endif
+
 #ifdef _MSC_VER
 RetCode Mmap::Init(const char* filename, uint32_t permission, uint64_t offset, uint64_t length) {
     if (start_) {
@@ -51,6 +51,14 @@ public:
                               uint64_t length = UINT64_MAX);
     /** @brief allocate a memory area of `size` */
     ppl::common::RetCode Init(uint64_t size);
+    /**
+       @brief maps `size` bytes of `filename` for reading and writing, and changes are shared with other processes
+       mapping the same file, e.g. a file in /dev/shm. the file is created if it does not exist, and is extended to
+       `size` if it is smaller. if `size` is 0, the file MUST exist and is mapped as a whole.
+       if `filename` is nullptr, an anonymous file is created by memfd, which is shared with child processes by
+       fork(). not supported on windows.
+    */
+    ppl::common::RetCode InitShared(const char* filename, uint64_t size);
     char* GetData() {
         return static_cast<char*>(start_);
     }
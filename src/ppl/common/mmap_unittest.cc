@@ -17,6 +17,10 @@
 
 #include "gtest/gtest.h"
 #include "ppl/common/mmap.h"
+#ifndef _MSC_VER
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 using namespace ppl::common;
 
 TEST(MmapTest, init) {
@@ -54,3 +58,24 @@ TEST(MmapTest, mem_mode) {
     EXPECT_EQ(value, *(uint32_t*)mm.GetData());
     EXPECT_EQ(sizeof(value), mm.GetSize());
 }
+
+#ifndef _MSC_VER
+TEST(MmapTest, shared) {
+    Mmap mm;
+    EXPECT_EQ(RC_SUCCESS, mm.InitShared(nullptr, 4096));
+    EXPECT_EQ(4096u, mm.GetSize());
+    auto data = (volatile uint32_t*)mm.GetData();
+    data[0] = 0;
+
+    // changes of the child are visible to the parent
+    const pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+        data[0] = 12345;
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    EXPECT_EQ(12345u, data[0]);
+}
+#endif
@@ -0,0 +1,266 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef _ST_HPC_PPL_COMMON_MPMC_RING_BUFFER_H_
+#define _ST_HPC_PPL_COMMON_MPMC_RING_BUFFER_H_
+
+#include "ppl/common/event_count.h"
+#include "ppl/common/retcode.h"
+#include "ppl/common/sys.h"
+#include <stdint.h>
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace ppl { namespace common {
+
+/**
+   a lock-free bounded ring buffer queue implementation for multi-producer-multi-consumer
+   based on
+     - https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+*/
+
+template <typename T>
+class MPMCRingBuffer final {
+public:
+    MPMCRingBuffer() : tail_(0), head_(0), cells_(nullptr), mask_(0) {}
+
+    ~MPMCRingBuffer() {
+        if (!cells_) {
+            return;
+        }
+        const auto tail = tail_.load(std::memory_order_relaxed);
+        for (auto pos = head_.load(std::memory_order_relaxed); pos != tail; ++pos) {
+            reinterpret_cast<T*>(&cells_[pos & mask_].storage)->~T();
+        }
+        AlignedFree(cells_);
+    }
+
+    /** must be called once before other functions. `size` is rounded up to a power of 2. */
+    ppl::common::RetCode Init(size_t size) {
+        size_t capacity = 2;
+        while (capacity < size) {
+            capacity <<= 1;
+        }
+
+        cells_ = static_cast<Cell*>(AlignedAlloc(capacity * sizeof(Cell), CACHELINE_SIZE));
+        if (!cells_) {
+            return ppl::common::RC_OUT_OF_MEMORY;
+        }
+        for (size_t i = 0; i < capacity; ++i) {
+            new (&cells_[i]) Cell();
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        mask_ = capacity - 1;
+        return ppl::common::RC_SUCCESS;
+    }
+
+    /** `item` is left untouched if the queue is full. */
+    template <typename ItemType>
+    bool Push(ItemType&& item) {
+        Cell* cell;
+        auto pos = tail_.load(std::memory_order_relaxed);
+        while (true) {
+            cell = &cells_[pos & mask_];
+            const auto seq = cell->sequence.load(std::memory_order_acquire);
+            const auto diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false; // full
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+
+        new (&cell->storage) T(std::forward<ItemType>(item));
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    template <typename ItemType>
+    bool Pop(ItemType* item) {
+        Cell* cell;
+        auto pos = head_.load(std::memory_order_relaxed);
+        while (true) {
+            cell = &cells_[pos & mask_];
+            const auto seq = cell->sequence.load(std::memory_order_acquire);
+            const auto diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false; // empty
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+
+        auto data = reinterpret_cast<T*>(&cell->storage);
+        *item = std::move(*data);
+        data->~T();
+        cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+    // approximate
+    bool IsEmpty() const {
+        return (head_.load(std::memory_order_relaxed) >= tail_.load(std::memory_order_relaxed));
+    }
+
+    // approximate
+    size_t Size() const {
+        const auto head = head_.load(std::memory_order_relaxed);
+        const auto tail = tail_.load(std::memory_order_relaxed);
+        return (tail > head) ? (tail - head) : 0;
+    }
+
+    size_t GetCapacity() const {
+        return mask_ + 1;
+    }
+
+private:
+    // l1 cache line size for most CPUs
+    static constexpr int CACHELINE_SIZE = 64;
+
+    struct Cell final {
+        std::atomic<size_t> sequence;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+        // each cell occupies its own cache line(s)
+        char padding[CACHELINE_SIZE - (sizeof(std::atomic<size_t>) + sizeof(storage)) % CACHELINE_SIZE];
+    };
+
+    union {
+        std::atomic<size_t> tail_;
+        char padding1[CACHELINE_SIZE];
+    };
+    union {
+        std::atomic<size_t> head_;
+        char padding2[CACHELINE_SIZE];
+    };
+    Cell* cells_;
+    size_t mask_;
+
+private:
+    MPMCRingBuffer(const MPMCRingBuffer&) = delete;
+    MPMCRingBuffer(MPMCRingBuffer&&) = delete;
+    void operator=(const MPMCRingBuffer&) = delete;
+    void operator=(MPMCRingBuffer&&) = delete;
+};
+
+/** a wrapper of `MPMCRingBuffer` in which `Push()` blocks if the queue is full and `Pop()` blocks if it is empty. */
+
+template <typename T>
+class BlockingMPMCQueue final {
+public:
+    BlockingMPMCQueue() {}
+
+    /** @see `MPMCRingBuffer::Init()` */
+    ppl::common::RetCode Init(size_t size) {
+        return ring_.Init(size);
+    }
+
+    template <typename ItemType>
+    void Push(ItemType&& item) {
+        if (!SpinFor([this, &item]() -> bool {
+                return ring_.Push(std::forward<ItemType>(item));
+            })) {
+            not_full_.Wait([this, &item]() -> bool {
+                return ring_.Push(std::forward<ItemType>(item));
+            });
+        }
+        not_empty_.NotifyOne();
+    }
+
+    template <typename ItemType>
+    void Pop(ItemType* item) {
+        if (!SpinFor([this, item]() -> bool {
+                return ring_.Pop(item);
+            })) {
+            not_empty_.Wait([this, item]() -> bool {
+                return ring_.Pop(item);
+            });
+        }
+        not_full_.NotifyOne();
+    }
+
+    template <typename ItemType>
+    bool TryPush(ItemType&& item) {
+        if (ring_.Push(std::forward<ItemType>(item))) {
+            not_empty_.NotifyOne();
+            return true;
+        }
+        return false;
+    }
+
+    template <typename ItemType>
+    bool TryPop(ItemType* item) {
+        if (ring_.Pop(item)) {
+            not_full_.NotifyOne();
+            return true;
+        }
+        return false;
+    }
+
+    bool IsEmpty() const {
+        return ring_.IsEmpty();
+    }
+
+    size_t Size() const {
+        return ring_.Size();
+    }
+
+    size_t GetCapacity() const {
+        return ring_.GetCapacity();
+    }
+
+private:
+    /** retries `f` for a while before falling back to futex waiting */
+    template <typename Func>
+    static bool SpinFor(Func&& f) {
+        for (uint32_t i = 0; i < SPIN_COUNT; ++i) {
+            if (f()) {
+                return true;
+            }
+            std::this_thread::yield();
+        }
+        return false;
+    }
+
+private:
+    static constexpr uint32_t SPIN_COUNT = 64;
+
+    MPMCRingBuffer<T> ring_;
+    EventCount not_empty_;
+    EventCount not_full_;
+
+private:
+    BlockingMPMCQueue(const BlockingMPMCQueue&) = delete;
+    BlockingMPMCQueue(BlockingMPMCQueue&&) = delete;
+    void operator=(const BlockingMPMCQueue&) = delete;
+    void operator=(BlockingMPMCQueue&&) = delete;
+};
+
+}} // namespace ppl::common
+
+#endif
@@ -0,0 +1,98 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "ppl/common/mpmc_ring_buffer.h"
+#include "ppl/common/message_queue.h"
+#include <benchmark/benchmark.h>
+#include <thread>
+#include <vector>
+using namespace std;
+using namespace ppl::common;
+
+static constexpr uint32_t ITEM_NUM = 1 << 16;
+
+/*
+  `nr_producers` threads push ITEM_NUM items in total and `nr_consumers` threads pop them.
+  consumers exit when they receive 0.
+*/
+template <typename QueueType>
+static void RunProducersConsumers(QueueType* queue, uint32_t nr_producers, uint32_t nr_consumers) {
+    vector<thread> producers, consumers;
+    for (uint32_t i = 0; i < nr_consumers; ++i) {
+        consumers.emplace_back([queue]() {
+            while (true) {
+                uint32_t value;
+                queue->Pop(&value);
+                if (value == 0) {
+                    break;
+                }
+                benchmark::DoNotOptimize(value);
+            }
+        });
+    }
+    for (uint32_t i = 0; i < nr_producers; ++i) {
+        producers.emplace_back([queue, nr_producers]() {
+            for (uint32_t j = 0; j < ITEM_NUM / nr_producers; ++j) {
+                queue->Push(j + 1);
+            }
+        });
+    }
+
+    for (auto t = producers.begin(); t != producers.end(); ++t) {
+        t->join();
+    }
+    for (uint32_t i = 0; i < nr_consumers; ++i) {
+        queue->Push(0);
+    }
+    for (auto t = consumers.begin(); t != consumers.end(); ++t) {
+        t->join();
+    }
+}
+
+/* adapts the `T Pop()` interface of MessageQueue */
+class MessageQueueAdapter final {
+public:
+    void Push(uint32_t value) {
+        mq_.Push(value);
+    }
+    void Pop(uint32_t* value) {
+        *value = mq_.Pop();
+    }
+
+private:
+    MessageQueue<uint32_t> mq_;
+};
+
+static void BM_MessageQueue(benchmark::State& state) {
+    MessageQueueAdapter queue;
+    for (auto _ : state) {
+        RunProducersConsumers(&queue, state.range(0), state.range(1));
+    }
+    state.SetItemsProcessed(state.iterations() * ITEM_NUM);
+}
+
+static void BM_BlockingMPMCQueue(benchmark::State& state) {
+    BlockingMPMCQueue<uint32_t> queue;
+    queue.Init(4096);
+    for (auto _ : state) {
+        RunProducersConsumers(&queue, state.range(0), state.range(1));
+    }
+    state.SetItemsProcessed(state.iterations() * ITEM_NUM);
+}
+
+BENCHMARK(BM_MessageQueue)->RangeMultiplier(2)->Ranges({{1, 16}, {1, 16}})->UseRealTime();
+BENCHMARK(BM_BlockingMPMCQueue)->RangeMultiplier(2)->Ranges({{1, 16}, {1, 16}})->UseRealTime();
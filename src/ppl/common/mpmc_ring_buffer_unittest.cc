@@ -0,0 +1,103 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "ppl/common/mpmc_ring_buffer.h"
+#include "gtest/gtest.h"
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace ppl::common;
+
+TEST(MPMCRingBufferTest, empty_full) {
+    MPMCRingBuffer<int> queue;
+    ASSERT_EQ(RC_SUCCESS, queue.Init(5));
+    ASSERT_EQ(8, queue.GetCapacity());
+    ASSERT_TRUE(queue.IsEmpty());
+
+    for (int i = 0; i < 8; ++i) {
+        ASSERT_TRUE(queue.Push(i));
+    }
+    ASSERT_FALSE(queue.Push(8));
+
+    int value;
+    for (int i = 0; i < 8; ++i) {
+        ASSERT_TRUE(queue.Pop(&value));
+        ASSERT_EQ(i, value);
+    }
+    ASSERT_FALSE(queue.Pop(&value));
+    ASSERT_TRUE(queue.IsEmpty());
+}
+
+TEST(MPMCRingBufferTest, move_only) {
+    MPMCRingBuffer<std::unique_ptr<int>> queue;
+    ASSERT_EQ(RC_SUCCESS, queue.Init(4));
+    std::unique_ptr<int> item(new int(5));
+    ASSERT_TRUE(queue.Push(std::move(item)));
+    ASSERT_TRUE(queue.Push(std::unique_ptr<int>(new int(6)))); // released in destructor
+
+    std::unique_ptr<int> res;
+    ASSERT_TRUE(queue.Pop(&res));
+    ASSERT_EQ(5, *res);
+}
+
+TEST(MPMCRingBufferTest, blocking_mpmc) {
+    const int nr_producers = 3;
+    const int nr_consumers = 3;
+    const int n = 10000;
+
+    BlockingMPMCQueue<int> queue;
+    ASSERT_EQ(RC_SUCCESS, queue.Init(64));
+    std::vector<std::thread> threads;
+    std::vector<int64_t> sums(nr_consumers, 0);
+
+    for (int i = 0; i < nr_producers; ++i) {
+        threads.emplace_back([&queue, n]() {
+            for (int j = 1; j <= n; ++j) {
+                queue.Push(j);
+            }
+        });
+    }
+    for (int i = 0; i < nr_consumers; ++i) {
+        threads.emplace_back([&queue, &sums, i]() {
+            while (true) {
+                int value;
+                queue.Pop(&value);
+                if (value == 0) {
+                    break;
+                }
+                sums[i] += value;
+            }
+        });
+    }
+
+    for (int i = 0; i < nr_producers; ++i) {
+        threads[i].join();
+    }
+    for (int i = 0; i < nr_consumers; ++i) {
+        queue.Push(0);
+    }
+    for (int i = nr_producers; i < nr_producers + nr_consumers; ++i) {
+        threads[i].join();
+    }
+
+    int64_t total = 0;
+    for (int i = 0; i < nr_consumers; ++i) {
+        total += sums[i];
+    }
+    ASSERT_EQ((int64_t)nr_producers * n * (n + 1) / 2, total);
+}
@@ -0,0 +1,132 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "ppl/common/numa.h"
+#include "ppl/common/log.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#ifdef _MSC_VER
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace ppl { namespace common {
+
+RetCode ParseCpuList(const char* str, vector<uint32_t>* res) {
+    res->clear();
+
+    const char* p = str;
+    while (*p) {
+        if (*p == ',' || *p == ' ' || *p == '\n') {
+            ++p;
+            continue;
+        }
+
+        char* end;
+        const unsigned long first = strtoul(p, &end, 10);
+        if (end == p) {
+            return RC_INVALID_VALUE;
+        }
+        p = end;
+
+        unsigned long last = first;
+        if (*p == '-') {
+            ++p;
+            last = strtoul(p, &end, 10);
+            if (end == p || last < first) {
+                return RC_INVALID_VALUE;
+            }
+            p = end;
+        }
+
+        for (unsigned long i = first; i <= last; ++i) {
+            res->push_back(i);
+        }
+    }
+
+    return RC_SUCCESS;
+}
+
+static RetCode ReadCpuListFile(const string& filename, vector<uint32_t>* res) {
+    auto fp = fopen(filename.c_str(), "r");
+    if (!fp) {
+        return RC_NOT_FOUND;
+    }
+
+    char buf[4096];
+    auto len = fread(buf, 1, sizeof(buf) - 1, fp);
+    fclose(fp);
+    buf[len] = '\0';
+
+    return ParseCpuList(buf, res);
+}
+
+RetCode GetNumaTopology(vector<NumaNode>* nodes, const char* sysfs_root) {
+    nodes->clear();
+
+    const string node_dir = string(sysfs_root) + "/devices/system/node";
+
+    vector<uint32_t> node_ids;
+    auto rc = ReadCpuListFile(node_dir + "/online", &node_ids);
+    if (rc == RC_SUCCESS) {
+        for (auto id = node_ids.begin(); id != node_ids.end(); ++id) {
+            NumaNode node;
+            node.id = *id;
+            rc = ReadCpuListFile(node_dir + "/node" + ToString(*id) + "/cpulist", &node.cpus);
+            if (rc != RC_SUCCESS) {
+                LOG(ERROR) << "read cpulist of numa node [" << *id << "] failed: " << GetRetCodeStr(rc);
+                nodes->clear();
+                return rc;
+            }
+            // memory-only nodes have no cpus
+            if (!node.cpus.empty()) {
+                nodes->push_back(node);
+            }
+        }
+        if (!nodes->empty()) {
+            return RC_SUCCESS;
+        }
+    }
+
+    // fallback: a single node with all online cpus
+    NumaNode node;
+    node.id = 0;
+    rc = ReadCpuListFile(string(sysfs_root) + "/devices/system/cpu/online", &node.cpus);
+    if (rc != RC_SUCCESS || node.cpus.empty()) {
+#ifdef _MSC_VER
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        const uint32_t cpu_core_num = info.dwNumberOfProcessors;
+#else
+        const uint32_t cpu_core_num = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+        node.cpus.clear();
+        for (uint32_t i = 0; i < cpu_core_num; ++i) {
+            node.cpus.push_back(i);
+        }
+    }
+    nodes->push_back(node);
+
+    return RC_SUCCESS;
+}
+
+}} // namespace ppl::common
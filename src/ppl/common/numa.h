@@ -0,0 +1,42 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef _ST_HPC_PPL_COMMON_NUMA_H_
+#define _ST_HPC_PPL_COMMON_NUMA_H_
+
+#include "ppl/common/retcode.h"
+#include <vector>
+
+namespace ppl { namespace common {
+
+struct NumaNode final {
+    uint32_t id;
+    std::vector<uint32_t> cpus;
+};
+
+/**
+   @brief reads online numa nodes and their cpus from `<sysfs_root>/devices/system/node`.
+   if numa info is not available, all online cpus are put into node 0.
+*/
+ppl::common::RetCode GetNumaTopology(std::vector<NumaNode>* nodes, const char* sysfs_root = "/sys");
+
+/** @brief parses cpu/node list strings like "0-3,8,10-11" */
+ppl::common::RetCode ParseCpuList(const char* str, std::vector<uint32_t>* res);
+
+}} // namespace ppl::common
+
+#endif
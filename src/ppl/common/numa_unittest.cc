@@ -0,0 +1,94 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "ppl/common/numa.h"
+#include "gtest/gtest.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace ppl::common;
+
+TEST(NumaTest, parse_cpu_list) {
+    vector<uint32_t> cpus;
+    ASSERT_EQ(RC_SUCCESS, ParseCpuList("0-3,8,10-11\n", &cpus));
+    const vector<uint32_t> expected = {0, 1, 2, 3, 8, 10, 11};
+    ASSERT_EQ(expected, cpus);
+
+    ASSERT_EQ(RC_SUCCESS, ParseCpuList("", &cpus));
+    ASSERT_TRUE(cpus.empty());
+    ASSERT_NE(RC_SUCCESS, ParseCpuList("3-1", &cpus));
+    ASSERT_NE(RC_SUCCESS, ParseCpuList("a", &cpus));
+}
+
+#ifndef _MSC_VER
+
+static void WriteFile(const string& filename, const char* content) {
+    auto fp = fopen(filename.c_str(), "w");
+    ASSERT_NE(nullptr, fp);
+    fputs(content, fp);
+    fclose(fp);
+}
+
+TEST(NumaTest, fake_topology) {
+    char root[] = "/tmp/pplcommon_numa_XXXXXX";
+    ASSERT_NE(nullptr, mkdtemp(root));
+
+    const string root_str(root);
+    const string node_dir = root_str + "/devices/system/node";
+    mkdir((root_str + "/devices").c_str(), 0755);
+    mkdir((root_str + "/devices/system").c_str(), 0755);
+    mkdir(node_dir.c_str(), 0755);
+    mkdir((node_dir + "/node0").c_str(), 0755);
+    mkdir((node_dir + "/node1").c_str(), 0755);
+    mkdir((node_dir + "/node2").c_str(), 0755);
+    WriteFile(node_dir + "/online", "0-2\n");
+    WriteFile(node_dir + "/node0/cpulist", "0-1,4\n");
+    WriteFile(node_dir + "/node1/cpulist", "2-3\n");
+    WriteFile(node_dir + "/node2/cpulist", "\n"); // memory-only node
+
+    vector<NumaNode> nodes;
+    ASSERT_EQ(RC_SUCCESS, GetNumaTopology(&nodes, root));
+    ASSERT_EQ(2, nodes.size());
+    ASSERT_EQ(0, nodes[0].id);
+    ASSERT_EQ(vector<uint32_t>({0, 1, 4}), nodes[0].cpus);
+    ASSERT_EQ(1, nodes[1].id);
+    ASSERT_EQ(vector<uint32_t>({2, 3}), nodes[1].cpus);
+
+    unlink((node_dir + "/online").c_str());
+    unlink((node_dir + "/node0/cpulist").c_str());
+    unlink((node_dir + "/node1/cpulist").c_str());
+    unlink((node_dir + "/node2/cpulist").c_str());
+
+    // falls back to a single node
+    ASSERT_EQ(RC_SUCCESS, GetNumaTopology(&nodes, root));
+    ASSERT_EQ(1, nodes.size());
+    ASSERT_FALSE(nodes[0].cpus.empty());
+
+    rmdir((node_dir + "/node0").c_str());
+    rmdir((node_dir + "/node1").c_str());
+    rmdir((node_dir + "/node2").c_str());
+    rmdir(node_dir.c_str());
+    rmdir((root_str + "/devices/system").c_str());
+    rmdir((root_str + "/devices").c_str());
+    rmdir(root);
+}
+
+#endif
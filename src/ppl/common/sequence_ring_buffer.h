@@ -0,0 +1,334 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#ifndef _ST_HPC_PPL_COMMON_SEQUENCE_RING_BUFFER_H_
+#define _ST_HPC_PPL_COMMON_SEQUENCE_RING_BUFFER_H_
+
+#include "ppl/common/event_count.h"
+#include "ppl/common/cpu_relax.h"
+#include "ppl/common/retcode.h"
+#include <stdint.h>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace ppl { namespace common {
+
+/** how producers and consumers of `SequenceRingBuffer` wait for each other */
+enum SequenceWaitStrategy {
+    /** spins with `CpuRelax()`. lowest latency, but burns a core for each waiting thread. */
+    SEQUENCE_WAIT_BUSY_SPIN,
+    /** spins with `std::this_thread::yield()` */
+    SEQUENCE_WAIT_YIELD,
+    /** spins for a while and then sleeps on an `EventCount` */
+    SEQUENCE_WAIT_BLOCKING,
+};
+
+/**
+   a single-producer-multi-consumer ring buffer in which every consumer sees every item, in the spirit of the
+   LMAX disruptor(https://lmax-exchange.github.io/disruptor/). items stay in preallocated slots and each
+   consumer keeps its own cursor, so an item is written once and read by all consumers without copies.
+
+   a consumer may depend on other consumers, and it sees an item only after all of its dependencies have
+   released it. the producer overwrites a slot only after all consumers have released it, i.e. it is gated by
+   the slowest consumer that no other consumer depends on.
+
+   consumers MUST be added by `AddConsumer()` before the first item is pushed. `Claim()`, `Publish()`,
+   `Push()` and `TryPush()` MUST be called by the producer, and the other functions taking `consumer_id` MUST
+   be called by the owner of the consumer. a typical consumer loop is:
+
+   uint64_t next = rb.GetCursor(id);
+   while (running) {
+       auto end = rb.WaitFor(id, next);
+       for (; next < end; ++next) {
+           Handle(rb.Get(next));
+       }
+       rb.Release(id, end);
+   }
+*/
+
+template <typename T>
+class SequenceRingBuffer final {
+public:
+    /** `size` is rounded up to a power of 2 */
+    SequenceRingBuffer(size_t size, SequenceWaitStrategy wait_strategy = SEQUENCE_WAIT_BLOCKING)
+        : wait_strategy_(wait_strategy), next_(0), gating_cache_(0) {
+        size_t capacity = 2;
+        while (capacity < size) {
+            capacity <<= 1;
+        }
+        vec_.resize(capacity);
+        mask_ = capacity - 1;
+        cursor_.store(0, std::memory_order_relaxed);
+    }
+
+    /**
+       @brief adds a consumer which sees an item only after all consumers in `dependencies` have released it.
+       consumers with no dependencies follow the producer.
+       @param consumer_id id of the new consumer, which is passed to consumer functions
+    */
+    ppl::common::RetCode AddConsumer(const std::vector<uint32_t>& dependencies, uint32_t* consumer_id) {
+        std::unique_ptr<Consumer> consumer(new Consumer());
+        if (dependencies.empty()) {
+            consumer->dependencies.push_back(&cursor_);
+        } else {
+            for (auto x = dependencies.begin(); x != dependencies.end(); ++x) {
+                if (*x >= consumers_.size()) {
+                    return ppl::common::RC_INVALID_VALUE;
+                }
+                consumer->dependencies.push_back(&consumers_[*x]->cursor);
+            }
+            for (auto x = dependencies.begin(); x != dependencies.end(); ++x) {
+                consumers_[*x]->has_dependents = true;
+            }
+        }
+
+        *consumer_id = consumers_.size();
+        consumers_.emplace_back(std::move(consumer));
+
+        gating_.clear();
+        for (auto x = consumers_.begin(); x != consumers_.end(); ++x) {
+            if (!(*x)->has_dependents) {
+                gating_.push_back(&(*x)->cursor);
+            }
+        }
+        return ppl::common::RC_SUCCESS;
+    }
+
+    ppl::common::RetCode AddConsumer(uint32_t* consumer_id) {
+        return AddConsumer(std::vector<uint32_t>(), consumer_id);
+    }
+
+    /* ----------------------------- producer ----------------------------- */
+
+    /**
+       @brief waits until `n` slots are free and returns the sequence of the first one. slots are filled via
+       `Get()` and made visible to consumers by `Publish()`. `n` MUST NOT be greater than `GetCapacity()`.
+    */
+    uint64_t Claim(uint32_t n) {
+        const uint64_t wrap = next_ + n - vec_.size();
+        if (next_ + n > vec_.size() && gating_cache_ < wrap) {
+            Wait(&released_, [this, wrap]() -> bool {
+                gating_cache_ = GetMinGatingCursor();
+                return (gating_cache_ >= wrap);
+            });
+        }
+        return next_;
+    }
+
+    /** like `Claim()`, but returns false instead of waiting if there are less than `n` free slots */
+    bool TryClaim(uint32_t n, uint64_t* seq) {
+        const uint64_t wrap = next_ + n - vec_.size();
+        if (next_ + n > vec_.size() && gating_cache_ < wrap) {
+            gating_cache_ = GetMinGatingCursor();
+            if (gating_cache_ < wrap) {
+                return false;
+            }
+        }
+        *seq = next_;
+        return true;
+    }
+
+    /** publishes `n` slots claimed by `Claim()` or `TryClaim()` */
+    void Publish(uint32_t n) {
+        next_ += n;
+        cursor_.store(next_, std::memory_order_release);
+        if (wait_strategy_ == SEQUENCE_WAIT_BLOCKING) {
+            progress_.NotifyAllIfWaiting();
+        }
+    }
+
+    template <typename ItemType>
+    void Push(ItemType&& item) {
+        vec_[Claim(1) & mask_] = std::forward<ItemType>(item);
+        Publish(1);
+    }
+
+    template <typename ItemType>
+    bool TryPush(ItemType&& item) {
+        uint64_t seq;
+        if (!TryClaim(1, &seq)) {
+            return false;
+        }
+        vec_[seq & mask_] = std::forward<ItemType>(item);
+        Publish(1);
+        return true;
+    }
+
+    /* ----------------------------- consumer ----------------------------- */
+
+    /** returns the sequence of the next item to be consumed by `consumer_id` */
+    uint64_t GetCursor(uint32_t consumer_id) const {
+        return consumers_[consumer_id]->cursor.load(std::memory_order_relaxed);
+    }
+
+    /**
+       @brief waits until the item `seq` is available to `consumer_id`.
+       @return end of the available sequences, which is greater than `seq`
+    */
+    uint64_t WaitFor(uint32_t consumer_id, uint64_t seq) {
+        Consumer* consumer = consumers_[consumer_id].get();
+        if (consumer->available > seq) {
+            return consumer->available;
+        }
+        Wait(&progress_, [this, consumer, seq]() -> bool {
+            consumer->available = GetMinCursor(consumer->dependencies);
+            return (consumer->available > seq);
+        });
+        return consumer->available;
+    }
+
+    /** returns end of the available sequences without waiting */
+    uint64_t GetAvailable(uint32_t consumer_id) {
+        Consumer* consumer = consumers_[consumer_id].get();
+        consumer->available = GetMinCursor(consumer->dependencies);
+        return consumer->available;
+    }
+
+    /** tells that `consumer_id` has done with items before `end` */
+    void Release(uint32_t consumer_id, uint64_t end) {
+        Consumer* consumer = consumers_[consumer_id].get();
+        consumer->cursor.store(end, std::memory_order_release);
+        if (wait_strategy_ == SEQUENCE_WAIT_BLOCKING) {
+            if (consumer->has_dependents) {
+                progress_.NotifyAllIfWaiting();
+            } else {
+                released_.NotifyOneIfWaiting();
+            }
+        }
+    }
+
+    /* ------------------------------------------------------------------ */
+
+    /**
+       returns the slot of `seq`. the producer writes claimed slots, and consumers read available ones. a
+       consumer may modify an item if all other consumers reading it depend on this consumer.
+    */
+    T& Get(uint64_t seq) {
+        return vec_[seq & mask_];
+    }
+
+    const T& Get(uint64_t seq) const {
+        return vec_[seq & mask_];
+    }
+
+    size_t GetCapacity() const {
+        return vec_.size();
+    }
+
+private:
+    // l1 cache line size for most CPUs
+    static constexpr int CACHELINE_SIZE = 64;
+    static constexpr uint32_t SPIN_COUNT = 64;
+
+    struct Consumer final {
+        Consumer() : available(0), has_dependents(false) {
+            cursor.store(0, std::memory_order_relaxed);
+        }
+
+        /** end of sequences released by this consumer */
+        union {
+            std::atomic<uint64_t> cursor;
+            char padding[CACHELINE_SIZE];
+        };
+        // accessed by the owner only
+        uint64_t available;
+        std::vector<const std::atomic<uint64_t>*> dependencies;
+        // set before producing starts
+        bool has_dependents;
+    };
+
+    static uint64_t GetMinCursor(const std::vector<const std::atomic<uint64_t>*>& cursors) {
+        uint64_t res = UINT64_MAX;
+        for (auto x = cursors.begin(); x != cursors.end(); ++x) {
+            const uint64_t c = (*x)->load(std::memory_order_acquire);
+            if (c < res) {
+                res = c;
+            }
+        }
+        return res;
+    }
+
+    uint64_t GetMinGatingCursor() const {
+        if (gating_.empty()) {
+            return next_;
+        }
+        return GetMinCursor(gating_);
+    }
+
+    template <typename Predicate>
+    void Wait(EventCount* ev, Predicate&& ready) {
+        switch (wait_strategy_) {
+            case SEQUENCE_WAIT_BUSY_SPIN:
+                while (!ready()) {
+                    CpuRelax();
+                }
+                break;
+            case SEQUENCE_WAIT_YIELD:
+                while (!ready()) {
+                    std::this_thread::yield();
+                }
+                break;
+            default:
+                for (uint32_t i = 0; i < SPIN_COUNT; ++i) {
+                    if (ready()) {
+                        return;
+                    }
+                    std::this_thread::yield();
+                }
+                ev->Wait(std::forward<Predicate>(ready));
+                break;
+        }
+    }
+
+private:
+    const SequenceWaitStrategy wait_strategy_;
+
+    /** end of published sequences */
+    union {
+        std::atomic<uint64_t> cursor_;
+        char padding1[CACHELINE_SIZE];
+    };
+
+    // accessed by the producer only
+    uint64_t next_;
+    uint64_t gating_cache_;
+    std::vector<const std::atomic<uint64_t>*> gating_;
+    char padding2[CACHELINE_SIZE];
+
+    size_t mask_;
+    std::vector<T> vec_;
+    std::vector<std::unique_ptr<Consumer>> consumers_;
+    /** consumers wait for the producer or their dependencies */
+    EventCount progress_;
+    /** the producer waits for gating consumers */
+    EventCount released_;
+
+private:
+    SequenceRingBuffer(const SequenceRingBuffer&) = delete;
+    SequenceRingBuffer(SequenceRingBuffer&&) = delete;
+    void operator=(const SequenceRingBuffer&) = delete;
+    void operator=(SequenceRingBuffer&&) = delete;
+};
+
+}} // namespace ppl::common
+
+#endif
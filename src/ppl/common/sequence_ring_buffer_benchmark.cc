@@ -0,0 +1,104 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "ppl/common/sequence_ring_buffer.h"
+#include "ppl/common/spsc_ring_buffer.h"
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <thread>
+#include <vector>
+using namespace std;
+using namespace ppl::common;
+
+static constexpr uint32_t ITEM_NUM = 1 << 20;
+static constexpr uint32_t QUEUE_SIZE = 1024;
+
+/** the producer pushes each item to `state.range(0)` queues, one for each consumer */
+static void BM_BroadcastSPSCQueues(benchmark::State& state) {
+    const uint32_t consumer_num = state.range(0);
+    for (auto _ : state) {
+        vector<unique_ptr<BatchedSPSCRingBuffer<uint32_t>>> queues;
+        for (uint32_t c = 0; c < consumer_num; ++c) {
+            queues.emplace_back(new BatchedSPSCRingBuffer<uint32_t>(QUEUE_SIZE));
+        }
+
+        vector<thread> consumers;
+        for (uint32_t c = 0; c < consumer_num; ++c) {
+            auto queue = queues[c].get();
+            consumers.emplace_back([queue]() {
+                uint32_t value;
+                for (uint32_t i = 0; i < ITEM_NUM; ++i) {
+                    while (!queue->Pop(&value)) {
+                        this_thread::yield();
+                    }
+                    benchmark::DoNotOptimize(value);
+                }
+            });
+        }
+
+        for (uint32_t i = 0; i < ITEM_NUM; ++i) {
+            for (uint32_t c = 0; c < consumer_num; ++c) {
+                while (!queues[c]->Push(i)) {
+                    this_thread::yield();
+                }
+            }
+        }
+        for (auto& t : consumers) {
+            t.join();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * ITEM_NUM);
+}
+
+/** the producer pushes each item once and all `state.range(0)` consumers read it in place */
+static void BM_BroadcastSequenceRingBuffer(benchmark::State& state) {
+    const uint32_t consumer_num = state.range(0);
+    for (auto _ : state) {
+        SequenceRingBuffer<uint32_t> rb(QUEUE_SIZE, SEQUENCE_WAIT_YIELD);
+        vector<uint32_t> ids(consumer_num);
+        for (uint32_t c = 0; c < consumer_num; ++c) {
+            rb.AddConsumer(&ids[c]);
+        }
+
+        vector<thread> consumers;
+        for (uint32_t c = 0; c < consumer_num; ++c) {
+            const uint32_t id = ids[c];
+            consumers.emplace_back([&rb, id]() {
+                uint64_t next = 0;
+                while (next < ITEM_NUM) {
+                    auto end = rb.WaitFor(id, next);
+                    for (; next < end; ++next) {
+                        benchmark::DoNotOptimize(rb.Get(next));
+                    }
+                    rb.Release(id, end);
+                }
+            });
+        }
+
+        for (uint32_t i = 0; i < ITEM_NUM; ++i) {
+            rb.Push(i);
+        }
+        for (auto& t : consumers) {
+            t.join();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * ITEM_NUM);
+}
+
+BENCHMARK(BM_BroadcastSPSCQueues)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+BENCHMARK(BM_BroadcastSequenceRingBuffer)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
@@ -0,0 +1,171 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "ppl/common/sequence_ring_buffer.h"
+#include "gtest/gtest.h"
+#include <thread>
+#include <vector>
+using namespace std;
+using namespace ppl::common;
+
+TEST(SequenceRingBufferTest, add_consumer) {
+    SequenceRingBuffer<int> rb(4);
+    uint32_t a, b, c;
+    ASSERT_EQ(RC_SUCCESS, rb.AddConsumer(&a));
+    ASSERT_EQ(RC_SUCCESS, rb.AddConsumer({a}, &b));
+    ASSERT_EQ(RC_INVALID_VALUE, rb.AddConsumer({a, 5}, &c));
+    ASSERT_EQ(0u, a);
+    ASSERT_EQ(1u, b);
+    ASSERT_EQ(4u, rb.GetCapacity());
+}
+
+TEST(SequenceRingBufferTest, gating) {
+    SequenceRingBuffer<int> rb(4);
+    uint32_t a, b;
+    ASSERT_EQ(RC_SUCCESS, rb.AddConsumer(&a));
+    ASSERT_EQ(RC_SUCCESS, rb.AddConsumer({a}, &b));
+
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(rb.TryPush(i));
+    }
+    ASSERT_FALSE(rb.TryPush(4));
+
+    // b depends on a, so it sees nothing before a releases
+    ASSERT_EQ(0u, rb.GetAvailable(b));
+    ASSERT_EQ(4u, rb.WaitFor(a, 0));
+    ASSERT_EQ(0, rb.Get(0));
+    rb.Release(a, 2);
+    ASSERT_EQ(2u, rb.GetAvailable(b));
+
+    // the producer is gated by b
+    ASSERT_FALSE(rb.TryPush(4));
+    rb.Release(b, 1);
+    ASSERT_TRUE(rb.TryPush(4));
+    ASSERT_FALSE(rb.TryPush(5));
+    ASSERT_EQ(4, rb.Get(4));
+    ASSERT_EQ(5u, rb.GetAvailable(a));
+}
+
+static void Broadcast(SequenceWaitStrategy wait_strategy, uint64_t n) {
+    SequenceRingBuffer<uint64_t> rb(64, wait_strategy);
+
+    // stage1 and stage2 see items from the producer. stage3 sees items after both of them.
+    uint32_t stage1, stage2, stage3;
+    ASSERT_EQ(RC_SUCCESS, rb.AddConsumer(&stage1));
+    ASSERT_EQ(RC_SUCCESS, rb.AddConsumer(&stage2));
+    ASSERT_EQ(RC_SUCCESS, rb.AddConsumer({stage1, stage2}, &stage3));
+
+    vector<uint64_t> sums(3, 0);
+    vector<thread> consumers;
+    const uint32_t ids[] = {stage1, stage2, stage3};
+    for (uint32_t i = 0; i < 3; ++i) {
+        consumers.emplace_back([&rb, &sums, &ids, i, n]() {
+            const uint32_t id = ids[i];
+            uint64_t next = rb.GetCursor(id);
+            while (next < n) {
+                auto end = rb.WaitFor(id, next);
+                for (; next < end; ++next) {
+                    auto value = rb.Get(next);
+                    if (i == 2) {
+                        ASSERT_EQ(n + next, value);
+                    }
+                    sums[i] += value;
+                }
+                rb.Release(id, end);
+            }
+        });
+    }
+
+    // claims in batches of various sizes
+    uint64_t seq = 0;
+    while (seq < n) {
+        uint32_t num = seq % 7 + 1;
+        if (seq + num > n) {
+            num = n - seq;
+        }
+        auto first = rb.Claim(num);
+        ASSERT_EQ(seq, first);
+        for (uint32_t i = 0; i < num; ++i) {
+            // written before publishing, so that all stages see n + seq
+            rb.Get(first + i) = n + first + i;
+        }
+        rb.Publish(num);
+        seq += num;
+    }
+
+    for (auto& t : consumers) {
+        t.join();
+    }
+
+    const uint64_t expected = n * n + n * (n - 1) / 2;
+    ASSERT_EQ(expected, sums[0]);
+    ASSERT_EQ(expected, sums[1]);
+    ASSERT_EQ(expected, sums[2]);
+}
+
+TEST(SequenceRingBufferTest, broadcast_busy_spin) {
+    // spinning threads are slow if they outnumber cpu cores
+    Broadcast(SEQUENCE_WAIT_BUSY_SPIN, 2000);
+}
+
+TEST(SequenceRingBufferTest, broadcast_yield) {
+    Broadcast(SEQUENCE_WAIT_YIELD, 100000);
+}
+
+TEST(SequenceRingBufferTest, broadcast_blocking) {
+    Broadcast(SEQUENCE_WAIT_BLOCKING, 100000);
+}
+
+TEST(SequenceRingBufferTest, pipeline) {
+    // stage2 reads what stage1 writes
+    const uint64_t n = 50000;
+    SequenceRingBuffer<uint64_t> rb(16);
+    uint32_t stage1, stage2;
+    ASSERT_EQ(RC_SUCCESS, rb.AddConsumer(&stage1));
+    ASSERT_EQ(RC_SUCCESS, rb.AddConsumer({stage1}, &stage2));
+
+    thread t1([&rb, stage1, n]() {
+        uint64_t next = 0;
+        while (next < n) {
+            auto end = rb.WaitFor(stage1, next);
+            for (; next < end; ++next) {
+                rb.Get(next) *= 2;
+            }
+            rb.Release(stage1, end);
+        }
+    });
+
+    uint64_t sum = 0;
+    thread t2([&rb, stage2, n, &sum]() {
+        uint64_t next = 0;
+        while (next < n) {
+            auto end = rb.WaitFor(stage2, next);
+            for (; next < end; ++next) {
+                sum += rb.Get(next);
+            }
+            rb.Release(stage2, end);
+        }
+    });
+
+    for (uint64_t i = 0; i < n; ++i) {
+        rb.Push(i);
+    }
+    t1.join();
+    t2.join();
+    ASSERT_EQ(n * (n - 1), sum);
+}
@@ -0,0 +1,219 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#ifndef _ST_HPC_PPL_COMMON_SHARED_SPSC_RING_BUFFER_H_
+#define _ST_HPC_PPL_COMMON_SHARED_SPSC_RING_BUFFER_H_
+
+#include "ppl/common/retcode.h"
+#include "ppl/common/mmap.h"
+#include "ppl/common/event_count.h"
+#include "ppl/common/log.h"
+#include <stdint.h>
+#include <atomic>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+namespace ppl { namespace common {
+
+/**
+   a lock-free single-producer-single-consumer ring buffer in memory shared among processes. a versioned header,
+   the indices and the items all live in the mapping, so items are handed over between processes without copying
+   through the kernel. the producer and the consumer can be in different processes, and blocking operations sleep
+   on process-shared futexes. `T` MUST be trivially copyable.
+*/
+
+template <typename T>
+class SharedSPSCRingBuffer final {
+public:
+    static constexpr uint32_t VERSION = 1;
+
+public:
+    SharedSPSCRingBuffer() : layout_(nullptr), items_(nullptr), mask_(0), head_cache_(0), tail_cache_(0) {}
+
+    /**
+       @brief creates a ring of at least `size` items in `filename`, which is created if it does not exist or is
+       overwritten otherwise. `filename` can be nullptr to create an anonymous ring, which is shared with child
+       processes by fork().
+       @see `Mmap::InitShared()`
+    */
+    ppl::common::RetCode Create(const char* filename, uint64_t size) {
+        uint64_t capacity = 2;
+        while (capacity < size) {
+            capacity <<= 1;
+        }
+
+        auto rc = mmap_.InitShared(filename, sizeof(Layout) + capacity * sizeof(T));
+        if (rc != RC_SUCCESS) {
+            LOG(ERROR) << "map shared memory failed: " << GetRetCodeStr(rc);
+            return rc;
+        }
+
+        layout_ = reinterpret_cast<Layout*>(mmap_.GetData());
+        // `Open()` fails until the header is ready
+        new (&layout_->magic) std::atomic<uint64_t>(0);
+        layout_->version = VERSION;
+        layout_->item_size = sizeof(T);
+        layout_->capacity = capacity;
+        new (&layout_->tail) std::atomic<uint64_t>(0);
+        new (&layout_->head) std::atomic<uint64_t>(0);
+        new (&layout_->not_empty) EventCount(true);
+        new (&layout_->not_full) EventCount(true);
+        layout_->magic.store(MAGIC, std::memory_order_release);
+
+        items_ = reinterpret_cast<T*>(layout_ + 1);
+        mask_ = capacity - 1;
+        return RC_SUCCESS;
+    }
+
+    /** @brief attaches to a ring created by `Create()`, usually in another process */
+    ppl::common::RetCode Open(const char* filename) {
+        auto rc = mmap_.InitShared(filename, 0);
+        if (rc != RC_SUCCESS) {
+            LOG(ERROR) << "map shared memory [" << filename << "] failed: " << GetRetCodeStr(rc);
+            return rc;
+        }
+
+        auto layout = reinterpret_cast<Layout*>(mmap_.GetData());
+        if (mmap_.GetSize() < sizeof(Layout) || layout->magic.load(std::memory_order_acquire) != MAGIC) {
+            LOG(ERROR) << "[" << filename << "] is not a ring buffer or is not ready.";
+            mmap_ = Mmap();
+            return RC_INVALID_VALUE;
+        }
+        if (layout->version != VERSION || layout->item_size != sizeof(T) ||
+            mmap_.GetSize() < sizeof(Layout) + layout->capacity * sizeof(T)) {
+            LOG(ERROR) << "version [" << layout->version << "] or item size [" << layout->item_size
+                       << "] mismatch, or the file is truncated.";
+            mmap_ = Mmap();
+            return RC_INVALID_VALUE;
+        }
+
+        layout_ = layout;
+        items_ = reinterpret_cast<T*>(layout_ + 1);
+        mask_ = layout_->capacity - 1;
+        head_cache_ = layout_->head.load(std::memory_order_acquire);
+        tail_cache_ = layout_->tail.load(std::memory_order_acquire);
+        return RC_SUCCESS;
+    }
+
+    /** MUST be called by the producer. returns false if the queue is full. */
+    bool TryPush(const T& item) {
+        const uint64_t tail = layout_->tail.load(std::memory_order_relaxed);
+        if (tail - head_cache_ > mask_) {
+            head_cache_ = layout_->head.load(std::memory_order_acquire);
+            if (tail - head_cache_ > mask_) {
+                return false;
+            }
+        }
+        items_[tail & mask_] = item;
+        layout_->tail.store(tail + 1, std::memory_order_release);
+        layout_->not_empty.NotifyOneIfWaiting();
+        return true;
+    }
+
+    /** MUST be called by the consumer. returns false if the queue is empty. */
+    bool TryPop(T* item) {
+        const uint64_t head = layout_->head.load(std::memory_order_relaxed);
+        if (head == tail_cache_) {
+            tail_cache_ = layout_->tail.load(std::memory_order_acquire);
+            if (head == tail_cache_) {
+                return false;
+            }
+        }
+        *item = items_[head & mask_];
+        layout_->head.store(head + 1, std::memory_order_release);
+        layout_->not_full.NotifyOneIfWaiting();
+        return true;
+    }
+
+    /** blocks until there is space for `item` */
+    void Push(const T& item) {
+        layout_->not_full.Wait([this, &item]() -> bool {
+            return TryPush(item);
+        });
+    }
+
+    /** blocks until an item is available */
+    void Pop(T* item) {
+        layout_->not_empty.Wait([this, item]() -> bool {
+            return TryPop(item);
+        });
+    }
+
+    // approximate
+    uint64_t Size() const {
+        const auto head = layout_->head.load(std::memory_order_relaxed);
+        const auto tail = layout_->tail.load(std::memory_order_relaxed);
+        return (tail > head) ? (tail - head) : 0;
+    }
+
+    bool IsEmpty() const {
+        return (Size() == 0);
+    }
+
+    uint64_t GetCapacity() const {
+        return mask_ + 1;
+    }
+
+private:
+    static_assert(std::is_trivially_copyable<T>::value, "T MUST be trivially copyable");
+    static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "atomics in shared memory MUST be lock-free");
+
+    // "PPLSPSCR"
+    static constexpr uint64_t MAGIC = 0x5250535043504c50ull;
+    // l1 cache line size for most CPUs
+    static constexpr int CACHELINE_SIZE = 64;
+
+    /** the header in the shared memory, followed by items. each part occupies its own cache line. */
+    struct Layout final {
+        std::atomic<uint64_t> magic;
+        uint32_t version;
+        uint32_t item_size;
+        uint64_t capacity;
+        char padding0[CACHELINE_SIZE - 3 * sizeof(uint64_t)];
+
+        std::atomic<uint64_t> tail;
+        char padding1[CACHELINE_SIZE - sizeof(std::atomic<uint64_t>)];
+        std::atomic<uint64_t> head;
+        char padding2[CACHELINE_SIZE - sizeof(std::atomic<uint64_t>)];
+
+        EventCount not_empty;
+        char padding3[CACHELINE_SIZE - sizeof(EventCount)];
+        EventCount not_full;
+        char padding4[CACHELINE_SIZE - sizeof(EventCount)];
+    };
+
+private:
+    Mmap mmap_;
+    Layout* layout_;
+    T* items_;
+    uint64_t mask_;
+    /** process-local copies of the other side's index, which may be older than the real ones */
+    uint64_t head_cache_;
+    uint64_t tail_cache_;
+
+private:
+    SharedSPSCRingBuffer(const SharedSPSCRingBuffer&) = delete;
+    SharedSPSCRingBuffer(SharedSPSCRingBuffer&&) = delete;
+    void operator=(const SharedSPSCRingBuffer&) = delete;
+    void operator=(SharedSPSCRingBuffer&&) = delete;
+};
+
+}} // namespace ppl::common
+
+#endif
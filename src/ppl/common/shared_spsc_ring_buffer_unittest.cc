@@ -0,0 +1,128 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "ppl/common/shared_spsc_ring_buffer.h"
+#include "gtest/gtest.h"
+
+#ifndef _MSC_VER
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <string>
+using namespace std;
+using namespace ppl::common;
+
+struct Message final {
+    uint64_t id;
+    char text[24];
+};
+
+static int WaitChild(pid_t pid) {
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return (WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+}
+
+TEST(SharedSPSCRingBufferTest, try_push_pop) {
+    SharedSPSCRingBuffer<uint32_t> ring;
+    ASSERT_EQ(RC_SUCCESS, ring.Create(nullptr, 5));
+    ASSERT_EQ(8u, ring.GetCapacity());
+    ASSERT_TRUE(ring.IsEmpty());
+
+    for (uint32_t i = 0; i < 8; ++i) {
+        ASSERT_TRUE(ring.TryPush(i));
+    }
+    ASSERT_FALSE(ring.TryPush(8));
+    ASSERT_EQ(8u, ring.Size());
+
+    uint32_t value;
+    for (uint32_t i = 0; i < 8; ++i) {
+        ASSERT_TRUE(ring.TryPop(&value));
+        ASSERT_EQ(i, value);
+    }
+    ASSERT_FALSE(ring.TryPop(&value));
+}
+
+TEST(SharedSPSCRingBufferTest, fork) {
+    const uint64_t n = 100000;
+    SharedSPSCRingBuffer<Message> ring;
+    ASSERT_EQ(RC_SUCCESS, ring.Create(nullptr, 64));
+
+    const pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+        Message msg;
+        for (uint64_t i = 0; i < n; ++i) {
+            msg.id = i;
+            snprintf(msg.text, sizeof(msg.text), "message %lu", (unsigned long)i);
+            ring.Push(msg);
+        }
+        _exit(0);
+    }
+
+    Message msg;
+    for (uint64_t i = 0; i < n; ++i) {
+        ring.Pop(&msg);
+        ASSERT_EQ(i, msg.id);
+        ASSERT_EQ("message " + to_string(i), string(msg.text));
+    }
+    ASSERT_EQ(0, WaitChild(pid));
+    ASSERT_TRUE(ring.IsEmpty());
+}
+
+TEST(SharedSPSCRingBufferTest, open) {
+    const string filename = "/tmp/pplcommon_shared_spsc_" + to_string(getpid());
+    const uint64_t n = 10000;
+
+    SharedSPSCRingBuffer<uint64_t> ring;
+    ASSERT_EQ(RC_SUCCESS, ring.Create(filename.c_str(), 16));
+
+    const pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+        // attaches to the ring by name as an unrelated process would do
+        SharedSPSCRingBuffer<uint64_t> consumer;
+        if (consumer.Open(filename.c_str()) != RC_SUCCESS) {
+            _exit(1);
+        }
+        uint64_t value;
+        for (uint64_t i = 0; i < n; ++i) {
+            consumer.Pop(&value);
+            if (value != i * 3) {
+                _exit(2);
+            }
+        }
+        _exit(0);
+    }
+
+    for (uint64_t i = 0; i < n; ++i) {
+        ring.Push(i * 3);
+    }
+    ASSERT_EQ(0, WaitChild(pid));
+
+    // item type mismatch
+    SharedSPSCRingBuffer<uint32_t> other;
+    ASSERT_NE(RC_SUCCESS, other.Open(filename.c_str()));
+    unlink(filename.c_str());
+    ASSERT_NE(RC_SUCCESS, other.Open(filename.c_str()));
+    ASSERT_NE(0, access(filename.c_str(), F_OK));
+
+    ASSERT_NE(RC_SUCCESS, other.Open(__FILE__));
+}
+
+#endif
@@ -0,0 +1,115 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "ppl/common/spin_barrier.h"
+#include "ppl/common/futex_wrapper.h"
+#include "ppl/common/cpu_relax.h"
+#include <thread>
+using namespace std;
+
+namespace ppl { namespace common {
+
+void SpinBarrier::Reset(uint32_t max_count) {
+    max_count_ = max_count;
+    spin_count_ = (max_count <= thread::hardware_concurrency()) ? SPIN_COUNT : 0;
+    count_.store(0, std::memory_order_relaxed);
+    tree_.reset();
+
+    if (max_count <= TREE_THRESHOLD) {
+        return;
+    }
+
+    uint32_t nr_nodes = 0;
+    for (uint32_t n = max_count; n > 1;) {
+        n = (n + TREE_FANIN - 1) / TREE_FANIN;
+        nr_nodes += n;
+    }
+    tree_.reset(new TreeNode[nr_nodes]);
+
+    uint32_t level_begin = 0;
+    uint32_t nr_children = max_count;
+    while (true) {
+        const uint32_t nr_level_nodes = (nr_children + TREE_FANIN - 1) / TREE_FANIN;
+        const uint32_t next_level_begin = level_begin + nr_level_nodes;
+        for (uint32_t i = 0; i < nr_level_nodes; ++i) {
+            auto node = &tree_[level_begin + i];
+            const uint32_t rest = nr_children - i * TREE_FANIN;
+            node->expected = (rest < TREE_FANIN) ? rest : TREE_FANIN;
+            node->parent = (nr_level_nodes == 1) ? UINT32_MAX : next_level_begin + i / TREE_FANIN;
+        }
+        if (nr_level_nodes == 1) {
+            break;
+        }
+        level_begin = next_level_begin;
+        nr_children = nr_level_nodes;
+    }
+}
+
+void SpinBarrier::Release() {
+    generation_.fetch_add(1, std::memory_order_seq_cst);
+    if (sleepers_.load(std::memory_order_seq_cst) > 0) {
+        FutexWakeAll(reinterpret_cast<uint32_t*>(&generation_));
+    }
+}
+
+void SpinBarrier::WaitForRelease(uint32_t generation) {
+    for (uint32_t i = 0; i < spin_count_; ++i) {
+        if (generation_.load(std::memory_order_acquire) != generation) {
+            return;
+        }
+        CpuRelax();
+    }
+
+    sleepers_.fetch_add(1, std::memory_order_seq_cst);
+    while (generation_.load(std::memory_order_seq_cst) == generation) {
+        FutexWait(reinterpret_cast<uint32_t*>(&generation_), generation);
+    }
+    sleepers_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void SpinBarrier::Wait() {
+    const uint32_t generation = generation_.load(std::memory_order_acquire);
+    if (Arrive(&count_, max_count_)) {
+        Release();
+    } else {
+        WaitForRelease(generation);
+    }
+}
+
+void SpinBarrier::Wait(uint32_t idx) {
+    if (!tree_) {
+        Wait();
+        return;
+    }
+
+    const uint32_t generation = generation_.load(std::memory_order_acquire);
+    uint32_t node_idx = idx / TREE_FANIN;
+    while (true) {
+        auto node = &tree_[node_idx];
+        if (!Arrive(&node->count, node->expected)) {
+            WaitForRelease(generation);
+            return;
+        }
+        if (node->parent == UINT32_MAX) {
+            Release();
+            return;
+        }
+        node_idx = node->parent;
+    }
+}
+
+}} // namespace ppl::common
@@ -0,0 +1,104 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef _ST_HPC_PPL_COMMON_SPIN_BARRIER_H_
+#define _ST_HPC_PPL_COMMON_SPIN_BARRIER_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+
+namespace ppl { namespace common {
+
+/**
+   a sense-reversing barrier which spins for a bounded number of rounds and then sleeps on a futex.
+   it can be used as a drop-in replacement of `Barrier`. spinning is disabled if there are more
+   participants than cpu cores.
+
+   if `max_count` > TREE_THRESHOLD, `Wait(idx)` combines arrivals in a tree of counters with fan-in
+   TREE_FANIN so that threads do not contend on a single cache line. in that case all participants
+   MUST call `Wait(idx)` with distinct `idx` in [0, max_count).
+*/
+
+class SpinBarrier final {
+public:
+    static constexpr uint32_t TREE_THRESHOLD = 32;
+    static constexpr uint32_t TREE_FANIN = 8;
+
+public:
+    SpinBarrier(uint32_t max_count = 0) : count_(0), generation_(0), sleepers_(0) {
+        Reset(max_count);
+    }
+
+    /** MUST NOT be called when there are threads waiting. */
+    void Reset(uint32_t max_count);
+
+    void Wait();
+    void Wait(uint32_t idx);
+
+private:
+    /** returns true if the caller is the last one to arrive */
+    bool Arrive(std::atomic<uint32_t>* count, uint32_t expected) {
+        if (count->fetch_add(1, std::memory_order_acq_rel) + 1 >= expected) {
+            count->store(0, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+    void Release();
+    void WaitForRelease(uint32_t generation);
+
+private:
+    // l1 cache line size for most CPUs
+    static constexpr int CACHELINE_SIZE = 64;
+    static constexpr uint32_t SPIN_COUNT = 1024;
+
+    struct TreeNode final {
+        union {
+            std::atomic<uint32_t> count;
+            char padding[CACHELINE_SIZE];
+        };
+        uint32_t expected;
+        uint32_t parent; // UINT32_MAX for root
+
+        TreeNode() : count(0), expected(0), parent(0) {}
+    };
+
+    union {
+        std::atomic<uint32_t> count_;
+        char padding1[CACHELINE_SIZE];
+    };
+    union {
+        // the futex word. `Wait()` returns when it is changed.
+        std::atomic<uint32_t> generation_;
+        char padding2[CACHELINE_SIZE];
+    };
+    std::atomic<uint32_t> sleepers_;
+    uint32_t max_count_;
+    uint32_t spin_count_;
+    std::unique_ptr<TreeNode[]> tree_; // leaves come first
+
+private:
+    SpinBarrier(const SpinBarrier&) = delete;
+    SpinBarrier(SpinBarrier&&) = delete;
+    void operator=(const SpinBarrier&) = delete;
+    void operator=(SpinBarrier&&) = delete;
+};
+
+}} // namespace ppl::common
+
+#endif
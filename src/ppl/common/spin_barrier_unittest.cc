@@ -0,0 +1,68 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "ppl/common/spin_barrier.h"
+#include "gtest/gtest.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace ppl::common;
+
+static void TestPhases(uint32_t nr_threads, bool indexed) {
+    const uint32_t nr_phases = 20;
+    SpinBarrier barrier(nr_threads);
+    std::atomic<uint32_t> arrived(0);
+    std::atomic<bool> ok(true);
+
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < nr_threads; ++i) {
+        threads.emplace_back([&, i]() {
+            for (uint32_t phase = 0; phase < nr_phases; ++phase) {
+                arrived.fetch_add(1);
+                if (indexed) {
+                    barrier.Wait(i);
+                } else {
+                    barrier.Wait();
+                }
+                // everyone has arrived in this phase
+                if (arrived.load() < (phase + 1) * nr_threads) {
+                    ok.store(false);
+                }
+                if (indexed) {
+                    barrier.Wait(i);
+                } else {
+                    barrier.Wait();
+                }
+            }
+        });
+    }
+    for (auto t = threads.begin(); t != threads.end(); ++t) {
+        t->join();
+    }
+
+    ASSERT_TRUE(ok.load());
+    ASSERT_EQ(nr_phases * nr_threads, arrived.load());
+}
+
+TEST(SpinBarrierTest, central) {
+    TestPhases(4, false);
+}
+
+TEST(SpinBarrierTest, tree) {
+    TestPhases(SpinBarrier::TREE_THRESHOLD + 9, true);
+}
@@ -0,0 +1,226 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#ifndef _ST_HPC_PPL_COMMON_SPIN_LOCK_H_
+#define _ST_HPC_PPL_COMMON_SPIN_LOCK_H_
+
+#include "ppl/common/cpu_relax.h"
+#include <stdint.h>
+#include <atomic>
+#include <thread>
+
+namespace ppl { namespace common {
+
+/**
+   exponential backoff for spinning: spins with `CpuRelax()` for 1, 2, 4, ... iterations, and yields the cpu once
+   it has spun `MAX_SPINS` iterations at a time, in case the thread it waits for is preempted.
+*/
+
+class SpinBackoff final {
+public:
+    SpinBackoff() : spins_(1) {}
+
+    /** `factor` scales the spins of this round, e.g. the number of threads ahead in a queue */
+    void Pause(uint32_t factor = 1) {
+        if (spins_ > MAX_SPINS) {
+            std::this_thread::yield();
+            return;
+        }
+
+        uint32_t n = spins_ * factor;
+        if (n > MAX_SPINS) {
+            n = MAX_SPINS;
+        }
+        for (uint32_t i = 0; i < n; ++i) {
+            CpuRelax();
+        }
+        spins_ <<= 1;
+    }
+
+private:
+    static constexpr uint32_t MAX_SPINS = 64;
+    uint32_t spins_;
+};
+
+/**
+   a fair spin lock which grants the lock in the order of arrival, implementing the `LockType` interface used by
+   `ReadLockGuard`/`WriteLockGuard`. waiters back off in proportion to their distance from the head of the line.
+   suitable for very short critical sections with a few threads. `ReadLock()` is the same as `WriteLock()`.
+*/
+
+class TicketSpinLock final {
+public:
+    TicketSpinLock() : next_ticket_(0), now_serving_(0) {}
+
+    void WriteLock() {
+        const uint32_t ticket = next_ticket_.fetch_add(1, std::memory_order_relaxed);
+        SpinBackoff backoff;
+        while (true) {
+            const uint32_t serving = now_serving_.load(std::memory_order_acquire);
+            if (serving == ticket) {
+                return;
+            }
+            backoff.Pause(ticket - serving);
+        }
+    }
+
+    void ReadLock() {
+        WriteLock();
+    }
+
+    bool TryLock() {
+        const uint32_t serving = now_serving_.load(std::memory_order_acquire);
+        uint32_t ticket = serving;
+        return next_ticket_.compare_exchange_strong(ticket, serving + 1, std::memory_order_relaxed);
+    }
+
+    void Unlock() {
+        // only the holder modifies `now_serving_`
+        now_serving_.store(now_serving_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+private:
+    std::atomic<uint32_t> next_ticket_;
+    std::atomic<uint32_t> now_serving_;
+
+private:
+    TicketSpinLock(const TicketSpinLock&) = delete;
+    TicketSpinLock(TicketSpinLock&&) = delete;
+    void operator=(const TicketSpinLock&) = delete;
+    void operator=(TicketSpinLock&&) = delete;
+};
+
+/**
+   a fair queue spin lock in which each waiter spins on its own node, so the lock's cache line is not bounced
+   among waiters. implementing the `LockType` interface used by `ReadLockGuard`/`WriteLockGuard`. it scales
+   better than `TicketSpinLock` with many waiters. `ReadLock()` is the same as `WriteLock()`.
+   this is the K42 variant of the MCS lock, in which nodes of waiters live on their stacks and the holder does
+   not need a node, so `Unlock()` takes no arguments. based on
+     - M. L. Scott, Shared-Memory Synchronization, section 4.3.1
+*/
+
+class McsSpinLock final {
+public:
+    McsSpinLock() {
+        q_.tail.store(nullptr, std::memory_order_relaxed);
+        q_.next.store(nullptr, std::memory_order_relaxed);
+    }
+
+    void WriteLock() {
+        while (true) {
+            Node* prev = q_.tail.load(std::memory_order_relaxed);
+            if (!prev) {
+                // the lock is free. `q_.tail` points to the lock itself while it is held with no waiters.
+                if (q_.tail.compare_exchange_strong(prev, &q_, std::memory_order_acquire,
+                                                    std::memory_order_relaxed)) {
+                    return;
+                }
+                continue;
+            }
+
+            Node n;
+            n.tail.store(Waiting(), std::memory_order_relaxed);
+            n.next.store(nullptr, std::memory_order_relaxed);
+            if (!q_.tail.compare_exchange_strong(prev, &n, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                continue;
+            }
+
+            prev->next.store(&n, std::memory_order_release);
+            SpinBackoff backoff;
+            while (n.tail.load(std::memory_order_acquire) == Waiting()) {
+                backoff.Pause();
+            }
+
+            // the lock is granted. hands our successor, if any, to `q_` before `n` goes out of scope.
+            Node* succ = n.next.load(std::memory_order_acquire);
+            if (!succ) {
+                q_.next.store(nullptr, std::memory_order_relaxed);
+                Node* expected = &n;
+                if (!q_.tail.compare_exchange_strong(expected, &q_, std::memory_order_acq_rel,
+                                                     std::memory_order_relaxed)) {
+                    // someone has enqueued after `n`, and is linking itself
+                    succ = WaitForNext(&n);
+                    q_.next.store(succ, std::memory_order_relaxed);
+                }
+            } else {
+                q_.next.store(succ, std::memory_order_relaxed);
+            }
+            return;
+        }
+    }
+
+    void ReadLock() {
+        WriteLock();
+    }
+
+    bool TryLock() {
+        Node* expected = nullptr;
+        return q_.tail.compare_exchange_strong(expected, &q_, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    void Unlock() {
+        Node* succ = q_.next.load(std::memory_order_acquire);
+        if (!succ) {
+            Node* expected = &q_;
+            if (q_.tail.compare_exchange_strong(expected, nullptr, std::memory_order_release,
+                                                std::memory_order_relaxed)) {
+                return;
+            }
+            succ = WaitForNext(&q_);
+        }
+        succ->tail.store(nullptr, std::memory_order_release);
+    }
+
+private:
+    struct Node final {
+        /** `Waiting()` while the owner of this node waits for the lock */
+        std::atomic<Node*> tail;
+        std::atomic<Node*> next;
+    };
+
+    static Node* Waiting() {
+        return reinterpret_cast<Node*>(uintptr_t(1));
+    }
+
+    /** waits for a thread which has just swapped itself into `q_.tail` to link to `n` */
+    static Node* WaitForNext(Node* n) {
+        SpinBackoff backoff;
+        Node* next;
+        while (!(next = n->next.load(std::memory_order_acquire))) {
+            backoff.Pause();
+        }
+        return next;
+    }
+
+private:
+    /**
+       `q_.tail` is the last waiter, `&q_` if the lock is held with no waiters, or nullptr if the lock is free.
+       `q_.next` is the first waiter.
+    */
+    Node q_;
+
+private:
+    McsSpinLock(const McsSpinLock&) = delete;
+    McsSpinLock(McsSpinLock&&) = delete;
+    void operator=(const McsSpinLock&) = delete;
+    void operator=(McsSpinLock&&) = delete;
+};
+
+}} // namespace ppl::common
+
+#endif
@@ -0,0 +1,109 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "ppl/common/spin_lock.h"
+#include "ppl/common/futex_mutex.h"
+#include "ppl/common/lock_utils.h"
+#include <benchmark/benchmark.h>
+#include <thread>
+#include <vector>
+
+#ifdef _MSC_VER
+#include "ppl/common/windows/pthread.h"
+#else
+#include <pthread.h>
+#endif
+
+using namespace std;
+using namespace ppl::common;
+
+namespace {
+
+class PthreadMutexLock final {
+public:
+    PthreadMutexLock() {
+        pthread_mutex_init(&mutex_, nullptr);
+    }
+    ~PthreadMutexLock() {
+        pthread_mutex_destroy(&mutex_);
+    }
+    void ReadLock() {
+        pthread_mutex_lock(&mutex_);
+    }
+    void WriteLock() {
+        pthread_mutex_lock(&mutex_);
+    }
+    void Unlock() {
+        pthread_mutex_unlock(&mutex_);
+    }
+
+private:
+    pthread_mutex_t mutex_;
+};
+
+} // namespace
+
+static constexpr uint32_t OP_NUM = 1 << 18;
+
+/** a dependent chain of `len` multiply-adds, so that the critical section cannot be optimized out */
+static inline uint64_t Work(uint64_t v, uint32_t len) {
+    for (uint32_t i = 0; i < len; ++i) {
+        v = v * 6364136223846793005ULL + 1442695040888963407ULL;
+    }
+    return v;
+}
+
+/**
+   `state.range(0)` threads run OP_NUM critical sections in total. each critical section updates a shared value
+   with `state.range(1)` steps of work, and each thread does the same amount of work outside the lock.
+*/
+template <typename LockType>
+static void BM_LockSweep(benchmark::State& state) {
+    const uint32_t thread_num = state.range(0);
+    const uint32_t cs_len = state.range(1);
+    for (auto _ : state) {
+        LockType lock;
+        uint64_t shared_value = 0;
+        vector<thread> threads;
+        for (uint32_t i = 0; i < thread_num; ++i) {
+            threads.emplace_back([&lock, &shared_value, i, thread_num, cs_len]() {
+                uint64_t local = i;
+                for (uint32_t j = i; j < OP_NUM; j += thread_num) {
+                    {
+                        WriteLockGuard<LockType> guard(&lock);
+                        shared_value = Work(shared_value, cs_len);
+                    }
+                    local = Work(local, cs_len);
+                }
+                benchmark::DoNotOptimize(local);
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        benchmark::DoNotOptimize(shared_value);
+    }
+    state.SetItemsProcessed(state.iterations() * OP_NUM);
+}
+
+#define LOCK_SWEEP_ARGS ArgsProduct({{1, 2, 4, 8, 16}, {0, 16, 256}})->UseRealTime()
+
+BENCHMARK_TEMPLATE(BM_LockSweep, PthreadMutexLock)->LOCK_SWEEP_ARGS;
+BENCHMARK_TEMPLATE(BM_LockSweep, FutexMutex)->LOCK_SWEEP_ARGS;
+BENCHMARK_TEMPLATE(BM_LockSweep, TicketSpinLock)->LOCK_SWEEP_ARGS;
+BENCHMARK_TEMPLATE(BM_LockSweep, McsSpinLock)->LOCK_SWEEP_ARGS;
@@ -0,0 +1,90 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "ppl/common/spin_lock.h"
+#include "ppl/common/lock_utils.h"
+#include "ppl/common/object_pool.h"
+#include "gtest/gtest.h"
+#include <thread>
+#include <vector>
+using namespace std;
+using namespace ppl::common;
+
+template <typename LockType>
+static void TestTryLock() {
+    LockType lock;
+    ASSERT_TRUE(lock.TryLock());
+    ASSERT_FALSE(lock.TryLock());
+    lock.Unlock();
+    ASSERT_TRUE(lock.TryLock());
+    lock.Unlock();
+    lock.WriteLock();
+    ASSERT_FALSE(lock.TryLock());
+    lock.Unlock();
+}
+
+template <typename LockType>
+static void TestCounter() {
+    const uint32_t thread_num = 8;
+    const uint32_t n = 20000;
+    LockType lock;
+    // updated non-atomically in critical sections
+    uint64_t a = 0, b = 0;
+
+    vector<thread> threads;
+    for (uint32_t i = 0; i < thread_num; ++i) {
+        threads.emplace_back([&lock, &a, &b, n]() {
+            for (uint32_t j = 0; j < n; ++j) {
+                WriteLockGuard<LockType> guard(&lock);
+                ++a;
+                b += a;
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    const uint64_t total = (uint64_t)thread_num * n;
+    ASSERT_EQ(total, a);
+    ASSERT_EQ(total * (total + 1) / 2, b);
+}
+
+TEST(TicketSpinLockTest, try_lock) {
+    TestTryLock<TicketSpinLock>();
+}
+
+TEST(TicketSpinLockTest, counter) {
+    TestCounter<TicketSpinLock>();
+}
+
+TEST(McsSpinLockTest, try_lock) {
+    TestTryLock<McsSpinLock>();
+}
+
+TEST(McsSpinLockTest, counter) {
+    TestCounter<McsSpinLock>();
+}
+
+TEST(McsSpinLockTest, object_pool) {
+    ObjectPool<int, McsSpinLock> pool;
+    auto p = pool.Alloc(3);
+    ASSERT_NE(nullptr, p);
+    ASSERT_EQ(3, *p);
+    pool.Free(p);
+}
@@ -20,6 +20,7 @@
 
 #include <atomic>
 #include <cstddef>
+#include <utility>
 #include <vector>
 
 namespace ppl { namespace common {
@@ -89,6 +90,209 @@ private:
     std::vector<T> vec_;
 };
 
+/**
+   a variant of `SPSCRingBuffer` for high message rates:
+     - capacity is a power of 2, so indices are masked instead of taken modulo.
+     - the producer and the consumer keep local copies of the other side's index, and load the shared one only
+       when the local copy says the queue is full or empty.
+     - `PushN()`/`PopN()` and the zero-copy `Reserve()`/`Commit()` and `Peek()`/`Release()` move many items per
+       index publication.
+   `Push()`, `PushN()`, `Reserve()` and `Commit()` MUST be called by the producer, and `Pop()`, `PopN()`,
+   `Peek()` and `Release()` MUST be called by the consumer.
+*/
+
+template <typename T>
+class BatchedSPSCRingBuffer final {
+public:
+    /** `size` is rounded up to a power of 2 */
+    BatchedSPSCRingBuffer(size_t size) {
+        size_t capacity = 2;
+        while (capacity < size) {
+            capacity <<= 1;
+        }
+        vec_.resize(capacity);
+        mask_ = capacity - 1;
+
+        producer_.tail.store(0, std::memory_order_relaxed);
+        producer_.head_cache = 0;
+        producer_.reserved = 0;
+        consumer_.head.store(0, std::memory_order_relaxed);
+        consumer_.tail_cache = 0;
+        consumer_.peeked = 0;
+    }
+
+    template <typename ItemType>
+    bool Push(ItemType&& item) {
+        T* slot;
+        if (Reserve(1, &slot) == 0) {
+            return false;
+        }
+        *slot = std::forward<ItemType>(item);
+        Commit(1);
+        return true;
+    }
+
+    template <typename ItemType>
+    bool Pop(ItemType* item) {
+        T* slot;
+        if (Peek(1, &slot) == 0) {
+            return false;
+        }
+        *item = std::move(*slot);
+        Release(1);
+        return true;
+    }
+
+    /** pushes up to `num` items and returns the number of items pushed */
+    size_t PushN(const T* items, size_t num) {
+        size_t pushed = 0;
+        // at most two contiguous parts if the range wraps around
+        for (int i = 0; i < 2 && pushed < num; ++i) {
+            T* slots;
+            const size_t n = Reserve(num - pushed, &slots);
+            if (n == 0) {
+                break;
+            }
+            for (size_t j = 0; j < n; ++j) {
+                slots[j] = items[pushed + j];
+            }
+            pushed += n;
+        }
+        Commit(pushed);
+        return pushed;
+    }
+
+    /** pops up to `num` items and returns the number of items popped */
+    size_t PopN(T* items, size_t num) {
+        size_t popped = 0;
+        for (int i = 0; i < 2 && popped < num; ++i) {
+            T* slots;
+            const size_t n = Peek(num - popped, &slots);
+            if (n == 0) {
+                break;
+            }
+            for (size_t j = 0; j < n; ++j) {
+                items[popped + j] = std::move(slots[j]);
+            }
+            popped += n;
+        }
+        Release(popped);
+        return popped;
+    }
+
+    /**
+       @brief makes `*slots` point to up to `num` contiguous free slots after the ones reserved but not committed,
+       and returns the number of slots. the slots are written in place and published by `Commit()`.
+       it may return fewer than the free slots if they wrap around the end of the buffer.
+    */
+    size_t Reserve(size_t num, T** slots) {
+        const size_t tail = producer_.tail.load(std::memory_order_relaxed) + producer_.reserved;
+        size_t free_num = vec_.size() - (tail - producer_.head_cache);
+        if (free_num < num) {
+            producer_.head_cache = consumer_.head.load(std::memory_order_acquire);
+            free_num = vec_.size() - (tail - producer_.head_cache);
+        }
+        const size_t idx = tail & mask_;
+        const size_t n = Min(Min(num, free_num), vec_.size() - idx);
+        *slots = &vec_[idx];
+        producer_.reserved += n;
+        return n;
+    }
+
+    /** publishes the first `num` reserved slots to the consumer */
+    void Commit(size_t num) {
+        producer_.reserved -= num;
+        producer_.tail.store(producer_.tail.load(std::memory_order_relaxed) + num, std::memory_order_release);
+    }
+
+    /**
+       @brief makes `*items` point to up to `num` contiguous items after the ones peeked but not released, and
+       returns the number of items. the items are read in place and their slots are returned by `Release()`.
+    */
+    size_t Peek(size_t num, T** items) {
+        const size_t head = consumer_.head.load(std::memory_order_relaxed) + consumer_.peeked;
+        size_t item_num = consumer_.tail_cache - head;
+        if (item_num < num) {
+            consumer_.tail_cache = producer_.tail.load(std::memory_order_acquire);
+            item_num = consumer_.tail_cache - head;
+        }
+        const size_t idx = head & mask_;
+        const size_t n = Min(Min(num, item_num), vec_.size() - idx);
+        *items = &vec_[idx];
+        consumer_.peeked += n;
+        return n;
+    }
+
+    /** returns slots of the first `num` peeked items to the producer */
+    void Release(size_t num) {
+        consumer_.peeked -= num;
+        consumer_.head.store(consumer_.head.load(std::memory_order_relaxed) + num, std::memory_order_release);
+    }
+
+    // approximate
+    bool IsEmpty() const {
+        return (Size() == 0);
+    }
+
+    // approximate
+    bool IsFull() const {
+        return (Size() == vec_.size());
+    }
+
+    // approximate
+    size_t Size() const {
+        const auto head = consumer_.head.load(std::memory_order_relaxed);
+        const auto tail = producer_.tail.load(std::memory_order_relaxed);
+        return (tail > head) ? (tail - head) : 0;
+    }
+
+    size_t GetCapacity() const {
+        return vec_.size();
+    }
+
+private:
+    static size_t Min(size_t a, size_t b) {
+        return (a < b) ? a : b;
+    }
+
+private:
+    // l1 cache line size for most CPUs
+    static constexpr int CACHELINE_SIZE = 64;
+
+    /** indices increase monotonically and are masked when accessing `vec_` */
+    struct ProducerIndex final {
+        std::atomic<size_t> tail;
+        /** a copy of the consumer's head, which may be older than the real one */
+        size_t head_cache;
+        /** the number of slots reserved but not committed */
+        size_t reserved;
+    };
+    struct ConsumerIndex final {
+        std::atomic<size_t> head;
+        /** a copy of the producer's tail, which may be older than the real one */
+        size_t tail_cache;
+        /** the number of items peeked but not released */
+        size_t peeked;
+    };
+
+    union {
+        ProducerIndex producer_;
+        char padding1[CACHELINE_SIZE];
+    };
+    union {
+        ConsumerIndex consumer_;
+        char padding2[CACHELINE_SIZE];
+    };
+    size_t mask_;
+    std::vector<T> vec_;
+
+private:
+    BatchedSPSCRingBuffer(const BatchedSPSCRingBuffer&) = delete;
+    BatchedSPSCRingBuffer(BatchedSPSCRingBuffer&&) = delete;
+    void operator=(const BatchedSPSCRingBuffer&) = delete;
+    void operator=(BatchedSPSCRingBuffer&&) = delete;
+};
+
 }} // namespace ppl::common
 
 #endif
@@ -0,0 +1,123 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "ppl/common/spsc_ring_buffer.h"
+#include <benchmark/benchmark.h>
+#include <thread>
+#include <vector>
+using namespace std;
+using namespace ppl::common;
+
+static constexpr uint32_t ITEM_NUM = 1 << 20;
+static constexpr uint32_t QUEUE_SIZE = 1024;
+
+/** a producer thread pushes ITEM_NUM items one by one while the current thread pops them */
+template <typename QueueType>
+static void BM_SPSCPushPop(benchmark::State& state) {
+    for (auto _ : state) {
+        QueueType queue(QUEUE_SIZE);
+        thread producer([&queue]() {
+            for (uint32_t i = 0; i < ITEM_NUM; ++i) {
+                while (!queue.Push(i)) {
+                    this_thread::yield();
+                }
+            }
+        });
+        uint32_t value;
+        for (uint32_t i = 0; i < ITEM_NUM; ++i) {
+            while (!queue.Pop(&value)) {
+                this_thread::yield();
+            }
+            benchmark::DoNotOptimize(value);
+        }
+        producer.join();
+    }
+    state.SetItemsProcessed(state.iterations() * ITEM_NUM);
+}
+
+/** like `BM_SPSCPushPop` but moves `state.range(0)` items per call */
+static void BM_SPSCPushNPopN(benchmark::State& state) {
+    const uint32_t batch_size = state.range(0);
+    for (auto _ : state) {
+        BatchedSPSCRingBuffer<uint32_t> queue(QUEUE_SIZE);
+        thread producer([&queue, batch_size]() {
+            vector<uint32_t> batch(batch_size);
+            for (uint32_t i = 0; i < ITEM_NUM;) {
+                for (uint32_t j = 0; j < batch_size; ++j) {
+                    batch[j] = i + j;
+                }
+                const size_t pushed = queue.PushN(batch.data(), batch_size);
+                if (pushed == 0) {
+                    this_thread::yield();
+                }
+                i += pushed;
+            }
+        });
+        vector<uint32_t> batch(batch_size);
+        for (uint32_t i = 0; i < ITEM_NUM;) {
+            const size_t popped = queue.PopN(batch.data(), batch_size);
+            if (popped == 0) {
+                this_thread::yield();
+            }
+            benchmark::DoNotOptimize(batch.data());
+            i += popped;
+        }
+        producer.join();
+    }
+    state.SetItemsProcessed(state.iterations() * ITEM_NUM);
+}
+
+/** writes and reads items in place by `Reserve()`/`Commit()` and `Peek()`/`Release()` */
+static void BM_SPSCReserveCommit(benchmark::State& state) {
+    const uint32_t batch_size = state.range(0);
+    for (auto _ : state) {
+        BatchedSPSCRingBuffer<uint32_t> queue(QUEUE_SIZE);
+        thread producer([&queue, batch_size]() {
+            for (uint32_t i = 0; i < ITEM_NUM;) {
+                uint32_t* slots;
+                const size_t n = queue.Reserve(batch_size, &slots);
+                if (n == 0) {
+                    this_thread::yield();
+                    continue;
+                }
+                for (size_t j = 0; j < n; ++j) {
+                    slots[j] = i + j;
+                }
+                queue.Commit(n);
+                i += n;
+            }
+        });
+        for (uint32_t i = 0; i < ITEM_NUM;) {
+            uint32_t* items;
+            const size_t n = queue.Peek(batch_size, &items);
+            if (n == 0) {
+                this_thread::yield();
+                continue;
+            }
+            benchmark::DoNotOptimize(items[n - 1]);
+            queue.Release(n);
+            i += n;
+        }
+        producer.join();
+    }
+    state.SetItemsProcessed(state.iterations() * ITEM_NUM);
+}
+
+BENCHMARK_TEMPLATE(BM_SPSCPushPop, SPSCRingBuffer<uint32_t>)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_SPSCPushPop, BatchedSPSCRingBuffer<uint32_t>)->UseRealTime();
+BENCHMARK(BM_SPSCPushNPopN)->RangeMultiplier(4)->Range(4, 256)->UseRealTime();
+BENCHMARK(BM_SPSCReserveCommit)->RangeMultiplier(4)->Range(4, 256)->UseRealTime();
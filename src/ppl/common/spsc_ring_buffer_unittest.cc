@@ -75,4 +75,118 @@ TEST(SPSCRingBufferTest, empty_full) {
         queue.Push(i);
     }
     ASSERT_EQ(queue.IsFull(), true);
-}
\ No newline at end of file
+}
+
+TEST(BatchedSPSCRingBufferTest, empty_full) {
+    BatchedSPSCRingBuffer<int> queue(100);
+    ASSERT_EQ(128u, queue.GetCapacity());
+    ASSERT_TRUE(queue.IsEmpty());
+
+    for (int i = 0; i < 128; ++i) {
+        ASSERT_TRUE(queue.Push(i));
+    }
+    ASSERT_TRUE(queue.IsFull());
+    ASSERT_FALSE(queue.Push(128));
+
+    int value;
+    for (int i = 0; i < 128; ++i) {
+        ASSERT_TRUE(queue.Pop(&value));
+        ASSERT_EQ(i, value);
+    }
+    ASSERT_TRUE(queue.IsEmpty());
+    ASSERT_FALSE(queue.Pop(&value));
+}
+
+TEST(BatchedSPSCRingBufferTest, reserve_commit) {
+    BatchedSPSCRingBuffer<int> queue(8);
+
+    // moves indices close to the end of the buffer
+    int items[8];
+    for (int i = 0; i < 6; ++i) {
+        items[i] = i;
+    }
+    ASSERT_EQ(6u, queue.PushN(items, 6));
+    ASSERT_EQ(6u, queue.PopN(items, 8));
+
+    // only the contiguous part before the end is returned
+    int* slots;
+    ASSERT_EQ(2u, queue.Reserve(5, &slots));
+    slots[0] = 10;
+    slots[1] = 11;
+    ASSERT_EQ(3u, queue.Reserve(3, &slots));
+    slots[0] = 12;
+    slots[1] = 13;
+    slots[2] = 14;
+
+    // nothing is visible before `Commit()`
+    int* peeked;
+    ASSERT_EQ(0u, queue.Peek(8, &peeked));
+    queue.Commit(5);
+    ASSERT_EQ(5u, queue.Size());
+
+    ASSERT_EQ(2u, queue.Peek(8, &peeked));
+    ASSERT_EQ(10, peeked[0]);
+    ASSERT_EQ(11, peeked[1]);
+    ASSERT_EQ(3u, queue.Peek(8, &peeked));
+    ASSERT_EQ(12, peeked[0]);
+    ASSERT_EQ(14, peeked[2]);
+    ASSERT_EQ(5u, queue.Size());
+    queue.Release(5);
+    ASSERT_TRUE(queue.IsEmpty());
+
+    // PushN() stops when the queue is full
+    for (int i = 0; i < 8; ++i) {
+        items[i] = i;
+    }
+    ASSERT_EQ(8u, queue.PushN(items, 8));
+    ASSERT_EQ(0u, queue.PushN(items, 1));
+    ASSERT_EQ(0u, queue.Reserve(1, &slots));
+}
+
+TEST(BatchedSPSCRingBufferTest, batched) {
+    const uint32_t n = 100000;
+    BatchedSPSCRingBuffer<uint32_t> queue(64);
+
+    std::thread producer([&queue]() {
+        std::default_random_engine gen(0);
+        std::uniform_int_distribution<uint32_t> dis(1, 40);
+        std::vector<uint32_t> batch(40);
+        uint32_t next = 0;
+        while (next < n) {
+            uint32_t num = dis(gen);
+            if (num > n - next) {
+                num = n - next;
+            }
+            if (num % 2) {
+                for (uint32_t i = 0; i < num; ++i) {
+                    batch[i] = next + i;
+                }
+                next += queue.PushN(batch.data(), num);
+            } else {
+                uint32_t* slots;
+                const size_t reserved = queue.Reserve(num, &slots);
+                for (size_t i = 0; i < reserved; ++i) {
+                    slots[i] = next + i;
+                }
+                queue.Commit(reserved);
+                next += reserved;
+            }
+            std::this_thread::yield();
+        }
+    });
+
+    std::vector<uint32_t> received;
+    std::vector<uint32_t> batch(32);
+    while (received.size() < n) {
+        const size_t popped = queue.PopN(batch.data(), batch.size());
+        received.insert(received.end(), batch.begin(), batch.begin() + popped);
+        if (popped == 0) {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+
+    for (uint32_t i = 0; i < n; ++i) {
+        ASSERT_EQ(i, received[i]);
+    }
+}
@@ -0,0 +1,238 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "ppl/common/task_graph.h"
+#include "ppl/common/futex_wrapper.h"
+#include <new>
+using namespace std;
+
+namespace ppl { namespace common {
+
+class TaskGraph::NodeTask final : public ThreadTask {
+public:
+    NodeTask(TaskGraph* graph, NodeId id) : graph_(graph), id_(id) {}
+    shared_ptr<ThreadTask> Run() override {
+        auto next = graph_->RunNode(id_);
+        return (next ? next->task : shared_ptr<ThreadTask>());
+    }
+
+private:
+    TaskGraph* graph_;
+    NodeId id_;
+};
+
+class TaskGraph::IntrusiveNodeTask final : public IntrusiveThreadTask {
+public:
+    IntrusiveNodeTask(TaskGraph* graph, NodeId id) : graph_(graph), id_(id) {}
+    IntrusiveThreadTask* Run() override {
+        auto next = graph_->RunNode(id_);
+        return (next ? next->intrusive_task.get() : nullptr);
+    }
+
+private:
+    TaskGraph* graph_;
+    NodeId id_;
+};
+
+TaskGraph::TaskGraph() : remaining_(0), status_(RC_SUCCESS), dirty_(false), use_intrusive_(false), pool_(nullptr) {}
+
+TaskGraph::~TaskGraph() {}
+
+RetCode TaskGraph::AddNode(const function<void()>& f, NodeId* id) {
+    const NodeId new_id = nodes_.size();
+    unique_ptr<Node> node(new (std::nothrow) Node());
+    if (!node) {
+        return RC_OUT_OF_MEMORY;
+    }
+    auto task = new (std::nothrow) NodeTask(this, new_id);
+    if (!task) {
+        return RC_OUT_OF_MEMORY;
+    }
+    node->task.reset(task);
+    node->intrusive_task.reset(new (std::nothrow) IntrusiveNodeTask(this, new_id));
+    if (!node->intrusive_task) {
+        return RC_OUT_OF_MEMORY;
+    }
+
+    node->f = f;
+    node->pending.store(0, std::memory_order_relaxed);
+    node->skipped.store(false, std::memory_order_relaxed);
+    nodes_.emplace_back(std::move(node));
+    dirty_ = true;
+    *id = new_id;
+    return RC_SUCCESS;
+}
+
+RetCode TaskGraph::AddEdge(NodeId from, NodeId to) {
+    if (from >= nodes_.size() || to >= nodes_.size() || from == to) {
+        return RC_INVALID_VALUE;
+    }
+
+    nodes_[from]->successors.push_back(to);
+    ++nodes_[to]->nr_predecessors;
+    dirty_ = true;
+    return RC_SUCCESS;
+}
+
+/** finds root nodes and checks whether there is a cycle */
+RetCode TaskGraph::Prepare() {
+    roots_.clear();
+
+    vector<uint32_t> in_degree(nodes_.size());
+    vector<NodeId> ready;
+    for (NodeId i = 0; i < nodes_.size(); ++i) {
+        in_degree[i] = nodes_[i]->nr_predecessors;
+        if (in_degree[i] == 0) {
+            roots_.push_back(i);
+            ready.push_back(i);
+        }
+    }
+
+    uint32_t visited = 0;
+    while (!ready.empty()) {
+        auto id = ready.back();
+        ready.pop_back();
+        ++visited;
+        auto& successors = nodes_[id]->successors;
+        for (auto s = successors.begin(); s != successors.end(); ++s) {
+            if (--in_degree[*s] == 0) {
+                ready.push_back(*s);
+            }
+        }
+    }
+
+    if (visited != nodes_.size()) {
+        roots_.clear();
+        return RC_INVALID_VALUE;
+    }
+
+    dirty_ = false;
+    return RC_SUCCESS;
+}
+
+RetCode TaskGraph::RunAsync(ThreadPool* pool) {
+    if (dirty_) {
+        auto rc = Prepare();
+        if (rc != RC_SUCCESS) {
+            return rc;
+        }
+    }
+
+    if (nodes_.empty()) {
+        return RC_SUCCESS;
+    }
+
+    pool_ = pool;
+    use_intrusive_ = pool->IsIntrusiveTaskSupported();
+    for (auto n = nodes_.begin(); n != nodes_.end(); ++n) {
+        (*n)->pending.store((*n)->nr_predecessors, std::memory_order_relaxed);
+        (*n)->skipped.store(false, std::memory_order_relaxed);
+    }
+    status_.store(RC_SUCCESS, std::memory_order_relaxed);
+    remaining_.store(nodes_.size(), std::memory_order_release);
+
+    for (auto r = roots_.begin(); r != roots_.end(); ++r) {
+        auto rc = Submit(nodes_[*r].get());
+        if (rc != RC_SUCCESS) {
+            // submitted nodes may depend on the rest of roots. they are finished before returning.
+            SetError(rc);
+            for (; r != roots_.end(); ++r) {
+                Skip(nodes_[*r].get());
+            }
+            Wait();
+            return rc;
+        }
+    }
+
+    return RC_SUCCESS;
+}
+
+RetCode TaskGraph::Wait() {
+    while (true) {
+        const uint32_t remaining = remaining_.load(std::memory_order_acquire);
+        if (remaining == 0) {
+            break;
+        }
+        FutexWait(reinterpret_cast<uint32_t*>(&remaining_), remaining);
+    }
+    return (RetCode)status_.load(std::memory_order_relaxed);
+}
+
+RetCode TaskGraph::Submit(Node* node) {
+    if (use_intrusive_) {
+        return pool_->AddTask(node->intrusive_task.get());
+    }
+    return pool_->AddTask(node->task);
+}
+
+TaskGraph::Node* TaskGraph::RunNode(NodeId id) {
+    auto node = nodes_[id].get();
+    node->f();
+
+    // the first ready successor runs right after this node in the current thread
+    Node* next = nullptr;
+    for (auto s = node->successors.begin(); s != node->successors.end(); ++s) {
+        auto successor = nodes_[*s].get();
+        if (successor->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            if (successor->skipped.load(std::memory_order_relaxed)) {
+                Skip(successor);
+            } else if (!next) {
+                next = successor;
+            } else {
+                auto rc = Submit(successor);
+                if (rc != RC_SUCCESS) {
+                    SetError(rc);
+                    Skip(successor);
+                }
+            }
+        }
+    }
+
+    FinishNode();
+    return next;
+}
+
+void TaskGraph::Skip(Node* node) {
+    vector<Node*> ready(1, node);
+    while (!ready.empty()) {
+        auto n = ready.back();
+        ready.pop_back();
+        for (auto s = n->successors.begin(); s != n->successors.end(); ++s) {
+            auto successor = nodes_[*s].get();
+            // visible to the one that counts `pending` down to 0
+            successor->skipped.store(true, std::memory_order_relaxed);
+            if (successor->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                ready.push_back(successor);
+            }
+        }
+        FinishNode();
+    }
+}
+
+void TaskGraph::FinishNode() {
+    if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        // the graph may be destroyed after `remaining_` reaches 0. a futex wake on its address is harmless.
+        FutexWakeAll(reinterpret_cast<uint32_t*>(&remaining_));
+    }
+}
+
+void TaskGraph::SetError(RetCode rc) {
+    uint32_t expected = RC_SUCCESS;
+    status_.compare_exchange_strong(expected, rc, std::memory_order_relaxed);
+}
+
+}} // namespace ppl::common
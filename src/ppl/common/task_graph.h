@@ -0,0 +1,122 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef _ST_HPC_PPL_COMMON_TASK_GRAPH_H_
+#define _ST_HPC_PPL_COMMON_TASK_GRAPH_H_
+
+#include "ppl/common/retcode.h"
+#include "ppl/common/threadpool.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace ppl { namespace common {
+
+/**
+   a DAG of tasks executed by a `ThreadPool`. each node keeps an atomic counter of unfinished predecessors.
+   the worker that finishes the last predecessor of a node runs it as a continuation or pushes it to the pool
+   from the worker thread, which lands in the worker's own deque in SCHED_WORK_STEALING and SCHED_NUMA
+   modes. no thread blocks on joins except the one calling `Wait()`.
+
+   a graph can be run many times. nothing is allocated by the graph itself in runs after the first one
+   unless nodes or edges are changed. nodes are submitted as `IntrusiveThreadTask`s if the pool supports
+   them, so that the pool allocates nothing either.
+*/
+
+class TaskGraph final {
+public:
+    typedef uint32_t NodeId;
+
+public:
+    TaskGraph();
+    ~TaskGraph();
+
+    /** @param id id of the new node, which is used by `AddEdge()` */
+    ppl::common::RetCode AddNode(const std::function<void()>& f, NodeId* id);
+    /** `to` will run after `from` is finished */
+    ppl::common::RetCode AddEdge(NodeId from, NodeId to);
+    uint32_t GetNodeNum() const {
+        return nodes_.size();
+    }
+
+    /**
+       @brief submits root nodes to `pool` and returns immediately.
+       @note callers MUST make sure that the last run is finished before starting another new one.
+       @return RC_INVALID_VALUE if there is a cycle. if a root cannot be submitted, the nodes that depend on it are
+       skipped, and the error is returned after the submitted ones are finished.
+    */
+    ppl::common::RetCode RunAsync(ThreadPool* pool);
+    /**
+       @brief waits for the last run to finish.
+       @return the first error of submitting nodes to the pool. nodes that depend on a node which cannot be
+       submitted are skipped.
+    */
+    ppl::common::RetCode Wait();
+
+    ppl::common::RetCode Run(ThreadPool* pool) {
+        auto rc = RunAsync(pool);
+        if (rc != ppl::common::RC_SUCCESS) {
+            return rc;
+        }
+        return Wait();
+    }
+
+private:
+    class NodeTask;
+    class IntrusiveNodeTask;
+
+    struct Node final {
+        std::function<void()> f;
+        std::vector<NodeId> successors;
+        uint32_t nr_predecessors = 0;
+        std::atomic<uint32_t> pending;
+        /** set if a predecessor is skipped in the current run */
+        std::atomic<bool> skipped;
+        std::shared_ptr<ThreadTask> task;
+        std::unique_ptr<IntrusiveNodeTask> intrusive_task;
+    };
+
+    ppl::common::RetCode Prepare();
+    ppl::common::RetCode Submit(Node*);
+    /** returns the first successor that becomes ready, or nullptr */
+    Node* RunNode(NodeId);
+    /** finishes `node` and its descendants that become ready without running them */
+    void Skip(Node* node);
+    /** counts down `remaining_`. the graph may be destroyed after the last node is finished. */
+    void FinishNode();
+    void SetError(ppl::common::RetCode);
+
+private:
+    std::vector<std::unique_ptr<Node>> nodes_;
+    std::vector<NodeId> roots_;
+    std::atomic<uint32_t> remaining_; // unfinished nodes of the current run. also a futex word.
+    std::atomic<uint32_t> status_; // the first error of the current run
+    bool dirty_;
+    bool use_intrusive_;
+    ThreadPool* pool_;
+
+private:
+    TaskGraph(const TaskGraph&) = delete;
+    TaskGraph(TaskGraph&&) = delete;
+    void operator=(const TaskGraph&) = delete;
+    void operator=(TaskGraph&&) = delete;
+};
+
+}} // namespace ppl::common
+
+#endif
@@ -0,0 +1,84 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "ppl/common/task_graph.h"
+#include "gtest/gtest.h"
+#include <atomic>
+#include <vector>
+
+using namespace std;
+using namespace ppl::common;
+
+TEST(TaskGraphTest, diamond) {
+    ThreadPool tp;
+    ASSERT_EQ(RC_SUCCESS, tp.Init(4, ThreadPool::SCHED_WORK_STEALING));
+
+    // a -> {b0, b1, ..., b7} -> c
+    atomic<uint32_t> seq(0);
+    uint32_t a_order = 0, c_order = 0;
+    vector<uint32_t> b_order(8);
+
+    TaskGraph graph;
+    TaskGraph::NodeId a, c;
+    ASSERT_EQ(RC_SUCCESS, graph.AddNode(
+                              [&]() {
+                                  a_order = seq.fetch_add(1);
+                              },
+                              &a));
+    ASSERT_EQ(RC_SUCCESS, graph.AddNode(
+                              [&]() {
+                                  c_order = seq.fetch_add(1);
+                              },
+                              &c));
+    for (uint32_t i = 0; i < b_order.size(); ++i) {
+        TaskGraph::NodeId b;
+        ASSERT_EQ(RC_SUCCESS, graph.AddNode(
+                                  [&, i]() {
+                                      b_order[i] = seq.fetch_add(1);
+                                  },
+                                  &b));
+        ASSERT_EQ(RC_SUCCESS, graph.AddEdge(a, b));
+        ASSERT_EQ(RC_SUCCESS, graph.AddEdge(b, c));
+    }
+
+    // reusable
+    for (uint32_t r = 0; r < 10; ++r) {
+        seq.store(0);
+        ASSERT_EQ(RC_SUCCESS, graph.Run(&tp));
+        ASSERT_EQ(graph.GetNodeNum(), seq.load());
+        ASSERT_EQ(0, a_order);
+        ASSERT_EQ(graph.GetNodeNum() - 1, c_order);
+        for (uint32_t i = 0; i < b_order.size(); ++i) {
+            ASSERT_GT(b_order[i], a_order);
+            ASSERT_LT(b_order[i], c_order);
+        }
+    }
+}
+
+TEST(TaskGraphTest, cycle) {
+    ThreadPool tp;
+    ASSERT_EQ(RC_SUCCESS, tp.Init(2));
+
+    TaskGraph graph;
+    TaskGraph::NodeId a, b;
+    ASSERT_EQ(RC_SUCCESS, graph.AddNode([]() {}, &a));
+    ASSERT_EQ(RC_SUCCESS, graph.AddNode([]() {}, &b));
+    ASSERT_EQ(RC_SUCCESS, graph.AddEdge(a, b));
+    ASSERT_EQ(RC_SUCCESS, graph.AddEdge(b, a));
+    ASSERT_EQ(RC_INVALID_VALUE, graph.Run(&tp));
+    ASSERT_EQ(RC_INVALID_VALUE, graph.AddEdge(a, a));
+}
@@ -16,7 +16,20 @@
 // under the License.
 
 #include "ppl/common/threadpool.h"
+#include "ppl/common/work_stealing_deque.h"
+#include "ppl/common/mpsc_queue.h"
+#include "ppl/common/event_count.h"
+#include "ppl/common/object_pool.h"
+#include "ppl/common/log.h"
+#include "ppl/common/futex_wrapper.h"
+#include "ppl/common/timer_wheel.h"
+#include "ppl/common/cpu_relax.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstdlib>
+#include <new>
+#include <thread>
 using namespace std;
 
 #ifndef _MSC_VER
@@ -66,12 +79,872 @@ struct ThreadArg final {
     pthread_mutex_t* mutex_for_init;
     pthread_cond_t* cond_for_init;
     ThreadPool::ThreadInfo* info;
+    ThreadPool* pool;
     ThreadTaskQueue* queue;
+    uint32_t thread_idx;
+    const vector<uint32_t>* cpus; // pins the thread to these cpus if not null
 };
 
+static RetCode SetCurrentThreadAffinity(const vector<uint32_t>& cpus) {
+#ifdef _MSC_VER
+    DWORD_PTR cpu_set = 0;
+    for (auto c = cpus.begin(); c != cpus.end(); ++c) {
+        if (*c >= sizeof(DWORD_PTR) * 8) {
+            return RC_INVALID_VALUE;
+        }
+        cpu_set |= ((DWORD_PTR)1 << *c);
+    }
+    return (SetThreadAffinityMask(GetCurrentThread(), cpu_set) != 0) ? RC_SUCCESS : RC_OTHER_ERROR;
+#elif !defined(__APPLE__) && !defined(__QNX__)
+    uint32_t max_cpu_id = 0;
+    for (auto c = cpus.begin(); c != cpus.end(); ++c) {
+        if (*c > max_cpu_id) {
+            max_cpu_id = *c;
+        }
+    }
+
+    cpu_set_t* cpu_set = CPU_ALLOC(max_cpu_id + 1);
+    if (!cpu_set) {
+        return RC_OUT_OF_MEMORY;
+    }
+
+    const size_t cpu_setsize = CPU_ALLOC_SIZE(max_cpu_id + 1);
+    CPU_ZERO_S(cpu_setsize, cpu_set);
+    for (auto c = cpus.begin(); c != cpus.end(); ++c) {
+        CPU_SET_S(*c, cpu_setsize, cpu_set);
+    }
+
+    // 0 means the calling thread
+    const bool ok = (sched_setaffinity(0, cpu_setsize, cpu_set) == 0);
+    CPU_FREE(cpu_set);
+    return (ok ? RC_SUCCESS : RC_OTHER_ERROR);
+#else
+    return RC_UNSUPPORTED;
+#endif
+}
+
+/** wraps a `ThreadTask` for modes supporting intrusive tasks */
+struct ThreadPool::TaskNode final : public IntrusiveThreadTask {
+    TaskNode(const shared_ptr<ThreadTask>& t) : task(t) {}
+
+    IntrusiveThreadTask* Run() override {
+        auto next = task->Run();
+        if (next) {
+            // reuses this node for the continuation
+            task = std::move(next);
+            return this;
+        }
+        delete this;
+        return nullptr;
+    }
+
+    shared_ptr<ThreadTask> task;
+};
+
+/* the pool and the index of the current thread if it is a worker thread */
+static thread_local ThreadPool* g_current_pool = nullptr;
+static thread_local uint32_t g_current_thread_idx = 0;
+
+/**
+   `FuncTask`s are allocated by the owner of a cache only, i.e. a worker thread or non-worker threads holding
+   `lock`. tasks released by the owner go back to `pool`, while tasks released by other threads are pushed to
+   `remote_free` and reused by the owner later.
+*/
+struct ThreadPool::FuncTaskCache final {
+    FuncTaskCache(ThreadPool* p, uint32_t idx) : owner_pool(p), owner_idx(idx) {
+        pthread_mutex_init(&lock, nullptr);
+    }
+    ~FuncTaskCache() {
+        pthread_mutex_destroy(&lock);
+    }
+
+    FuncTask* Alloc() {
+        bool is_empty;
+        auto task = static_cast<FuncTask*>(remote_free.Pop(&is_empty));
+        if (!task) {
+            task = pool.Alloc();
+            if (!task) {
+                return nullptr;
+            }
+        }
+        task->cache = this;
+        return task;
+    }
+
+    void Free(FuncTask* task) {
+        if (g_current_pool == owner_pool && g_current_thread_idx == owner_idx) {
+            pool.Free(task);
+        } else {
+            remote_free.Push(task);
+        }
+    }
+
+    ObjectPool<FuncTask> pool;
+    MPSCQueue remote_free;
+    ThreadPool* owner_pool;
+    uint32_t owner_idx; // UINT32_MAX for non-worker threads
+    pthread_mutex_t lock; // used by non-worker threads
+};
+
+IntrusiveThreadTask* ThreadPool::FuncTask::Run() {
+    invoke(&storage);
+    cache->Free(this);
+    return nullptr;
+}
+
+static inline uint64_t GetTimeNs() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct ThreadPool::WorkStealingContext final {
+    // l1 cache line size for most CPUs
+    static constexpr int CACHELINE_SIZE = 64;
+
+    struct Worker final {
+        WorkStealingDeque<IntrusiveThreadTask> deque;
+        uint32_t group;
+        uint32_t rand_state;
+        uint32_t nr_searches = 0; // for priority aging
+    };
+
+    /** tasks added by non-worker threads. consumers take turns so that it is popped by one thread at a time. */
+    struct InjectQueue final {
+        InjectQueue() : size(0), locked(false) {}
+
+        void Push(IntrusiveThreadTask* node) {
+            queue.Push(node);
+            size.fetch_add(1, std::memory_order_release);
+        }
+
+        IntrusiveThreadTask* Pop() {
+            if (size.load(std::memory_order_acquire) == 0) {
+                return nullptr;
+            }
+            if (locked.exchange(true, std::memory_order_acquire)) {
+                return nullptr;
+            }
+
+            bool is_empty = true;
+            MPSCQueue::Node* node;
+            do {
+                node = queue.Pop(&is_empty);
+            } while (!node && !is_empty);
+
+            locked.store(false, std::memory_order_release);
+
+            if (node) {
+                size.fetch_sub(1, std::memory_order_relaxed);
+            }
+            return static_cast<IntrusiveThreadTask*>(node);
+        }
+
+        MPSCQueue queue;
+        union {
+            std::atomic<uint32_t> size;
+            char padding1[CACHELINE_SIZE];
+        };
+        std::atomic<bool> locked;
+    };
+
+    /** tasks with deadlines, popped earliest deadline first. it is locked only if it is not empty. */
+    struct DeadlineQueue final {
+        struct Entry final {
+            uint64_t deadline_ns;
+            uint64_t seq; // FIFO for the same deadline
+            IntrusiveThreadTask* task;
+        };
+
+        struct Later final {
+            bool operator()(const Entry& a, const Entry& b) const {
+                return (a.deadline_ns > b.deadline_ns || (a.deadline_ns == b.deadline_ns && a.seq > b.seq));
+            }
+        };
+
+        DeadlineQueue() : size(0), seq(0) {
+            pthread_mutex_init(&lock, nullptr);
+        }
+        ~DeadlineQueue() {
+            pthread_mutex_destroy(&lock);
+        }
+
+        void Push(IntrusiveThreadTask* task, uint64_t deadline_ns) {
+            pthread_mutex_lock(&lock);
+            Entry e;
+            e.deadline_ns = deadline_ns;
+            e.seq = seq++;
+            e.task = task;
+            heap.push_back(e);
+            std::push_heap(heap.begin(), heap.end(), Later());
+            size.store(heap.size(), std::memory_order_release);
+            pthread_mutex_unlock(&lock);
+        }
+
+        IntrusiveThreadTask* Pop() {
+            if (size.load(std::memory_order_acquire) == 0) {
+                return nullptr;
+            }
+
+            IntrusiveThreadTask* task = nullptr;
+            pthread_mutex_lock(&lock);
+            if (!heap.empty()) {
+                std::pop_heap(heap.begin(), heap.end(), Later());
+                task = heap.back().task;
+                heap.pop_back();
+                size.store(heap.size(), std::memory_order_relaxed);
+            }
+            pthread_mutex_unlock(&lock);
+            return task;
+        }
+
+        union {
+            std::atomic<uint32_t> size;
+            char padding1[CACHELINE_SIZE];
+        };
+        pthread_mutex_t lock;
+        vector<Entry> heap;
+        uint64_t seq;
+    };
+
+    /**
+       workers in the same group (the same numa node in SCHED_NUMA mode) share inject queues,
+       and steal from each other before stealing from other groups.
+    */
+    struct Group final {
+        InjectQueue inject_queues[PRIORITY_NUM];
+        DeadlineQueue deadline_queues[PRIORITY_NUM];
+        vector<uint32_t> worker_idx;
+    };
+
+    WorkStealingContext(ThreadPool* pool, const vector<uint32_t>& group_thread_num) : stop(false) {
+        for (uint32_t g = 0; g < group_thread_num.size(); ++g) {
+            groups.emplace_back(new Group());
+            for (uint32_t i = 0; i < group_thread_num[g]; ++i) {
+                const uint32_t idx = workers.size();
+                workers.emplace_back(new Worker());
+                workers[idx]->group = g;
+                workers[idx]->rand_state = idx + 1;
+                groups[g]->worker_idx.push_back(idx);
+                func_task_caches.emplace_back(new FuncTaskCache(pool, idx));
+            }
+        }
+        func_task_caches.emplace_back(new FuncTaskCache(pool, UINT32_MAX));
+    }
+
+    static uint32_t NextRandom(Worker* w) {
+        // xorshift32
+        uint32_t r = w->rand_state;
+        r ^= r << 13;
+        r ^= r >> 17;
+        r ^= r << 5;
+        w->rand_state = r;
+        return r;
+    }
+
+    IntrusiveThreadTask* StealFromGroup(uint32_t thread_idx, Group* g) {
+        const uint32_t nr_workers = g->worker_idx.size();
+        if (nr_workers == 0) {
+            return nullptr;
+        }
+
+        const uint32_t start = NextRandom(workers[thread_idx].get()) % nr_workers;
+        for (uint32_t i = 0; i < nr_workers; ++i) {
+            uint32_t victim = start + i;
+            if (victim >= nr_workers) {
+                victim -= nr_workers;
+            }
+            victim = g->worker_idx[victim];
+            if (victim == thread_idx) {
+                continue;
+            }
+            auto node = workers[victim]->deque.Steal();
+            if (node) {
+                return node;
+            }
+        }
+        return nullptr;
+    }
+
+    /** pops from shared queues of class `p`. tasks with deadlines go first unless `aged` is true. */
+    static IntrusiveThreadTask* PopSharedQueues(Group* g, uint32_t p, bool aged) {
+        IntrusiveThreadTask* task;
+        if (aged) {
+            task = g->inject_queues[p].Pop();
+            return (task ? task : g->deadline_queues[p].Pop());
+        }
+        task = g->deadline_queues[p].Pop();
+        return (task ? task : g->inject_queues[p].Pop());
+    }
+
+    /** looks for tasks of class `p` in the local group first and then in other groups */
+    IntrusiveThreadTask* FindTaskOfClass(uint32_t thread_idx, uint32_t p, bool aged) {
+        auto self = workers[thread_idx].get();
+        auto local_group = groups[self->group].get();
+        const uint32_t nr_groups = groups.size();
+        IntrusiveThreadTask* node;
+
+        if (p != PRIORITY_NORMAL) {
+            for (uint32_t i = 0; i < nr_groups; ++i) {
+                uint32_t g = self->group + i;
+                if (g >= nr_groups) {
+                    g -= nr_groups;
+                }
+                node = PopSharedQueues(groups[g].get(), p, aged);
+                if (node) {
+                    return node;
+                }
+            }
+            return nullptr;
+        }
+
+        // aged searches take tasks from shared queues first, which may starve behind the local deque otherwise
+        if (aged) {
+            node = PopSharedQueues(local_group, p, true);
+            if (node) {
+                return node;
+            }
+            node = self->deque.Pop();
+            if (node) {
+                return node;
+            }
+        } else {
+            node = local_group->deadline_queues[p].Pop();
+            if (node) {
+                return node;
+            }
+            node = self->deque.Pop();
+            if (node) {
+                return node;
+            }
+            node = local_group->inject_queues[p].Pop();
+            if (node) {
+                return node;
+            }
+        }
+        node = StealFromGroup(thread_idx, local_group);
+        if (node) {
+            return node;
+        }
+
+        for (uint32_t i = 1; i < nr_groups; ++i) {
+            uint32_t g = self->group + i;
+            if (g >= nr_groups) {
+                g -= nr_groups;
+            }
+            node = PopSharedQueues(groups[g].get(), p, aged);
+            if (node) {
+                return node;
+            }
+        }
+        for (uint32_t i = 1; i < nr_groups; ++i) {
+            uint32_t g = self->group + i;
+            if (g >= nr_groups) {
+                g -= nr_groups;
+            }
+            node = StealFromGroup(thread_idx, groups[g].get());
+            if (node) {
+                return node;
+            }
+        }
+
+        return nullptr;
+    }
+
+    /** looks for tasks from the highest class to the lowest one, or reversely for aging */
+    IntrusiveThreadTask* FindTask(uint32_t thread_idx) {
+        auto self = workers[thread_idx].get();
+        ++self->nr_searches;
+        IntrusiveThreadTask* node;
+        if (self->nr_searches % PRIORITY_AGING_INTERVAL == 0) {
+            for (uint32_t p = PRIORITY_NUM; p > 0; --p) {
+                node = FindTaskOfClass(thread_idx, p - 1, true);
+                if (node) {
+                    return node;
+                }
+            }
+            return nullptr;
+        }
+
+        for (uint32_t p = 0; p < PRIORITY_NUM; ++p) {
+            node = FindTaskOfClass(thread_idx, p, false);
+            if (node) {
+                return node;
+            }
+        }
+        return nullptr;
+    }
+
+    bool HasPendingTasks() const {
+        for (auto g = groups.begin(); g != groups.end(); ++g) {
+            for (uint32_t p = 0; p < PRIORITY_NUM; ++p) {
+                if ((*g)->inject_queues[p].size.load(std::memory_order_acquire) > 0 ||
+                    (*g)->deadline_queues[p].size.load(std::memory_order_acquire) > 0) {
+                    return true;
+                }
+            }
+        }
+        for (auto w = workers.begin(); w != workers.end(); ++w) {
+            if (!(*w)->deque.IsEmpty()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    vector<unique_ptr<Worker>> workers;
+    vector<unique_ptr<Group>> groups;
+    // one for each worker, and the last one is shared by non-worker threads
+    vector<unique_ptr<FuncTaskCache>> func_task_caches;
+    std::atomic<bool> stop;
+    EventCount event_count;
+};
+
+struct ThreadPool::ElasticContext final {
+    // l1 cache line size for most CPUs
+    static constexpr int CACHELINE_SIZE = 64;
+
+    enum {
+        SLOT_STOPPED, // no thread or the thread is joined
+        SLOT_RUNNING,
+        SLOT_RETIRED, // the thread exited and is waiting to be joined
+    };
+
+    /** written by the thread in this slot only, except `state` */
+    struct Slot final {
+        Slot()
+            : state(SLOT_STOPPED)
+            , idle(false)
+            , since_ns(0)
+            , busy_ns(0)
+            , idle_ns(0)
+            , task_num(0)
+            , start_num(0)
+            , retire_num(0) {}
+
+        std::atomic<uint32_t> state;
+        std::atomic<bool> idle;
+        std::atomic<uint64_t> since_ns; // when the thread became busy or idle
+        std::atomic<uint64_t> busy_ns;
+        std::atomic<uint64_t> idle_ns;
+        std::atomic<uint64_t> task_num;
+        std::atomic<uint32_t> start_num;
+        std::atomic<uint32_t> retire_num;
+        char padding[CACHELINE_SIZE];
+    };
+
+    ElasticContext(const ElasticOptions& opt)
+        : options(opt), running_num(0), idle_num(0), controller_parked(false), controller_word(0), stop(false) {
+        for (uint32_t i = 0; i < opt.max_thread_num; ++i) {
+            slots.emplace_back(new Slot());
+        }
+    }
+
+    void OnThreadStart(uint32_t idx) {
+        auto slot = slots[idx].get();
+        slot->since_ns.store(GetTimeNs(), std::memory_order_relaxed);
+        slot->idle.store(false, std::memory_order_relaxed);
+    }
+
+    void MarkIdle(uint32_t idx) {
+        auto slot = slots[idx].get();
+        const uint64_t now = GetTimeNs();
+        const uint64_t since = slot->since_ns.load(std::memory_order_relaxed);
+        slot->busy_ns.store(slot->busy_ns.load(std::memory_order_relaxed) + (now - since), std::memory_order_relaxed);
+        slot->since_ns.store(now, std::memory_order_relaxed);
+        slot->idle.store(true, std::memory_order_relaxed);
+        idle_num.fetch_add(1, std::memory_order_seq_cst);
+    }
+
+    void MarkBusy(uint32_t idx) {
+        auto slot = slots[idx].get();
+        idle_num.fetch_sub(1, std::memory_order_seq_cst);
+        const uint64_t now = GetTimeNs();
+        const uint64_t since = slot->since_ns.load(std::memory_order_relaxed);
+        slot->idle_ns.store(slot->idle_ns.load(std::memory_order_relaxed) + (now - since), std::memory_order_relaxed);
+        slot->since_ns.store(now, std::memory_order_relaxed);
+        slot->idle.store(false, std::memory_order_relaxed);
+    }
+
+    /** keeps at least `min_thread_num` threads running */
+    bool TryRetire() {
+        uint32_t n = running_num.load(std::memory_order_relaxed);
+        while (n > options.min_thread_num) {
+            if (running_num.compare_exchange_weak(n, n - 1, std::memory_order_acq_rel)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void WakeController() {
+        controller_word.fetch_add(1, std::memory_order_release);
+        FutexWakeOne(reinterpret_cast<uint32_t*>(&controller_word));
+    }
+
+    ElasticOptions options;
+    vector<unique_ptr<Slot>> slots;
+    std::atomic<uint32_t> running_num;
+    std::atomic<uint32_t> idle_num;
+    std::atomic<bool> controller_parked;
+    std::atomic<uint32_t> controller_word; // futex word
+    std::atomic<bool> stop;
+    pthread_t controller;
+};
+
+#ifdef PPLCOMMON_ENABLE_THREADPOOL_STATS
+struct ThreadPool::ThreadStats final {
+    // l1 cache line size for most CPUs
+    static constexpr int CACHELINE_SIZE = 64;
+
+    ThreadStats() : task_num(0) {}
+
+    /** returns the time when the task starts */
+    uint64_t OnTaskStart(uint64_t* enqueue_ns, uint64_t depth) {
+        const uint64_t now = GetTimeNs();
+        if (*enqueue_ns > 0) {
+            wait_ns.Record((now > *enqueue_ns) ? (now - *enqueue_ns) : 0);
+            // continuations reusing the task are not counted
+            *enqueue_ns = 0;
+        }
+        queue_depth.Record(depth);
+        return now;
+    }
+
+    /** returns the time when the task ends */
+    uint64_t OnTaskEnd(uint64_t start_ns) {
+        const uint64_t now = GetTimeNs();
+        run_ns.Record(now - start_ns);
+        task_num.store(task_num.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return now;
+    }
+
+    void GetSnapshot(ThreadPoolThreadStats* res) const {
+        res->task_num = task_num.load(std::memory_order_relaxed);
+        queue_depth.GetSnapshot(&res->queue_depth);
+        wait_ns.GetSnapshot(&res->wait_ns);
+        run_ns.GetSnapshot(&res->run_ns);
+    }
+
+    std::atomic<uint64_t> task_num;
+    LogHistogram queue_depth;
+    LogHistogram wait_ns;
+    LogHistogram run_ns;
+    char padding[CACHELINE_SIZE];
+};
+#endif
+
+struct ThreadPool::TimerContext final {
+    struct Entry final : public TimerWheel::Timer {
+        shared_ptr<ThreadTask> task;
+        uint64_t period_ticks; // 0 for one-shot timers
+        uint32_t queue_idx;
+        uint32_t idx; // index in `entries`
+        uint32_t generation; // changed when the entry is released, so that stale ids are rejected
+    };
+
+    TimerContext(ThreadPool* p) : pool(p), base_ns(GetTimeNs()), next_event_tick(UINT64_MAX), word(0), stop(false) {
+        pthread_mutex_init(&lock, nullptr);
+    }
+    ~TimerContext() {
+        pthread_mutex_destroy(&lock);
+    }
+
+    uint64_t GetCurrentTick() const {
+        return (GetTimeNs() - base_ns) / ((uint64_t)TIMER_TICK_US * 1000);
+    }
+
+    static uint64_t GetTimerId(const Entry* entry) {
+        return ((uint64_t)entry->generation << 32) | entry->idx;
+    }
+
+    Entry* AllocEntry() {
+        if (!free_entries.empty()) {
+            auto entry = entries[free_entries.back()].get();
+            free_entries.pop_back();
+            return entry;
+        }
+
+        auto entry = new (std::nothrow) Entry();
+        if (!entry) {
+            return nullptr;
+        }
+        entry->idx = entries.size();
+        entry->generation = 1;
+        entries.emplace_back(entry);
+        return entry;
+    }
+
+    void FreeEntry(Entry* entry) {
+        entry->task.reset();
+        ++entry->generation;
+        free_entries.push_back(entry->idx);
+    }
+
+    /** MUST be called with `lock` held. returns true if the timer thread should be woken up. */
+    bool Schedule(Entry* entry, uint64_t expire_tick) {
+        wheel.Add(entry, expire_tick);
+        if (entry->expire_tick < next_event_tick) {
+            next_event_tick = entry->expire_tick;
+            word.fetch_add(1, std::memory_order_release);
+            return true;
+        }
+        return false;
+    }
+
+    void Wake() {
+        FutexWakeOne(reinterpret_cast<uint32_t*>(&word));
+    }
+
+    ThreadPool* pool;
+    uint64_t base_ns;
+    pthread_mutex_t lock; // protects fields below
+    TimerWheel wheel;
+    vector<unique_ptr<Entry>> entries;
+    vector<uint32_t> free_entries;
+    uint64_t next_event_tick; // when the timer thread wakes up
+
+    std::atomic<uint32_t> word; // futex word
+    std::atomic<bool> stop;
+    pthread_t thread;
+};
+
+void* ThreadPool::TimerWorker(void* arg) {
+    auto ctx = static_cast<TimerContext*>(arg);
+    const uint64_t tick_ns = (uint64_t)TIMER_TICK_US * 1000;
+    vector<TimerWheel::Timer*> expired;
+    vector<pair<shared_ptr<ThreadTask>, uint32_t>> ready_tasks;
+
+    pthread_mutex_lock(&ctx->lock);
+    while (!ctx->stop.load(std::memory_order_acquire)) {
+        const uint64_t now = ctx->GetCurrentTick();
+        ctx->wheel.Advance(now, &expired);
+        for (auto x = expired.begin(); x != expired.end(); ++x) {
+            auto entry = static_cast<TimerContext::Entry*>(*x);
+            ready_tasks.emplace_back(entry->task, entry->queue_idx);
+            if (entry->period_ticks > 0) {
+                uint64_t next = entry->expire_tick + entry->period_ticks;
+                if (next <= now) {
+                    next += ((now - next) / entry->period_ticks + 1) * entry->period_ticks;
+                }
+                ctx->wheel.Add(entry, next);
+            } else {
+                ctx->FreeEntry(entry);
+            }
+        }
+        expired.clear();
+
+        const uint64_t next_event_tick = ctx->wheel.GetNextEventTick();
+        ctx->next_event_tick = next_event_tick;
+        const uint32_t word = ctx->word.load(std::memory_order_acquire);
+        pthread_mutex_unlock(&ctx->lock);
+
+        for (auto x = ready_tasks.begin(); x != ready_tasks.end(); ++x) {
+            auto rc = ctx->pool->AddTask(x->first, x->second);
+            if (rc != RC_SUCCESS) {
+                LOG(WARNING) << "add expired task failed: " << GetRetCodeStr(rc);
+            }
+        }
+        ready_tasks.clear();
+
+        if (next_event_tick == UINT64_MAX) {
+            FutexWait(reinterpret_cast<uint32_t*>(&ctx->word), word);
+        } else {
+            const uint64_t wake_ns = ctx->base_ns + next_event_tick * tick_ns;
+            const uint64_t now_ns = GetTimeNs();
+            if (wake_ns > now_ns) {
+                FutexWait(reinterpret_cast<uint32_t*>(&ctx->word), word, (wake_ns - now_ns + 999) / 1000);
+            }
+        }
+
+        pthread_mutex_lock(&ctx->lock);
+    }
+    pthread_mutex_unlock(&ctx->lock);
+
+    return nullptr;
+}
+
+void ThreadPool::QueueWorkerLoop(ThreadTaskQueue* q) {
+    while (true) {
+        auto task = q->Pop();
+        if (!task) {
+            break;
+        }
+
+#ifdef PPLCOMMON_ENABLE_THREADPOOL_STATS
+        auto stats = &stats_[g_current_thread_idx];
+        uint64_t ts = stats->OnTaskStart(&task->enqueue_ns_, q->Size());
+#endif
+        do {
+            task = task->Run();
+#ifdef PPLCOMMON_ENABLE_THREADPOOL_STATS
+            ts = stats->OnTaskEnd(ts);
+#endif
+        } while (task);
+    }
+}
+
+void ThreadPool::LockFreeQueueWorkerLoop() {
+    shared_ptr<ThreadTask> task;
+    while (true) {
+        lf_queue_->Pop(&task);
+        if (!task) {
+            break;
+        }
+
+#ifdef PPLCOMMON_ENABLE_THREADPOOL_STATS
+        auto stats = &stats_[g_current_thread_idx];
+        uint64_t ts = stats->OnTaskStart(&task->enqueue_ns_, lf_queue_->Size());
+#endif
+        do {
+            task = task->Run();
+#ifdef PPLCOMMON_ENABLE_THREADPOOL_STATS
+            ts = stats->OnTaskEnd(ts);
+#endif
+        } while (task);
+    }
+}
+
+void ThreadPool::WorkStealingWorkerLoop(uint32_t thread_idx) {
+    auto ctx = ws_ctx_;
+    auto self = ctx->workers[thread_idx].get();
+    auto elastic = elastic_ctx_;
+    ElasticContext::Slot* slot = nullptr;
+    if (elastic) {
+        slot = elastic->slots[thread_idx].get();
+        elastic->OnThreadStart(thread_idx);
+    }
+#ifdef PPLCOMMON_ENABLE_THREADPOOL_STATS
+    auto stats = &stats_[thread_idx];
+    auto local_inject_queue = &ctx->groups[self->group]->inject_queues[PRIORITY_NORMAL];
+#endif
+
+    while (true) {
+        auto task = ctx->FindTask(thread_idx);
+        if (task) {
+#ifdef PPLCOMMON_ENABLE_THREADPOOL_STATS
+            // `task` may be released in `Run()`
+            uint64_t ts = stats->OnTaskStart(
+                &task->enqueue_ns_,
+                self->deque.Size() + local_inject_queue->size.load(std::memory_order_relaxed));
+#endif
+            // the continuation will be popped next unless it is stolen
+            auto next = task->Run();
+#ifdef PPLCOMMON_ENABLE_THREADPOOL_STATS
+            ts = stats->OnTaskEnd(ts);
+#endif
+            while (next && !self->deque.Push(next)) {
+                next = next->Run();
+            }
+            if (slot) {
+                slot->task_num.store(slot->task_num.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            }
+            continue;
+        }
+
+        auto key = ctx->event_count.PrepareWait();
+        if (ctx->HasPendingTasks()) {
+            ctx->event_count.CancelWait();
+            continue;
+        }
+        if (ctx->stop.load(std::memory_order_acquire)) {
+            ctx->event_count.CancelWait();
+            break;
+        }
+
+        if (!elastic) {
+            ctx->event_count.CommitWait(key);
+            continue;
+        }
+
+        elastic->MarkIdle(thread_idx);
+        bool notified = true;
+        if (elastic->running_num.load(std::memory_order_relaxed) > elastic->options.min_thread_num) {
+            notified = ctx->event_count.CommitWait(key, (uint64_t)elastic->options.idle_timeout_ms * 1000);
+        } else {
+            ctx->event_count.CommitWait(key);
+        }
+        elastic->MarkBusy(thread_idx);
+
+        if (!notified && elastic->TryRetire()) {
+            slot->retire_num.fetch_add(1, std::memory_order_relaxed);
+            slot->state.store(ElasticContext::SLOT_RETIRED, std::memory_order_release);
+            // passes on the notification that may be consumed by this thread after timeout
+            if (ctx->HasPendingTasks()) {
+                ctx->event_count.NotifyOne();
+            }
+            break;
+        }
+    }
+}
+
+void* ThreadPool::ElasticControllerWorker(void* arg) {
+    auto pool = static_cast<ThreadPool*>(arg);
+    auto ctx = pool->ws_ctx_;
+    auto elastic = pool->elastic_ctx_;
+    const uint32_t max_thread_num = elastic->slots.size();
+    const uint64_t grow_latency_ns = (uint64_t)elastic->options.grow_latency_us * 1000;
+    const uint64_t tick_us = (elastic->options.grow_latency_us > 200) ? elastic->options.grow_latency_us / 2 : 100;
+
+    uint64_t pending_since_ns = 0;
+    while (!elastic->stop.load(std::memory_order_acquire)) {
+        // joins retired threads
+        for (uint32_t i = 0; i < max_thread_num; ++i) {
+            auto slot = elastic->slots[i].get();
+            if (slot->state.load(std::memory_order_acquire) == ElasticContext::SLOT_RETIRED) {
+                pthread_join(pool->threads_[i].pid, nullptr);
+                slot->state.store(ElasticContext::SLOT_STOPPED, std::memory_order_relaxed);
+            }
+        }
+
+        const uint32_t word = elastic->controller_word.load(std::memory_order_acquire);
+        const bool overloaded = (elastic->idle_num.load(std::memory_order_seq_cst) == 0 && ctx->HasPendingTasks());
+        if (!overloaded) {
+            pending_since_ns = 0;
+
+            // sleeps until a task is added while no thread is idle
+            elastic->controller_parked.store(true, std::memory_order_seq_cst);
+            if (elastic->idle_num.load(std::memory_order_seq_cst) > 0 || !ctx->HasPendingTasks()) {
+                FutexWait(reinterpret_cast<uint32_t*>(&elastic->controller_word), word,
+                          (uint64_t)elastic->options.idle_timeout_ms * 1000);
+            }
+            elastic->controller_parked.store(false, std::memory_order_relaxed);
+            continue;
+        }
+
+        const uint64_t now = GetTimeNs();
+        if (pending_since_ns == 0) {
+            pending_since_ns = now;
+        } else if (now - pending_since_ns >= grow_latency_ns) {
+            pending_since_ns = 0;
+            if (elastic->running_num.load(std::memory_order_relaxed) < max_thread_num) {
+                for (uint32_t i = 0; i < max_thread_num; ++i) {
+                    auto slot = elastic->slots[i].get();
+                    if (slot->state.load(std::memory_order_relaxed) == ElasticContext::SLOT_STOPPED) {
+                        elastic->running_num.fetch_add(1, std::memory_order_acq_rel);
+                        slot->state.store(ElasticContext::SLOT_RUNNING, std::memory_order_relaxed);
+                        slot->start_num.fetch_add(1, std::memory_order_relaxed);
+                        auto rc = pool->StartThreads(i, 1);
+                        if (rc != RC_SUCCESS) {
+                            LOG(WARNING) << "start thread [" << i << "] failed: " << GetRetCodeStr(rc);
+                            slot->state.store(ElasticContext::SLOT_STOPPED, std::memory_order_relaxed);
+                            elastic->running_num.fetch_sub(1, std::memory_order_acq_rel);
+                        }
+                        break;
+                    }
+                }
+            }
+        }
+
+        FutexWait(reinterpret_cast<uint32_t*>(&elastic->controller_word), word, tick_us);
+    }
+
+    return nullptr;
+}
+
 void* ThreadPool::ThreadWorker(void* thread_arg) {
     auto arg = (ThreadArg*)thread_arg;
+    auto pool = arg->pool;
     auto q = arg->queue;
+    auto thread_idx = arg->thread_idx;
 
     arg->info->pid = pthread_self();
 #ifdef HAVE_SYS_GETTID
@@ -80,6 +953,13 @@ void* ThreadPool::ThreadWorker(void* thread_arg) {
 #endif
 #endif
 
+    if (arg->cpus) {
+        auto rc = SetCurrentThreadAffinity(*arg->cpus);
+        if (rc != RC_SUCCESS) {
+            LOG(WARNING) << "pin thread [" << thread_idx << "] failed: " << GetRetCodeStr(rc);
+        }
+    }
+
     pthread_mutex_lock(arg->mutex_for_init);
     ++(*(arg->count_for_init));
     if (*(arg->count_for_init) == arg->expected_count_for_init) {
@@ -87,17 +967,19 @@ void* ThreadPool::ThreadWorker(void* thread_arg) {
     }
     pthread_mutex_unlock(arg->mutex_for_init);
 
-    while (true) {
-        auto task = q->Pop();
-        if (!task) {
-            break;
-        }
+    g_current_pool = pool;
+    g_current_thread_idx = thread_idx;
 
-        do {
-            task = task->Run();
-        } while (task);
+    if (pool->IsIntrusiveTaskSupported()) {
+        pool->WorkStealingWorkerLoop(thread_idx);
+    } else if (pool->policy_ == SCHED_LOCK_FREE_QUEUE) {
+        pool->LockFreeQueueWorkerLoop();
+    } else {
+        pool->QueueWorkerLoop(q);
     }
 
+    g_current_pool = nullptr;
+
     return nullptr;
 }
 
@@ -106,10 +988,255 @@ RetCode ThreadPool::AddTask(const shared_ptr<ThreadTask>& task, uint32_t queue_i
         return RC_INVALID_VALUE;
     }
 
+    if (IsIntrusiveTaskSupported()) {
+        auto node = new (std::nothrow) TaskNode(task);
+        if (!node) {
+            return RC_OUT_OF_MEMORY;
+        }
+        return AddTask(node, queue_idx);
+    }
+
+#ifdef PPLCOMMON_ENABLE_THREADPOOL_STATS
+    task->enqueue_ns_ = GetTimeNs();
+#endif
+
+    if (policy_ == SCHED_LOCK_FREE_QUEUE) {
+        if (g_current_pool == this) {
+            // workers MUST NOT block on a full queue which only workers can drain
+            if (!lf_queue_->TryPush(task)) {
+                auto t = task;
+                do {
+                    t = t->Run();
+                } while (t);
+            }
+        } else {
+            lf_queue_->Push(task);
+        }
+        return RC_SUCCESS;
+    }
+
     queues_[queue_idx].Push(task);
     return RC_SUCCESS;
 }
 
+RetCode ThreadPool::AddTask(IntrusiveThreadTask* task, uint32_t queue_idx) {
+    if (!task) {
+        return RC_INVALID_VALUE;
+    }
+    if (!IsIntrusiveTaskSupported()) {
+        return RC_UNSUPPORTED;
+    }
+
+    auto ctx = ws_ctx_;
+    uint32_t group = 0;
+    if (policy_ == SCHED_NUMA) {
+        group = queue_idx % ctx->groups.size();
+    }
+
+#ifdef PPLCOMMON_ENABLE_THREADPOOL_STATS
+    task->enqueue_ns_ = GetTimeNs();
+#endif
+
+    bool pushed = false;
+    if (g_current_pool == this) {
+        auto self = ctx->workers[g_current_thread_idx].get();
+        pushed = (self->group == group && self->deque.Push(task));
+    }
+    if (!pushed) {
+        ctx->groups[group]->inject_queues[PRIORITY_NORMAL].Push(task);
+    }
+    NotifyWorkers();
+    return RC_SUCCESS;
+}
+
+RetCode ThreadPool::AddTask(const shared_ptr<ThreadTask>& task, Priority priority, uint64_t deadline_us) {
+    if (!task) {
+        return RC_INVALID_VALUE;
+    }
+    if (!IsIntrusiveTaskSupported()) {
+        return RC_UNSUPPORTED;
+    }
+
+    auto node = new (std::nothrow) TaskNode(task);
+    if (!node) {
+        return RC_OUT_OF_MEMORY;
+    }
+    auto rc = AddTask(node, priority, deadline_us);
+    if (rc != RC_SUCCESS) {
+        delete node;
+    }
+    return rc;
+}
+
+RetCode ThreadPool::AddTask(IntrusiveThreadTask* task, Priority priority, uint64_t deadline_us) {
+    if (!task || priority >= PRIORITY_NUM) {
+        return RC_INVALID_VALUE;
+    }
+    if (!IsIntrusiveTaskSupported()) {
+        return RC_UNSUPPORTED;
+    }
+    if (priority == PRIORITY_NORMAL && deadline_us == 0) {
+        return AddTask(task);
+    }
+
+    const uint64_t now = GetTimeNs();
+#ifdef PPLCOMMON_ENABLE_THREADPOOL_STATS
+    task->enqueue_ns_ = now;
+#endif
+
+    auto ctx = ws_ctx_;
+    const uint32_t group = (g_current_pool == this) ? ctx->workers[g_current_thread_idx]->group : 0;
+    if (deadline_us > 0) {
+        ctx->groups[group]->deadline_queues[priority].Push(task, now + deadline_us * 1000);
+    } else {
+        ctx->groups[group]->inject_queues[priority].Push(task);
+    }
+    NotifyWorkers();
+    return RC_SUCCESS;
+}
+
+ThreadPool::TimerContext* ThreadPool::GetTimerContext() {
+    auto ctx = timer_ctx_.load(std::memory_order_acquire);
+    if (ctx) {
+        return ctx;
+    }
+
+    auto new_ctx = new (std::nothrow) TimerContext(this);
+    if (!new_ctx) {
+        return nullptr;
+    }
+    if (pthread_create(&new_ctx->thread, nullptr, TimerWorker, new_ctx) != 0) {
+        LOG(ERROR) << "create timer thread failed.";
+        delete new_ctx;
+        return nullptr;
+    }
+
+    if (!timer_ctx_.compare_exchange_strong(ctx, new_ctx, std::memory_order_acq_rel, std::memory_order_acquire)) {
+        // another thread has created the context
+        new_ctx->stop.store(true, std::memory_order_release);
+        new_ctx->word.fetch_add(1, std::memory_order_release);
+        new_ctx->Wake();
+        pthread_join(new_ctx->thread, nullptr);
+        delete new_ctx;
+        return ctx;
+    }
+    return new_ctx;
+}
+
+RetCode ThreadPool::AddTimer(const shared_ptr<ThreadTask>& task, uint64_t delay_us, uint64_t period_us,
+                             uint64_t* timer_id, uint32_t queue_idx) {
+    if (!task) {
+        return RC_INVALID_VALUE;
+    }
+    if (threads_.empty()) {
+        LOG(ERROR) << "thread pool is not initialized.";
+        return RC_INVALID_VALUE;
+    }
+
+    auto ctx = GetTimerContext();
+    if (!ctx) {
+        return RC_OTHER_ERROR;
+    }
+
+    // rounded up, so that tasks never run earlier than expected
+    const uint64_t delay_ticks = (delay_us + TIMER_TICK_US - 1) / TIMER_TICK_US;
+    const uint64_t period_ticks = (period_us + TIMER_TICK_US - 1) / TIMER_TICK_US;
+
+    pthread_mutex_lock(&ctx->lock);
+    auto entry = ctx->AllocEntry();
+    if (!entry) {
+        pthread_mutex_unlock(&ctx->lock);
+        return RC_OUT_OF_MEMORY;
+    }
+    entry->task = task;
+    entry->period_ticks = period_ticks;
+    entry->queue_idx = queue_idx;
+    // the current tick is partially elapsed
+    const bool wake = ctx->Schedule(entry, ctx->GetCurrentTick() + delay_ticks + 1);
+    if (timer_id) {
+        *timer_id = TimerContext::GetTimerId(entry);
+    }
+    pthread_mutex_unlock(&ctx->lock);
+
+    if (wake) {
+        ctx->Wake();
+    }
+    return RC_SUCCESS;
+}
+
+RetCode ThreadPool::AddDelayedTask(const shared_ptr<ThreadTask>& task, uint64_t delay_us, uint64_t* timer_id,
+                                   uint32_t queue_idx) {
+    return AddTimer(task, delay_us, 0, timer_id, queue_idx);
+}
+
+RetCode ThreadPool::AddPeriodicTask(const shared_ptr<ThreadTask>& task, uint64_t period_us, uint64_t* timer_id,
+                                    uint32_t queue_idx) {
+    if (period_us == 0) {
+        return RC_INVALID_VALUE;
+    }
+    return AddTimer(task, period_us, period_us, timer_id, queue_idx);
+}
+
+RetCode ThreadPool::CancelTimer(uint64_t timer_id) {
+    auto ctx = timer_ctx_.load(std::memory_order_acquire);
+    if (!ctx) {
+        return RC_NOT_FOUND;
+    }
+
+    const uint32_t idx = timer_id & 0xffffffff;
+    const uint32_t generation = timer_id >> 32;
+    RetCode rc = RC_NOT_FOUND;
+    pthread_mutex_lock(&ctx->lock);
+    if (idx < ctx->entries.size()) {
+        auto entry = ctx->entries[idx].get();
+        if (entry->generation == generation && entry->IsPending()) {
+            ctx->wheel.Remove(entry);
+            ctx->FreeEntry(entry);
+            rc = RC_SUCCESS;
+        }
+    }
+    pthread_mutex_unlock(&ctx->lock);
+    return rc;
+}
+
+void ThreadPool::NotifyWorkers() {
+    ws_ctx_->event_count.NotifyOneIfWaiting();
+
+    // the fence in `NotifyOneIfWaiting()` also orders these loads after pushing
+    auto elastic = elastic_ctx_;
+    if (elastic && elastic->controller_parked.load(std::memory_order_relaxed) &&
+        elastic->idle_num.load(std::memory_order_relaxed) == 0) {
+        if (elastic->controller_parked.exchange(false, std::memory_order_acq_rel)) {
+            elastic->WakeController();
+        }
+    }
+}
+
+ThreadPool::FuncTask* ThreadPool::AllocFuncTask() {
+    auto& caches = ws_ctx_->func_task_caches;
+    if (g_current_pool == this) {
+        return caches[g_current_thread_idx]->Alloc();
+    }
+
+    auto cache = caches.back().get();
+    pthread_mutex_lock(&cache->lock);
+    auto task = cache->Alloc();
+    pthread_mutex_unlock(&cache->lock);
+    return task;
+}
+
+void ThreadPool::FreeFuncTask(FuncTask* task) {
+    auto cache = task->cache;
+    if (cache->owner_idx == UINT32_MAX) {
+        // the pool of non-worker threads is protected by the lock
+        pthread_mutex_lock(&cache->lock);
+        cache->pool.Free(task);
+        pthread_mutex_unlock(&cache->lock);
+    } else {
+        cache->Free(task);
+    }
+}
+
 #ifdef _MSC_VER
 RetCode ThreadPool::SetAffinity(uint32_t thread_id, const uint32_t* core_list,
                                 uint32_t core_num) {
@@ -169,7 +1296,7 @@ end:
 }
 #endif
 
-ThreadPool::ThreadPool() {
+ThreadPool::ThreadPool() : timer_ctx_(nullptr) {
 #ifdef _MSC_VER
     SYSTEM_INFO info;
     GetSystemInfo(&info);
@@ -179,7 +1306,7 @@ ThreadPool::ThreadPool() {
 #endif
 }
 
-RetCode ThreadPool::Init(uint32_t thread_num, bool share_task_queue) {
+RetCode ThreadPool::Init(uint32_t thread_num, SchedPolicy policy, uint32_t queue_capacity) {
     if (thread_num == 0) {
         if (cpu_core_num_ > 1) {
             thread_num = cpu_core_num_ - 1;
@@ -188,7 +1315,31 @@ RetCode ThreadPool::Init(uint32_t thread_num, bool share_task_queue) {
         }
     }
 
-    if (share_task_queue) {
+    if (policy == SCHED_NUMA) {
+        return InitNuma(thread_num);
+    }
+    if (policy == SCHED_ELASTIC) {
+        ElasticOptions options;
+        options.max_thread_num = thread_num;
+        return InitElastic(options);
+    }
+
+    policy_ = policy;
+    if (policy == SCHED_WORK_STEALING) {
+        ws_ctx_ = new (std::nothrow) WorkStealingContext(this, vector<uint32_t>(1, thread_num));
+        if (!ws_ctx_) {
+            return RC_OUT_OF_MEMORY;
+        }
+    } else if (policy == SCHED_LOCK_FREE_QUEUE) {
+        lf_queue_ = new (std::nothrow) LockFreeThreadTaskQueue();
+        if (!lf_queue_) {
+            return RC_OUT_OF_MEMORY;
+        }
+        auto rc = lf_queue_->Init(queue_capacity);
+        if (rc != RC_SUCCESS) {
+            return rc;
+        }
+    } else if (policy == SCHED_SHARED_QUEUE) {
         queues_ = (ThreadTaskQueue*)malloc(sizeof(ThreadTaskQueue));
         if (!queues_) {
             return RC_OUT_OF_MEMORY;
@@ -207,6 +1358,124 @@ RetCode ThreadPool::Init(uint32_t thread_num, bool share_task_queue) {
     }
 
     threads_.resize(thread_num);
+    return StartThreads(0, thread_num);
+}
+
+RetCode ThreadPool::InitNuma(uint32_t thread_num, const char* sysfs_root) {
+    auto rc = GetNumaTopology(&numa_nodes_, sysfs_root);
+    if (rc != RC_SUCCESS) {
+        LOG(ERROR) << "get numa topology from [" << sysfs_root << "] failed: " << GetRetCodeStr(rc);
+        return rc;
+    }
+
+    uint32_t total_cpu_num = 0;
+    for (auto n = numa_nodes_.begin(); n != numa_nodes_.end(); ++n) {
+        total_cpu_num += n->cpus.size();
+    }
+
+    if (thread_num == 0) {
+        if (total_cpu_num > 1) {
+            thread_num = total_cpu_num - 1;
+        } else {
+            thread_num = 1;
+        }
+    }
+
+    // distributes threads to nodes in proportion to their cpu numbers
+    const uint32_t nr_nodes = numa_nodes_.size();
+    vector<uint32_t> node_thread_num(nr_nodes);
+    uint32_t assigned = 0;
+    for (uint32_t i = 0; i < nr_nodes; ++i) {
+        node_thread_num[i] = (uint64_t)thread_num * numa_nodes_[i].cpus.size() / total_cpu_num;
+        assigned += node_thread_num[i];
+    }
+    for (uint32_t i = 0; assigned < thread_num; i = (i + 1) % nr_nodes) {
+        ++node_thread_num[i];
+        ++assigned;
+    }
+
+    policy_ = SCHED_NUMA;
+    ws_ctx_ = new (std::nothrow) WorkStealingContext(this, node_thread_num);
+    if (!ws_ctx_) {
+        return RC_OUT_OF_MEMORY;
+    }
+
+    threads_.resize(thread_num);
+    return StartThreads(0, thread_num);
+}
+
+RetCode ThreadPool::InitElastic(const ElasticOptions& opt) {
+    ElasticOptions options = opt;
+    if (options.max_thread_num == 0) {
+        options.max_thread_num = cpu_core_num_;
+    }
+    if (options.min_thread_num == 0) {
+        options.min_thread_num = 1;
+    }
+    if (options.min_thread_num > options.max_thread_num) {
+        LOG(ERROR) << "min_thread_num [" << options.min_thread_num << "] > max_thread_num ["
+                   << options.max_thread_num << "]";
+        return RC_INVALID_VALUE;
+    }
+
+    policy_ = SCHED_ELASTIC;
+    ws_ctx_ = new (std::nothrow) WorkStealingContext(this, vector<uint32_t>(1, options.max_thread_num));
+    if (!ws_ctx_) {
+        return RC_OUT_OF_MEMORY;
+    }
+    elastic_ctx_ = new (std::nothrow) ElasticContext(options);
+    if (!elastic_ctx_) {
+        return RC_OUT_OF_MEMORY;
+    }
+
+    // slots for threads started later are reserved so that `threads_` is never reallocated
+    threads_.resize(options.max_thread_num);
+    for (uint32_t i = 0; i < options.min_thread_num; ++i) {
+        auto slot = elastic_ctx_->slots[i].get();
+        slot->state.store(ElasticContext::SLOT_RUNNING, std::memory_order_relaxed);
+        slot->start_num.store(1, std::memory_order_relaxed);
+    }
+    elastic_ctx_->running_num.store(options.min_thread_num, std::memory_order_release);
+
+#ifdef PPLCOMMON_ENABLE_THREADPOOL_STATS
+    // allocated before the controller starts so that `StartThreads()` never allocates it concurrently
+    stats_ = new (std::nothrow) ThreadStats[threads_.size()];
+    if (!stats_) {
+        threads_.clear();
+        delete elastic_ctx_;
+        elastic_ctx_ = nullptr;
+        delete ws_ctx_;
+        ws_ctx_ = nullptr;
+        return RC_OUT_OF_MEMORY;
+    }
+#endif
+
+    if (pthread_create(&elastic_ctx_->controller, nullptr, ElasticControllerWorker, this) != 0) {
+#ifdef PPLCOMMON_ENABLE_THREADPOOL_STATS
+        delete[] stats_;
+        stats_ = nullptr;
+#endif
+        threads_.clear();
+        delete elastic_ctx_;
+        elastic_ctx_ = nullptr;
+        delete ws_ctx_;
+        ws_ctx_ = nullptr;
+        return RC_OTHER_ERROR;
+    }
+
+    return StartThreads(0, options.min_thread_num);
+}
+
+RetCode ThreadPool::StartThreads(uint32_t first_idx, uint32_t thread_num) {
+#ifdef PPLCOMMON_ENABLE_THREADPOOL_STATS
+    if (!stats_) {
+        // SCHED_ELASTIC allocates it in `InitElastic()`
+        stats_ = new (std::nothrow) ThreadStats[threads_.size()];
+        if (!stats_) {
+            return RC_OUT_OF_MEMORY;
+        }
+    }
+#endif
 
     uint32_t count_for_init = 0;
     pthread_mutex_t mutex_for_init;
@@ -221,11 +1490,17 @@ RetCode ThreadPool::Init(uint32_t thread_num, bool share_task_queue) {
         args[i].count_for_init = &count_for_init;
         args[i].mutex_for_init = &mutex_for_init;
         args[i].cond_for_init = &cond_for_init;
-        args[i].info = &threads_[i];
-        if (share_task_queue) {
+        args[i].info = &threads_[first_idx + i];
+        args[i].pool = this;
+        args[i].thread_idx = first_idx + i;
+        args[i].queue = nullptr;
+        args[i].cpus = nullptr;
+        if (policy_ == SCHED_SHARED_QUEUE) {
             args[i].queue = queues_;
-        } else {
+        } else if (policy_ == SCHED_PER_THREAD_QUEUE) {
             args[i].queue = queues_ + i;
+        } else if (policy_ == SCHED_NUMA) {
+            args[i].cpus = &numa_nodes_[ws_ctx_->workers[first_idx + i]->group].cpus;
         }
     }
     for (uint32_t i = 0; i < thread_num; ++i) {
@@ -237,7 +1512,9 @@ RetCode ThreadPool::Init(uint32_t thread_num, bool share_task_queue) {
 
     // waiting for thread(s) to finish init
     pthread_mutex_lock(&mutex_for_init);
-    pthread_cond_wait(&cond_for_init, &mutex_for_init);
+    while (count_for_init < thread_num) {
+        pthread_cond_wait(&cond_for_init, &mutex_for_init);
+    }
     pthread_mutex_unlock(&mutex_for_init);
 
     pthread_cond_destroy(&cond_for_init);
@@ -251,9 +1528,35 @@ void ThreadPool::Destroy() {
         return;
     }
 
+    auto timer = timer_ctx_.exchange(nullptr, std::memory_order_acq_rel);
+    if (timer) {
+        // pending timers are dropped
+        timer->stop.store(true, std::memory_order_release);
+        timer->word.fetch_add(1, std::memory_order_release);
+        timer->Wake();
+        pthread_join(timer->thread, nullptr);
+        delete timer;
+    }
+
+    auto elastic = elastic_ctx_;
+    if (elastic) {
+        // no threads are started or joined by the controller after it exits
+        elastic->stop.store(true, std::memory_order_release);
+        elastic->WakeController();
+        pthread_join(elastic->controller, nullptr);
+    }
+
     // push null task to kill a thread
     shared_ptr<ThreadTask> dummy_task;
-    if (queue_num_ == threads_.size()) {
+    if (IsIntrusiveTaskSupported()) {
+        // threads exit after all pending tasks are finished
+        ws_ctx_->stop.store(true, std::memory_order_release);
+        ws_ctx_->event_count.NotifyAll();
+    } else if (policy_ == SCHED_LOCK_FREE_QUEUE) {
+        for (uint32_t i = 0; i < threads_.size(); ++i) {
+            lf_queue_->Push(dummy_task);
+        }
+    } else if (queue_num_ == threads_.size()) {
         for (uint32_t i = 0; i < threads_.size(); ++i) {
             queues_[i].Push(dummy_task);
         }
@@ -264,7 +1567,10 @@ void ThreadPool::Destroy() {
     }
 
     for (uint32_t i = 0; i < threads_.size(); ++i) {
-        pthread_join(threads_[i].pid, nullptr);
+        if (!elastic ||
+            elastic->slots[i]->state.load(std::memory_order_acquire) != ElasticContext::SLOT_STOPPED) {
+            pthread_join(threads_[i].pid, nullptr);
+        }
     }
     threads_.clear();
 
@@ -275,18 +1581,184 @@ void ThreadPool::Destroy() {
         free(queues_);
     }
     queues_ = nullptr;
+    queue_num_ = 0;
+
+    delete lf_queue_;
+    lf_queue_ = nullptr;
+
+    delete ws_ctx_;
+    ws_ctx_ = nullptr;
+    delete elastic_ctx_;
+    elastic_ctx_ = nullptr;
+    numa_nodes_.clear();
+
+#ifdef PPLCOMMON_ENABLE_THREADPOOL_STATS
+    delete[] stats_;
+    stats_ = nullptr;
+#endif
+}
+
+#ifdef PPLCOMMON_ENABLE_THREADPOOL_STATS
+RetCode ThreadPool::GetStats(vector<ThreadPoolThreadStats>* stats_list) const {
+    if (!stats_) {
+        stats_list->clear();
+        return RC_SUCCESS;
+    }
+    stats_list->resize(threads_.size());
+    for (uint32_t i = 0; i < threads_.size(); ++i) {
+        stats_[i].GetSnapshot(&stats_list->at(i));
+    }
+    return RC_SUCCESS;
+}
+#else
+RetCode ThreadPool::GetStats(vector<ThreadPoolThreadStats>*) const {
+    return RC_UNSUPPORTED;
+}
+#endif
+
+uint32_t ThreadPool::GetThreadNum() const {
+    if (elastic_ctx_) {
+        return elastic_ctx_->running_num.load(std::memory_order_relaxed);
+    }
+    return threads_.size();
+}
+
+RetCode ThreadPool::GetElasticThreadInfo(vector<ElasticThreadInfo>* info_list) const {
+    auto elastic = elastic_ctx_;
+    if (!elastic) {
+        return RC_UNSUPPORTED;
+    }
+
+    const uint64_t now = GetTimeNs();
+    info_list->resize(elastic->slots.size());
+    for (uint32_t i = 0; i < elastic->slots.size(); ++i) {
+        auto slot = elastic->slots[i].get();
+        auto info = &info_list->at(i);
+        info->running = (slot->state.load(std::memory_order_acquire) == ElasticContext::SLOT_RUNNING);
+        info->idle = slot->idle.load(std::memory_order_relaxed);
+        uint64_t busy_ns = slot->busy_ns.load(std::memory_order_relaxed);
+        uint64_t idle_ns = slot->idle_ns.load(std::memory_order_relaxed);
+        if (info->running) {
+            // includes the current period
+            const uint64_t since = slot->since_ns.load(std::memory_order_relaxed);
+            const uint64_t elapsed = (now > since && since > 0) ? (now - since) : 0;
+            if (info->idle) {
+                idle_ns += elapsed;
+            } else {
+                busy_ns += elapsed;
+            }
+        }
+        info->busy_us = busy_ns / 1000;
+        info->idle_us = idle_ns / 1000;
+        info->task_num = slot->task_num.load(std::memory_order_relaxed);
+        info->start_num = slot->start_num.load(std::memory_order_relaxed);
+        info->retire_num = slot->retire_num.load(std::memory_order_relaxed);
+    }
+    return RC_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+#ifdef PPLCOMMON_ENABLE_THREADPOOL_STATS
+struct StaticThreadPool::ThreadStats final {
+    // l1 cache line size for most CPUs
+    static constexpr int CACHELINE_SIZE = 64;
+
+    ThreadStats() : run_num(0) {}
+
+    std::atomic<uint64_t> run_num;
+    LogHistogram run_ns;
+    LogHistogram idle_ns;
+    char padding[CACHELINE_SIZE];
+};
+#endif
+
+/** spins for a while before sleeping on `ec` until `stop_waiting()` returns true */
+template <typename Predicate>
+static void SpinWait(uint32_t spin_count, EventCount* ec, Predicate&& stop_waiting) {
+    for (uint32_t i = 0; i < spin_count; ++i) {
+        if (stop_waiting()) {
+            return;
+        }
+        CpuRelax();
+    }
+    ec->Wait(std::forward<Predicate>(stop_waiting));
+}
+
+uint64_t StaticThreadPool::Team::Submit(const RunFunc& f, JobType type, bool after_previous) {
+    const uint64_t id = submitted_.load(std::memory_order_relaxed) + 1;
+    // waits for the slot to be released by job `id - JOB_RING_SIZE`
+    SpinWait(pool_->spin_count_, &complete_event_, [this, id]() -> bool {
+        return (completed_.load(std::memory_order_acquire) + JOB_RING_SIZE >= id);
+    });
+
+    auto job = &jobs_[id % JOB_RING_SIZE];
+    job->func = f;
+    job->type = type;
+    job->after_previous = after_previous;
+    job->remaining.store(thread_indices_.size(), std::memory_order_relaxed);
+    submitted_.store(id, std::memory_order_release);
+    submit_event_.NotifyAllIfWaiting();
+    return id;
+}
+
+void StaticThreadPool::Team::Run(const RunFunc& f) {
+    Wait(RunAsync(f, true));
+}
+
+uint64_t StaticThreadPool::Team::RunAsync(const RunFunc& f, bool after_previous) {
+    return Submit(f, JOB_RUN, after_previous);
+}
+
+void StaticThreadPool::Team::Wait() {
+    Wait(submitted_.load(std::memory_order_relaxed));
+}
+
+void StaticThreadPool::Team::Wait(uint64_t job_id) {
+    SpinWait(pool_->spin_count_, &complete_event_, [this, job_id]() -> bool {
+        return (completed_.load(std::memory_order_acquire) >= job_id);
+    });
 }
 
 /* ------------------------------------------------------------------------- */
 
 void StaticThreadPool::Destroy() {
-    func_ = nullptr;
-    barrier_.Wait();
+    if (threads_.empty()) {
+        return;
+    }
+
+    // threads exit after finishing all jobs before this one
+    for (auto t = teams_.begin(); t != teams_.end(); ++t) {
+        (*t)->Submit(RunFunc(), Team::JOB_STOP, false);
+    }
     for (auto t = threads_.begin(); t != threads_.end(); ++t) {
         pthread_join(t->pid, nullptr);
     }
     threads_.clear();
+    teams_.clear();
+
+#ifdef PPLCOMMON_ENABLE_THREADPOOL_STATS
+    delete[] stats_;
+    stats_ = nullptr;
+#endif
+}
+
+#ifdef PPLCOMMON_ENABLE_THREADPOOL_STATS
+RetCode StaticThreadPool::GetStats(vector<StaticThreadPoolThreadStats>* stats_list) const {
+    stats_list->resize(threads_.size());
+    for (uint32_t i = 0; i < threads_.size(); ++i) {
+        auto res = &stats_list->at(i);
+        res->run_num = stats_[i].run_num.load(std::memory_order_relaxed);
+        stats_[i].run_ns.GetSnapshot(&res->run_ns);
+        stats_[i].idle_ns.GetSnapshot(&res->idle_ns);
+    }
+    return RC_SUCCESS;
+}
+#else
+RetCode StaticThreadPool::GetStats(vector<StaticThreadPoolThreadStats>*) const {
+    return RC_UNSUPPORTED;
 }
+#endif
 
 RetCode StaticThreadPool::Init(uint32_t thread_num) {
     if (thread_num == 0) {
@@ -304,15 +1776,40 @@ RetCode StaticThreadPool::Init(uint32_t thread_num) {
         }
     }
 
-    barrier_.Reset(thread_num + 1);
-    threads_.resize(thread_num);
+#ifdef PPLCOMMON_ENABLE_THREADPOOL_STATS
+    stats_ = new (std::nothrow) ThreadStats[thread_num];
+    if (!stats_) {
+        return RC_OUT_OF_MEMORY;
+    }
+#endif
+
+    vector<uint32_t> thread_indices(thread_num);
     for (uint32_t i = 0; i < thread_num; ++i) {
-        threads_[i].thread_idx = i;
-        threads_[i].pool = this;
+        thread_indices[i] = i;
+    }
+    auto team = new (std::nothrow) Team(this, thread_indices);
+    if (!team) {
+        return RC_OUT_OF_MEMORY;
+    }
+    teams_.emplace_back(team);
 
+    // the caller waits for jobs as well
+    spin_count_ = (thread_num + 1 <= std::thread::hardware_concurrency()) ? SPIN_COUNT : 0;
+    threads_.resize(thread_num);
+    for (uint32_t i = 0; i < thread_num; ++i) {
+        auto info = &threads_[i];
+        info->thread_idx = i;
+        info->pool = this;
+        info->team = team;
+        info->team_thread_idx = i;
+        info->next_team = nullptr;
+        info->next_team_thread_idx = 0;
+    }
+    for (uint32_t i = 0; i < thread_num; ++i) {
         if (pthread_create(&threads_[i].pid, nullptr, ThreadWorker, &threads_[i]) != 0) {
-            barrier_.Reset(i + 1);
+            LOG(ERROR) << "create thread [" << i << "] failed.";
             threads_.resize(i);
+            Destroy();
             return RC_OTHER_ERROR;
         }
     }
@@ -323,31 +1820,408 @@ RetCode StaticThreadPool::Init(uint32_t thread_num) {
 void* StaticThreadPool::ThreadWorker(void* arg) {
     auto info = (ThreadInfo*)arg;
     auto pool = info->pool;
+    auto team = info->team;
+#ifdef PPLCOMMON_ENABLE_THREADPOOL_STATS
+    auto stats = &pool->stats_[info->thread_idx];
+    uint64_t idle_since_ns = GetTimeNs();
+#endif
 
-    while (true) {
-        pool->barrier_.Wait();
-        if (!pool->func_) {
+    for (uint64_t id = 1;; ++id) {
+        SpinWait(pool->spin_count_, &team->submit_event_, [team, id]() -> bool {
+            return (team->submitted_.load(std::memory_order_acquire) >= id);
+        });
+
+        auto job = &team->jobs_[id % JOB_RING_SIZE];
+        if (job->type == Team::JOB_STOP) {
             break;
         }
-        pool->func_(pool->threads_.size(), info->thread_idx);
-        pool->barrier_.Wait();
+        if (job->type == Team::JOB_SWITCH) {
+            info->team = info->next_team;
+            info->team_thread_idx = info->next_team_thread_idx;
+            team = info->team;
+            id = 0;
+            // the old team may be released after this
+            pool->switched_num_.fetch_add(1, std::memory_order_acq_rel);
+            pool->switch_event_.NotifyAllIfWaiting();
+            continue;
+        }
+        if (job->after_previous) {
+            SpinWait(pool->spin_count_, &team->complete_event_, [team, id]() -> bool {
+                return (team->completed_.load(std::memory_order_acquire) >= id - 1);
+            });
+        }
+
+#ifdef PPLCOMMON_ENABLE_THREADPOOL_STATS
+        const uint64_t start_ns = GetTimeNs();
+        stats->idle_ns.Record(start_ns - idle_since_ns);
+#endif
+        job->func(team->GetNumThreads(), info->team_thread_idx);
+#ifdef PPLCOMMON_ENABLE_THREADPOOL_STATS
+        // recorded before the job completes, so that stats are up to date when `Wait()` returns
+        idle_since_ns = GetTimeNs();
+        stats->run_ns.Record(idle_since_ns - start_ns);
+        stats->run_num.store(stats->run_num.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+#endif
+
+        if (job->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            // releases resources captured by `func` before the slot is reused
+            job->func = nullptr;
+            team->completed_.store(id, std::memory_order_release);
+            team->complete_event_.NotifyAllIfWaiting();
+        }
     }
 
     return nullptr;
 }
 
-void StaticThreadPool::Run(const function<void(uint32_t nr_threads, uint32_t thread_idx)>& f) {
-    RunAsync(f);
-    Wait();
+void StaticThreadPool::SwitchTeams(vector<unique_ptr<Team>>* teams) {
+    for (auto t = teams_.begin(); t != teams_.end(); ++t) {
+        (*t)->Wait();
+    }
+
+    switched_num_.store(0, std::memory_order_relaxed);
+    for (auto t = teams_.begin(); t != teams_.end(); ++t) {
+        (*t)->Submit(RunFunc(), Team::JOB_SWITCH, false);
+    }
+    const uint32_t thread_num = threads_.size();
+    SpinWait(spin_count_, &switch_event_, [this, thread_num]() -> bool {
+        return (switched_num_.load(std::memory_order_acquire) == thread_num);
+    });
+
+    // old teams are released by the caller
+    teams_.swap(*teams);
+}
+
+RetCode StaticThreadPool::SetAffinity(uint32_t thread_idx, const uint32_t* core_list, uint32_t core_num) {
+    if (thread_idx >= threads_.size() || core_num == 0) {
+        return RC_INVALID_VALUE;
+    }
+
+    auto info = &threads_[thread_idx];
+    const uint32_t target = info->team_thread_idx;
+    const vector<uint32_t> cpus(core_list, core_list + core_num);
+    RetCode rc = RC_SUCCESS;
+    info->team->Run([target, &cpus, &rc](uint32_t, uint32_t idx) {
+        if (idx == target) {
+            rc = SetCurrentThreadAffinity(cpus);
+        }
+    });
+    if (rc == RC_SUCCESS) {
+        info->cpus = cpus;
+    }
+    return rc;
+}
+
+RetCode StaticThreadPool::Split(const vector<uint32_t>& sizes, vector<Team*>* teams) {
+    uint32_t total = 0;
+    for (auto s = sizes.begin(); s != sizes.end(); ++s) {
+        if (*s == 0) {
+            LOG(ERROR) << "empty team.";
+            return RC_INVALID_VALUE;
+        }
+        total += *s;
+    }
+    if (threads_.empty() || total != threads_.size()) {
+        LOG(ERROR) << "sizes of teams [" << total << "] != thread num [" << threads_.size() << "]";
+        return RC_INVALID_VALUE;
+    }
+
+    // threads are ordered by (numa node, the first pinned core), and threads which are not pinned come last
+    vector<NumaNode> nodes;
+    if (GetNumaTopology(&nodes) != RC_SUCCESS) {
+        nodes.clear();
+    }
+    struct Placement final {
+        uint32_t node;
+        uint32_t cpu;
+        uint32_t thread_idx;
+        bool operator<(const Placement& rhs) const {
+            if (node != rhs.node) {
+                return (node < rhs.node);
+            }
+            if (cpu != rhs.cpu) {
+                return (cpu < rhs.cpu);
+            }
+            return (thread_idx < rhs.thread_idx);
+        }
+    };
+    vector<Placement> placements(threads_.size());
+    for (uint32_t i = 0; i < threads_.size(); ++i) {
+        auto p = &placements[i];
+        p->node = UINT32_MAX;
+        p->cpu = UINT32_MAX;
+        p->thread_idx = i;
+        const auto& cpus = threads_[i].cpus;
+        if (cpus.empty()) {
+            continue;
+        }
+        p->cpu = *std::min_element(cpus.begin(), cpus.end());
+        p->node = 0;
+        for (auto n = nodes.begin(); n != nodes.end(); ++n) {
+            if (std::find(n->cpus.begin(), n->cpus.end(), p->cpu) != n->cpus.end()) {
+                p->node = n->id;
+                break;
+            }
+        }
+    }
+    std::sort(placements.begin(), placements.end());
+
+    vector<unique_ptr<Team>> new_teams;
+    uint32_t offset = 0;
+    for (auto s = sizes.begin(); s != sizes.end(); ++s) {
+        vector<uint32_t> thread_indices(*s);
+        for (uint32_t i = 0; i < *s; ++i) {
+            thread_indices[i] = placements[offset + i].thread_idx;
+        }
+        offset += *s;
+
+        auto team = new (std::nothrow) Team(this, thread_indices);
+        if (!team) {
+            return RC_OUT_OF_MEMORY;
+        }
+        new_teams.emplace_back(team);
+        for (uint32_t i = 0; i < thread_indices.size(); ++i) {
+            auto info = &threads_[thread_indices[i]];
+            info->next_team = team;
+            info->next_team_thread_idx = i;
+        }
+    }
+
+    SwitchTeams(&new_teams);
+
+    teams->clear();
+    for (auto t = teams_.begin(); t != teams_.end(); ++t) {
+        teams->push_back(t->get());
+    }
+    return RC_SUCCESS;
+}
+
+RetCode StaticThreadPool::Merge() {
+    if (threads_.empty()) {
+        return RC_INVALID_VALUE;
+    }
+    if (!IsSplit()) {
+        return RC_SUCCESS;
+    }
+
+    vector<uint32_t> thread_indices(threads_.size());
+    for (uint32_t i = 0; i < threads_.size(); ++i) {
+        thread_indices[i] = i;
+    }
+    auto team = new (std::nothrow) Team(this, thread_indices);
+    if (!team) {
+        return RC_OUT_OF_MEMORY;
+    }
+    vector<unique_ptr<Team>> new_teams;
+    new_teams.emplace_back(team);
+    for (uint32_t i = 0; i < threads_.size(); ++i) {
+        threads_[i].next_team = team;
+        threads_[i].next_team_thread_idx = i;
+    }
+
+    SwitchTeams(&new_teams);
+    return RC_SUCCESS;
+}
+
+void StaticThreadPool::Run(const RunFunc& f) {
+    if (!teams_.empty()) {
+        teams_[0]->Run(f);
+    }
 }
 
-void StaticThreadPool::RunAsync(const function<void(uint32_t nr_threads, uint32_t thread_idx)>& f) {
-    func_ = f;
-    Wait(); // notify start
+uint64_t StaticThreadPool::RunAsync(const RunFunc& f, bool after_previous) {
+    if (teams_.empty()) {
+        return 0;
+    }
+    return teams_[0]->RunAsync(f, after_previous);
 }
 
 void StaticThreadPool::Wait() {
-    barrier_.Wait(); // wait for end
+    if (!teams_.empty()) {
+        teams_[0]->Wait();
+    }
+}
+
+void StaticThreadPool::Wait(uint64_t job_id) {
+    if (!teams_.empty()) {
+        teams_[0]->Wait(job_id);
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+void StaticThreadPool::Team::ForEachChunk(int64_t begin, int64_t end, int64_t grain, Schedule schedule,
+                                          uint32_t nr_threads, uint32_t thread_idx, std::atomic<int64_t>* next,
+                                          const function<void(int64_t, int64_t)>& f) {
+    if (schedule == SCHEDULE_STATIC) {
+        const int64_t nr_chunks = (end - begin + grain - 1) / grain;
+        const int64_t chunk_begin = nr_chunks * thread_idx / nr_threads;
+        const int64_t chunk_end = nr_chunks * (thread_idx + 1) / nr_threads;
+        if (chunk_begin < chunk_end) {
+            const int64_t b = begin + chunk_begin * grain;
+            const int64_t e = begin + chunk_end * grain;
+            f(b, (e < end) ? e : end);
+        }
+        return;
+    }
+
+    if (schedule == SCHEDULE_DYNAMIC) {
+        while (true) {
+            const int64_t b = next->fetch_add(grain, std::memory_order_relaxed);
+            if (b >= end) {
+                break;
+            }
+            const int64_t e = b + grain;
+            f(b, (e < end) ? e : end);
+        }
+        return;
+    }
+
+    // SCHEDULE_GUIDED
+    int64_t b = next->load(std::memory_order_relaxed);
+    while (b < end) {
+        int64_t size = (end - b) / (2 * (int64_t)nr_threads);
+        if (size < grain) {
+            size = grain;
+        }
+        if (next->compare_exchange_weak(b, b + size, std::memory_order_relaxed)) {
+            const int64_t e = b + size;
+            f(b, (e < end) ? e : end);
+            b = next->load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void StaticThreadPool::Team::ParallelFor(int64_t begin, int64_t end, int64_t grain,
+                                         const function<void(int64_t, int64_t)>& f, Schedule schedule) {
+    if (begin >= end) {
+        return;
+    }
+    if (grain < 1) {
+        grain = 1;
+    }
+
+    if (end - begin <= grain) {
+        f(begin, end);
+        return;
+    }
+
+    std::atomic<int64_t> next(begin);
+    Run([begin, end, grain, schedule, &next, &f](uint32_t nr_threads, uint32_t thread_idx) {
+        ForEachChunk(begin, end, grain, schedule, nr_threads, thread_idx, &next, f);
+    });
+}
+
+static inline int64_t DivUp(int64_t a, int64_t b) {
+    return (a + b - 1) / b;
+}
+
+static inline int64_t Min(int64_t a, int64_t b) {
+    return (a < b) ? a : b;
+}
+
+/** `parallel_for` is the `ParallelFor()` of a pool or a team */
+template <typename ParallelForFunc>
+static void ParallelFor2DImpl(const ParallelForFunc& parallel_for, int64_t n0, int64_t n1, int64_t tile0,
+                              int64_t tile1, const function<void(int64_t, int64_t, int64_t, int64_t)>& f,
+                              StaticThreadPool::Schedule schedule) {
+    if (n0 <= 0 || n1 <= 0) {
+        return;
+    }
+    tile0 = (tile0 < 1) ? 1 : tile0;
+    tile1 = (tile1 < 1) ? 1 : tile1;
+
+    const int64_t nr_tiles1 = DivUp(n1, tile1);
+    const int64_t nr_tiles = DivUp(n0, tile0) * nr_tiles1;
+    parallel_for(
+        0, nr_tiles, 1,
+        [n0, n1, tile0, tile1, nr_tiles1, &f](int64_t begin, int64_t end) {
+            for (int64_t t = begin; t < end; ++t) {
+                const int64_t b0 = (t / nr_tiles1) * tile0;
+                const int64_t b1 = (t % nr_tiles1) * tile1;
+                f(b0, Min(b0 + tile0, n0), b1, Min(b1 + tile1, n1));
+            }
+        },
+        schedule);
+}
+
+template <typename ParallelForFunc>
+static void ParallelFor3DImpl(const ParallelForFunc& parallel_for, int64_t n0, int64_t n1, int64_t n2, int64_t tile0,
+                              int64_t tile1, int64_t tile2,
+                              const function<void(int64_t, int64_t, int64_t, int64_t, int64_t, int64_t)>& f,
+                              StaticThreadPool::Schedule schedule) {
+    if (n0 <= 0 || n1 <= 0 || n2 <= 0) {
+        return;
+    }
+    tile0 = (tile0 < 1) ? 1 : tile0;
+    tile1 = (tile1 < 1) ? 1 : tile1;
+    tile2 = (tile2 < 1) ? 1 : tile2;
+
+    const int64_t nr_tiles2 = DivUp(n2, tile2);
+    const int64_t nr_tiles12 = DivUp(n1, tile1) * nr_tiles2;
+    const int64_t nr_tiles = DivUp(n0, tile0) * nr_tiles12;
+    parallel_for(
+        0, nr_tiles, 1,
+        [n0, n1, n2, tile0, tile1, tile2, nr_tiles2, nr_tiles12, &f](int64_t begin, int64_t end) {
+            for (int64_t t = begin; t < end; ++t) {
+                const int64_t b0 = (t / nr_tiles12) * tile0;
+                const int64_t b1 = ((t % nr_tiles12) / nr_tiles2) * tile1;
+                const int64_t b2 = (t % nr_tiles2) * tile2;
+                f(b0, Min(b0 + tile0, n0), b1, Min(b1 + tile1, n1), b2, Min(b2 + tile2, n2));
+            }
+        },
+        schedule);
+}
+
+void StaticThreadPool::Team::ParallelFor2D(int64_t n0, int64_t n1, int64_t tile0, int64_t tile1,
+                                           const function<void(int64_t, int64_t, int64_t, int64_t)>& f,
+                                           Schedule schedule) {
+    auto parallel_for = [this](int64_t b, int64_t e, int64_t grain, const function<void(int64_t, int64_t)>& fn,
+                               Schedule s) {
+        ParallelFor(b, e, grain, fn, s);
+    };
+    ParallelFor2DImpl(parallel_for, n0, n1, tile0, tile1, f, schedule);
+}
+
+void StaticThreadPool::Team::ParallelFor3D(
+    int64_t n0, int64_t n1, int64_t n2, int64_t tile0, int64_t tile1, int64_t tile2,
+    const function<void(int64_t, int64_t, int64_t, int64_t, int64_t, int64_t)>& f, Schedule schedule) {
+    auto parallel_for = [this](int64_t b, int64_t e, int64_t grain, const function<void(int64_t, int64_t)>& fn,
+                               Schedule s) {
+        ParallelFor(b, e, grain, fn, s);
+    };
+    ParallelFor3DImpl(parallel_for, n0, n1, n2, tile0, tile1, tile2, f, schedule);
+}
+
+void StaticThreadPool::ParallelFor(int64_t begin, int64_t end, int64_t grain, const function<void(int64_t, int64_t)>& f,
+                                   Schedule schedule) {
+    if (teams_.empty()) {
+        if (begin < end) {
+            f(begin, end);
+        }
+        return;
+    }
+    teams_[0]->ParallelFor(begin, end, grain, f, schedule);
+}
+
+void StaticThreadPool::ParallelFor2D(int64_t n0, int64_t n1, int64_t tile0, int64_t tile1,
+                                     const function<void(int64_t, int64_t, int64_t, int64_t)>& f,
+                                     Schedule schedule) {
+    auto parallel_for = [this](int64_t b, int64_t e, int64_t grain, const function<void(int64_t, int64_t)>& fn,
+                               Schedule s) {
+        ParallelFor(b, e, grain, fn, s);
+    };
+    ParallelFor2DImpl(parallel_for, n0, n1, tile0, tile1, f, schedule);
+}
+
+void StaticThreadPool::ParallelFor3D(
+    int64_t n0, int64_t n1, int64_t n2, int64_t tile0, int64_t tile1, int64_t tile2,
+    const function<void(int64_t, int64_t, int64_t, int64_t, int64_t, int64_t)>& f, Schedule schedule) {
+    auto parallel_for = [this](int64_t b, int64_t e, int64_t grain, const function<void(int64_t, int64_t)>& fn,
+                               Schedule s) {
+        ParallelFor(b, e, grain, fn, s);
+    };
+    ParallelFor3DImpl(parallel_for, n0, n1, n2, tile0, tile1, tile2, f, schedule);
 }
 
 }}
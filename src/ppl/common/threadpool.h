@@ -18,12 +18,27 @@
 #ifndef _ST_HPC_PPL_COMMON_THREADPOOL_H_
 #define _ST_HPC_PPL_COMMON_THREADPOOL_H_
 
+#ifdef _MSC_VER
+#include "ppl/common/windows/pthread.h"
+#else
+#include <pthread.h>
+#endif
+
 #include "ppl/common/retcode.h"
 #include "ppl/common/message_queue.h"
-#include "ppl/common/barrier.h"
+#include "ppl/common/mpmc_ring_buffer.h"
+#include "ppl/common/mpsc_queue.h"
+#include "ppl/common/event_count.h"
+#include "ppl/common/numa.h"
+#include "ppl/common/histogram.h"
 #include <vector>
 #include <memory>
 #include <functional>
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 namespace ppl { namespace common {
 
@@ -35,6 +50,12 @@ public:
        or returns nullptr so that scheduler will pick up a task from task queue.
      */
     virtual std::shared_ptr<ThreadTask> Run() = 0;
+
+#ifdef PPLCOMMON_ENABLE_THREADPOOL_STATS
+private:
+    friend class ThreadPool;
+    uint64_t enqueue_ns_ = 0; // set by `ThreadPool::AddTask()`
+#endif
 };
 
 class JoinableThreadTask : public ThreadTask {
@@ -60,7 +81,53 @@ private:
     void operator=(JoinableThreadTask&&) = delete;
 };
 
+/**
+   a task with an embedded queue hook, so that it can be scheduled without any allocation.
+   the pool never owns or frees an intrusive task: the task is handed back to its owner when `Run()` is called,
+   and `Run()` may release the task itself, e.g. returning it to an `ObjectPool`, before it returns.
+   a task MUST NOT be added again before it starts running.
+*/
+class IntrusiveThreadTask : public MPSCQueue::Node {
+public:
+    virtual ~IntrusiveThreadTask() {}
+    /**
+       returns a task that will be executed right after Run() returns,
+       or returns nullptr so that scheduler will pick up a task from task queue.
+     */
+    virtual IntrusiveThreadTask* Run() = 0;
+
+#ifdef PPLCOMMON_ENABLE_THREADPOOL_STATS
+private:
+    friend class ThreadPool;
+    uint64_t enqueue_ns_ = 0; // set by `ThreadPool::AddTask()`
+#endif
+};
+
+/** stats of a thread of `ThreadPool` */
+struct ThreadPoolThreadStats final {
+    uint64_t task_num = 0;
+    /** number of pending tasks seen by the thread when it picks up a task. approximate. */
+    HistogramSnapshot queue_depth;
+    /** nanoseconds from adding a task to running it. continuations are not counted. */
+    HistogramSnapshot wait_ns;
+    /** nanoseconds spent in `Run()` */
+    HistogramSnapshot run_ns;
+};
+
+/** stats of a thread of `StaticThreadPool` */
+struct StaticThreadPoolThreadStats final {
+    uint64_t run_num = 0;
+    /** nanoseconds spent in the function of `Run()` */
+    HistogramSnapshot run_ns;
+    /**
+       nanoseconds from finishing a job to starting the next one, spent waiting for new jobs or for other threads
+       to complete the previous job. with back-to-back `Run()` calls, this is the load imbalance.
+    */
+    HistogramSnapshot idle_ns;
+};
+
 typedef MessageQueue<std::shared_ptr<ThreadTask>> ThreadTaskQueue;
+typedef BlockingMPMCQueue<std::shared_ptr<ThreadTask>> LockFreeThreadTaskQueue;
 
 class ThreadPool final {
 public:
@@ -71,6 +138,74 @@ public:
 #endif
     };
 
+    enum SchedPolicy {
+        /** all threads share task queue 0 */
+        SCHED_SHARED_QUEUE,
+        /** each thread has its own task queue */
+        SCHED_PER_THREAD_QUEUE,
+        /**
+           each thread owns a work-stealing deque. tasks added by worker threads, including continuations
+           returned by `ThreadTask::Run()`, are pushed to the deque of the current thread. tasks added by
+           other threads go to a shared injection queue. idle threads steal from random victims.
+        */
+        SCHED_WORK_STEALING,
+        /**
+           all threads share a bounded lock-free queue. `AddTask()` blocks if the queue is full,
+           or runs the task in place if it is called by a worker thread of this pool.
+        */
+        SCHED_LOCK_FREE_QUEUE,
+        /**
+           like SCHED_WORK_STEALING, but threads are grouped by numa nodes and pinned to the cpus of their nodes.
+           each node has its own inject queue, and `queue_idx` of `AddTask()` is the node hint. idle threads
+           steal from threads of other nodes only if there are no tasks in their own nodes.
+        */
+        SCHED_NUMA,
+        /**
+           like SCHED_WORK_STEALING, but the number of threads changes between `min_thread_num` and
+           `max_thread_num` of `ElasticOptions` according to the load. see `InitElastic()`.
+        */
+        SCHED_ELASTIC,
+    };
+
+    /**
+       priority classes of tasks. in a class, tasks with deadlines are run earliest deadline first before tasks
+       without deadlines. to prevent starvation, every `PRIORITY_AGING_INTERVAL`-th search of a thread for the
+       next task starts from the lowest class.
+    */
+    enum Priority {
+        PRIORITY_HIGH,
+        PRIORITY_NORMAL,
+        PRIORITY_LOW,
+        PRIORITY_NUM,
+    };
+    static constexpr uint32_t PRIORITY_AGING_INTERVAL = 16;
+
+    struct ElasticOptions final {
+        ElasticOptions() : min_thread_num(1), max_thread_num(0), grow_latency_us(1000), idle_timeout_ms(1000) {}
+
+        /** at least 1 */
+        uint32_t min_thread_num;
+        /** 0 means the number of cpu cores */
+        uint32_t max_thread_num;
+        /** a thread is added if tasks have been pending for this long while no thread is idle */
+        uint32_t grow_latency_us;
+        /** a thread exits if it has been idle for this long and there are more than `min_thread_num` threads */
+        uint32_t idle_timeout_ms;
+    };
+
+    /** busy/idle accounting of a thread slot in SCHED_ELASTIC mode. values are approximate. */
+    struct ElasticThreadInfo final {
+        bool running;
+        bool idle;
+        uint64_t busy_us;
+        uint64_t idle_us;
+        uint64_t task_num;
+        /** times that a thread was started in this slot */
+        uint32_t start_num;
+        /** times that a thread in this slot exited because of idle timeout */
+        uint32_t retire_num;
+    };
+
 public:
     ThreadPool();
     ~ThreadPool() {
@@ -81,24 +216,227 @@ public:
        only queue 0 is available if `share_task_queue` is true,
        othrewise each thread has its own task queue.
     */
-    ppl::common::RetCode Init(uint32_t thread_num = 0, bool share_task_queue = true);
+    ppl::common::RetCode Init(uint32_t thread_num = 0, bool share_task_queue = true) {
+        return Init(thread_num, share_task_queue ? SCHED_SHARED_QUEUE : SCHED_PER_THREAD_QUEUE);
+    }
+    /** `queue_capacity` is used in SCHED_LOCK_FREE_QUEUE mode only. */
+    ppl::common::RetCode Init(uint32_t thread_num, SchedPolicy, uint32_t queue_capacity = 4096);
+    /**
+       initializes in SCHED_NUMA mode. topology is read from `sysfs_root`. see `GetNumaTopology()`.
+       `thread_num` threads are distributed to nodes in proportion to their cpu numbers.
+    */
+    ppl::common::RetCode InitNuma(uint32_t thread_num = 0, const char* sysfs_root = "/sys");
+    /**
+       initializes in SCHED_ELASTIC mode with `min_thread_num` threads. a controller thread adds a thread when
+       tasks wait longer than `grow_latency_us` while all threads are busy, and idle threads exit after
+       `idle_timeout_ms`. idle threads sleep on the same `EventCount` used to notify new tasks.
+    */
+    ppl::common::RetCode InitElastic(const ElasticOptions& options = ElasticOptions());
     void Destroy();
 
-    uint32_t GetThreadNum() const { return threads_.size(); }
+    /** returns the number of running threads, which changes over time in SCHED_ELASTIC mode */
+    uint32_t GetThreadNum() const;
+
+    SchedPolicy GetSchedPolicy() const {
+        return policy_;
+    }
+
+    /** whether `AddTask(IntrusiveThreadTask*)` and `AddFunc()` are supported */
+    bool IsIntrusiveTaskSupported() const {
+        return (policy_ == SCHED_WORK_STEALING || policy_ == SCHED_NUMA || policy_ == SCHED_ELASTIC);
+    }
+
+    /**
+       @brief gets stats of all threads (all `max_thread_num` slots in SCHED_ELASTIC mode).
+       @return RC_UNSUPPORTED unless PPLCOMMON_ENABLE_THREADPOOL_STATS is defined. stats are compiled out otherwise.
+    */
+    ppl::common::RetCode GetStats(std::vector<ThreadPoolThreadStats>*) const;
+
+    /** gets info of all `max_thread_num` thread slots in SCHED_ELASTIC mode */
+    ppl::common::RetCode GetElasticThreadInfo(std::vector<ElasticThreadInfo>*) const;
+
+    /** numa nodes used in SCHED_NUMA mode */
+    const std::vector<NumaNode>& GetNumaNodes() const {
+        return numa_nodes_;
+    }
+
+    /**
+       `queue_idx` is ignored in SCHED_WORK_STEALING and SCHED_LOCK_FREE_QUEUE modes,
+       and is the index of numa node in `GetNumaNodes()` in SCHED_NUMA mode.
+    */
     ppl::common::RetCode AddTask(const std::shared_ptr<ThreadTask>&, uint32_t queue_idx = 0);
 
+    /**
+       @brief adds a task without allocating anything. `queue_idx` has the same meaning as above.
+       @note see `IsIntrusiveTaskSupported()`.
+    */
+    ppl::common::RetCode AddTask(IntrusiveThreadTask*, uint32_t queue_idx = 0);
+
+    /**
+       @brief adds a task of the given priority class. `deadline_us` is relative to now, and 0 means no deadline.
+       tasks of PRIORITY_NORMAL without deadlines are scheduled in the same way as `AddTask(task)`,
+       while the others are put in queues shared by threads (of the same numa node in SCHED_NUMA mode).
+       continuations returned by `Run()` are run right after their parents regardless of priorities.
+       @note see `IsIntrusiveTaskSupported()`.
+    */
+    ppl::common::RetCode AddTask(const std::shared_ptr<ThreadTask>&, Priority, uint64_t deadline_us = 0);
+    ppl::common::RetCode AddTask(IntrusiveThreadTask*, Priority, uint64_t deadline_us = 0);
+
+    /**
+       @brief runs `f()` in the pool. closures not larger than `FUNC_TASK_INLINE_SIZE` bytes are stored in
+       task objects recycled by per-thread caches, so that they never touch the heap after warming up.
+       larger closures are allocated separately.
+       @note see `IsIntrusiveTaskSupported()`.
+    */
+    template <typename Func>
+    ppl::common::RetCode AddFunc(Func&& f, uint32_t queue_idx = 0) {
+        FuncTask* task = nullptr;
+        auto rc = CreateFuncTask(std::forward<Func>(f), &task);
+        if (rc != ppl::common::RC_SUCCESS) {
+            return rc;
+        }
+        return AddTask(task, queue_idx);
+    }
+
+    /** runs `f()` with priority. see `AddTask(task, priority, deadline_us)`. */
+    template <typename Func>
+    ppl::common::RetCode AddFunc(Func&& f, Priority priority, uint64_t deadline_us = 0) {
+        FuncTask* task = nullptr;
+        auto rc = CreateFuncTask(std::forward<Func>(f), &task);
+        if (rc != ppl::common::RC_SUCCESS) {
+            return rc;
+        }
+        return AddTask(task, priority, deadline_us);
+    }
+
     /**
        0 <= thread_id < ThreadNum()
        0 <= core_list[i] < sysconf(_SC_NPROCESSORS_ONLN)
      */
     ppl::common::RetCode SetAffinity(uint32_t thread_id, const uint32_t* core_list, uint32_t core_num);
 
+    /**
+       @brief adds `task` to queue `queue_idx` after `delay_us` microseconds, which is rounded up to
+       `TIMER_TICK_US`. timers are kept in a hierarchical timing wheel driven by a timer thread, which is started
+       by the first timer and sleeps on a futex until the next timer expires. an id is stored in `timer_id` if it is
+       not null for `CancelTimer()`. pending timers are dropped by `Destroy()`.
+    */
+    ppl::common::RetCode AddDelayedTask(const std::shared_ptr<ThreadTask>&, uint64_t delay_us,
+                                        uint64_t* timer_id = nullptr, uint32_t queue_idx = 0);
+    /**
+       @brief adds `task` every `period_us` microseconds until it is cancelled. periods missed because of a busy
+       timer thread are skipped. runs of the task may overlap if it runs longer than `period_us`.
+    */
+    ppl::common::RetCode AddPeriodicTask(const std::shared_ptr<ThreadTask>&, uint64_t period_us,
+                                         uint64_t* timer_id = nullptr, uint32_t queue_idx = 0);
+    /**
+       @brief cancels a pending timer. a task which is already added to the pool is not affected.
+       @return RC_NOT_FOUND if the timer has expired or been cancelled.
+    */
+    ppl::common::RetCode CancelTimer(uint64_t timer_id);
+
+public:
+    static constexpr uint32_t FUNC_TASK_INLINE_SIZE = 48;
+    static constexpr uint32_t TIMER_TICK_US = 100;
+
 private:
+    struct TaskNode;
+    struct WorkStealingContext;
+    struct FuncTaskCache;
+    struct ElasticContext;
+    struct ThreadStats;
+    struct TimerContext;
+
+    /** a closure stored in place. `invoke` runs and destroys the closure. */
+    class FuncTask final : public IntrusiveThreadTask {
+    public:
+        IntrusiveThreadTask* Run() override;
+
+        typename std::aligned_storage<FUNC_TASK_INLINE_SIZE, alignof(std::max_align_t)>::type storage;
+        void (*invoke)(void*);
+        FuncTaskCache* cache;
+    };
+
+    template <typename F, typename Func>
+    static ppl::common::RetCode EmplaceFunc(FuncTask* task, Func&& f, std::true_type /* inline */) {
+        new (&task->storage) F(std::forward<Func>(f));
+        task->invoke = [](void* p) {
+            auto fn = static_cast<F*>(p);
+            (*fn)();
+            fn->~F();
+        };
+        return ppl::common::RC_SUCCESS;
+    }
+
+    template <typename F, typename Func>
+    static ppl::common::RetCode EmplaceFunc(FuncTask* task, Func&& f, std::false_type /* inline */) {
+        auto fn = new (std::nothrow) F(std::forward<Func>(f));
+        if (!fn) {
+            return ppl::common::RC_OUT_OF_MEMORY;
+        }
+        *reinterpret_cast<F**>(&task->storage) = fn;
+        task->invoke = [](void* p) {
+            auto fn = *static_cast<F**>(p);
+            (*fn)();
+            delete fn;
+        };
+        return ppl::common::RC_SUCCESS;
+    }
+
+    template <typename Func>
+    ppl::common::RetCode CreateFuncTask(Func&& f, FuncTask** res) {
+        if (!IsIntrusiveTaskSupported()) {
+            return ppl::common::RC_UNSUPPORTED;
+        }
+
+        typedef typename std::decay<Func>::type F;
+        typedef std::integral_constant<bool, (sizeof(F) <= FUNC_TASK_INLINE_SIZE &&
+                                              alignof(F) <= alignof(std::max_align_t))>
+            IsInline;
+
+        auto task = AllocFuncTask();
+        if (!task) {
+            return ppl::common::RC_OUT_OF_MEMORY;
+        }
+        auto rc = EmplaceFunc<F>(task, std::forward<Func>(f), IsInline());
+        if (rc != ppl::common::RC_SUCCESS) {
+            FreeFuncTask(task);
+            return rc;
+        }
+        *res = task;
+        return ppl::common::RC_SUCCESS;
+    }
+
+    FuncTask* AllocFuncTask();
+    void FreeFuncTask(FuncTask*);
+    /** wakes up a thread for a new task */
+    void NotifyWorkers();
+    /** returns the timer context, which is created and started on the first call */
+    TimerContext* GetTimerContext();
+    ppl::common::RetCode AddTimer(const std::shared_ptr<ThreadTask>&, uint64_t delay_us, uint64_t period_us,
+                                  uint64_t* timer_id, uint32_t queue_idx);
+
     static void* ThreadWorker(void*);
+    /** starts threads in slots [first_idx, first_idx + thread_num) of `threads_` */
+    ppl::common::RetCode StartThreads(uint32_t first_idx, uint32_t thread_num);
+    static void* ElasticControllerWorker(void*);
+    static void* TimerWorker(void*);
+    void QueueWorkerLoop(ThreadTaskQueue*);
+    void LockFreeQueueWorkerLoop();
+    void WorkStealingWorkerLoop(uint32_t thread_idx);
 
     std::vector<ThreadInfo> threads_;
+    SchedPolicy policy_ = SCHED_SHARED_QUEUE;
     ThreadTaskQueue* queues_ = nullptr;
     uint32_t queue_num_ = 0;
+    LockFreeThreadTaskQueue* lf_queue_ = nullptr;
+    WorkStealingContext* ws_ctx_ = nullptr;
+    ElasticContext* elastic_ctx_ = nullptr;
+    std::atomic<TimerContext*> timer_ctx_;
+#ifdef PPLCOMMON_ENABLE_THREADPOOL_STATS
+    ThreadStats* stats_ = nullptr;
+#endif
+    std::vector<NumaNode> numa_nodes_;
     uint32_t cpu_core_num_;
 
 private:
@@ -109,14 +447,120 @@ private:
 };
 
 class StaticThreadPool final {
+public:
+    /** the max number of jobs in flight of a team */
+    static constexpr uint32_t JOB_RING_SIZE = 8;
+
 private:
-    struct ThreadInfo final {
-        pthread_t pid;
-        uint32_t thread_idx;
-        StaticThreadPool* pool;
+    // l1 cache line size for most CPUs
+    static constexpr int CACHELINE_SIZE = 64;
+    static constexpr uint32_t SPIN_COUNT = 1024;
+
+public:
+    enum Schedule {
+        /** each thread gets a contiguous block of chunks */
+        SCHEDULE_STATIC,
+        /** threads grab `grain` iterations at a time from a shared counter */
+        SCHEDULE_DYNAMIC,
+        /** like SCHEDULE_DYNAMIC, but chunk size starts large and shrinks to `grain` as work runs out */
+        SCHEDULE_GUIDED,
+    };
+
+    typedef std::function<void(uint32_t nr_threads, uint32_t thread_idx)> RunFunc;
+
+    /**
+       a group of threads of the pool with its own job ring, which runs jobs independently of other teams.
+       `nr_threads` and `thread_idx` passed to jobs are relative to the team. see `Split()`.
+    */
+    class Team final {
+    public:
+        uint32_t GetNumThreads() const {
+            return thread_indices_.size();
+        }
+        /** indices of threads in the pool */
+        const std::vector<uint32_t>& GetThreadIndices() const {
+            return thread_indices_;
+        }
+
+        /** @see `StaticThreadPool::Run()` */
+        void Run(const RunFunc& f);
+        /** @see `StaticThreadPool::RunAsync()` */
+        uint64_t RunAsync(const RunFunc& f, bool after_previous = false);
+        void Wait();
+        void Wait(uint64_t job_id);
+
+        /** @see `StaticThreadPool::ParallelFor()` */
+        void ParallelFor(int64_t begin, int64_t end, int64_t grain,
+                         const std::function<void(int64_t begin, int64_t end)>& f,
+                         Schedule schedule = SCHEDULE_STATIC);
+        void ParallelFor2D(int64_t n0, int64_t n1, int64_t tile0, int64_t tile1,
+                           const std::function<void(int64_t begin0, int64_t end0, int64_t begin1, int64_t end1)>& f,
+                           Schedule schedule = SCHEDULE_STATIC);
+        void ParallelFor3D(int64_t n0, int64_t n1, int64_t n2, int64_t tile0, int64_t tile1, int64_t tile2,
+                           const std::function<void(int64_t begin0, int64_t end0, int64_t begin1, int64_t end1,
+                                                    int64_t begin2, int64_t end2)>& f,
+                           Schedule schedule = SCHEDULE_STATIC);
+        /** @see `StaticThreadPool::ParallelReduce()` */
+        template <typename T, typename MapFunc, typename CombineFunc>
+        T ParallelReduce(int64_t begin, int64_t end, int64_t grain, const T& identity, const MapFunc& map,
+                         const CombineFunc& combine, Schedule schedule = SCHEDULE_STATIC);
+
+    private:
+        friend class StaticThreadPool;
+
+        enum JobType {
+            JOB_RUN,
+            /** threads move to the teams assigned by `StaticThreadPool::SwitchTeams()` */
+            JOB_SWITCH,
+            /** threads exit */
+            JOB_STOP,
+        };
+
+        struct Job final {
+            Job() : remaining(0) {}
+            RunFunc func;
+            JobType type = JOB_RUN;
+            bool after_previous = false;
+            /** the number of threads which have not finished this job. the last one cleans up `func`. */
+            union {
+                std::atomic<uint32_t> remaining;
+                char padding[CACHELINE_SIZE];
+            };
+        };
+
+        Team(StaticThreadPool* pool, const std::vector<uint32_t>& thread_indices)
+            : submitted_(0), completed_(0), pool_(pool), thread_indices_(thread_indices) {}
+        uint64_t Submit(const RunFunc& f, JobType type, bool after_previous);
+        /** calls `f` for chunks of [begin, end) assigned to `thread_idx`. `next` is shared by all threads. */
+        static void ForEachChunk(int64_t begin, int64_t end, int64_t grain, Schedule schedule, uint32_t nr_threads,
+                                 uint32_t thread_idx, std::atomic<int64_t>* next,
+                                 const std::function<void(int64_t begin, int64_t end)>& f);
+
+    private:
+        Job jobs_[JOB_RING_SIZE]; // job `id` is in `jobs_[id % JOB_RING_SIZE]`
+        /** ids of jobs start from 1 */
+        union {
+            std::atomic<uint64_t> submitted_;
+            char padding1_[CACHELINE_SIZE];
+        };
+        union {
+            std::atomic<uint64_t> completed_;
+            char padding2_[CACHELINE_SIZE];
+        };
+        EventCount submit_event_;
+        EventCount complete_event_;
+        StaticThreadPool* pool_;
+        std::vector<uint32_t> thread_indices_;
+
+    private:
+        Team(const Team&) = delete;
+        Team(Team&&) = delete;
+        void operator=(const Team&) = delete;
+        void operator=(Team&&) = delete;
     };
 
 public:
+    StaticThreadPool() : switched_num_(0) {}
     ~StaticThreadPool() {
         Destroy();
     }
@@ -127,22 +571,192 @@ public:
     }
     void Destroy();
 
-    void Run(const std::function<void(uint32_t nr_threads, uint32_t thread_idx)>& f);
+    /**
+       @brief pins thread `thread_idx` to `core_list`. the thread pins itself in a job of its team, so that it
+       works on all platforms. the pinned cores are used to place threads by `Split()`.
+    */
+    ppl::common::RetCode SetAffinity(uint32_t thread_idx, const uint32_t* core_list, uint32_t core_num);
+
+    /**
+       @brief splits threads into teams of `sizes[i]` threads, which sum up to `GetNumThreads()`. threads are
+       ordered by the numa nodes and cores they are pinned to, so that each team gets neighboring cores.
+       it waits for all jobs to finish first. returned teams are valid until the next `Split()`, `Merge()` or
+       `Destroy()`, and the functions below MUST NOT be called until `Merge()`.
+    */
+    ppl::common::RetCode Split(const std::vector<uint32_t>& sizes, std::vector<Team*>* teams);
+    /** merges all teams back into one team of all threads after their jobs finish */
+    ppl::common::RetCode Merge();
+    bool IsSplit() const {
+        return (teams_.size() > 1);
+    }
 
-    /** callers MUST make sure that the last call is finished before starting another new call */
-    void RunAsync(const std::function<void(uint32_t nr_threads, uint32_t thread_idx)>& f);
+    /** runs `f` in all threads after earlier jobs complete, and waits for it */
+    void Run(const RunFunc& f);
 
+    /**
+       @brief queues `f` to be run by all threads and returns the id of the job without waiting for it.
+       up to `JOB_RING_SIZE` jobs can be in flight, and this function blocks if there are more.
+       jobs are run in order. a thread starts its part of the next job as soon as it finishes its part of the
+       current one, so `f` MUST NOT depend on other threads' results of earlier jobs, unless `after_previous` is
+       true, in which case all threads wait for the previous job to complete before running `f`.
+       @note MUST be called by one thread at a time.
+    */
+    uint64_t RunAsync(const RunFunc& f, bool after_previous = false);
+
+    /** waits for all jobs */
     void Wait();
+    /** waits for the job returned by `RunAsync()`, and jobs before it */
+    void Wait(uint64_t job_id);
+
+    /** @see `ThreadPool::GetStats()` */
+    ppl::common::RetCode GetStats(std::vector<StaticThreadPoolThreadStats>*) const;
+
+    /**
+       @brief splits [begin, end) into chunks of at least `grain` iterations and calls `f(chunk_begin, chunk_end)`
+       for each chunk in the pool. `f` is called in the current thread if there is only one chunk.
+    */
+    void ParallelFor(int64_t begin, int64_t end, int64_t grain,
+                     const std::function<void(int64_t begin, int64_t end)>& f,
+                     Schedule schedule = SCHEDULE_STATIC);
+
+    /** @brief calls `f(begin0, end0, begin1, end1)` for each tile of shape `tile0` x `tile1` in [0, n0) x [0, n1). */
+    void ParallelFor2D(int64_t n0, int64_t n1, int64_t tile0, int64_t tile1,
+                       const std::function<void(int64_t begin0, int64_t end0, int64_t begin1, int64_t end1)>& f,
+                       Schedule schedule = SCHEDULE_STATIC);
+
+    /** @brief 3D version of `ParallelFor2D()`. */
+    void ParallelFor3D(int64_t n0, int64_t n1, int64_t n2, int64_t tile0, int64_t tile1, int64_t tile2,
+                       const std::function<void(int64_t begin0, int64_t end0, int64_t begin1, int64_t end1,
+                                                int64_t begin2, int64_t end2)>& f,
+                       Schedule schedule = SCHEDULE_STATIC);
+
+    /**
+       @brief reduces [begin, end) in parallel. each thread accumulates its chunks into its own copy of `identity`
+       by `map(chunk_begin, chunk_end, &partial)`, and partials are merged pairwise in a tree by
+       `combine(&dst, src)` as threads finish. partials are updated in place, so `T` can be a vector, e.g.
+       per-channel min/max of `TensorQuantParam`. partials of adjacent threads are merged in order, so `combine`
+       MUST be associative, and also commutative unless `schedule` is SCHEDULE_STATIC.
+    */
+    template <typename T, typename MapFunc, typename CombineFunc>
+    T ParallelReduce(int64_t begin, int64_t end, int64_t grain, const T& identity, const MapFunc& map,
+                     const CombineFunc& combine, Schedule schedule = SCHEDULE_STATIC) {
+        if (teams_.empty()) {
+            T result(identity);
+            if (begin < end) {
+                map(begin, end, &result);
+            }
+            return result;
+        }
+        return teams_[0]->ParallelReduce(begin, end, grain, identity, map, combine, schedule);
+    }
 
 private:
+    struct ThreadStats;
+
+    /** the partial result of a thread in `ParallelReduce()`, which occupies its own cache line(s) */
+    template <typename T>
+    struct ReducePartial final {
+        ReducePartial() : merged(0) {}
+        T* Get() {
+            return reinterpret_cast<T*>(&storage);
+        }
+
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+        /** bit `i` is set by the first of the two threads which merge partials at level `i` of the tree */
+        std::atomic<uint32_t> merged;
+        char padding[CACHELINE_SIZE];
+    };
+
+    struct ThreadInfo final {
+        pthread_t pid;
+        uint32_t thread_idx;
+        StaticThreadPool* pool;
+        /** the team of this thread and the index in it. changed by the thread itself in JOB_SWITCH. */
+        Team* team;
+        uint32_t team_thread_idx;
+        /** set before JOB_SWITCH is submitted */
+        Team* next_team;
+        uint32_t next_team_thread_idx;
+        /** cores pinned by `SetAffinity()`. empty if not pinned. */
+        std::vector<uint32_t> cpus;
+    };
+
     static void* ThreadWorker(void*);
+    /** moves threads to `teams` according to `next_team` of threads. all jobs MUST be finished. */
+    void SwitchTeams(std::vector<std::unique_ptr<Team>>* teams);
 
 private:
     std::vector<ThreadInfo> threads_;
-    std::function<void(uint32_t nr_threads, uint32_t thread_idx)> func_;
-    Barrier barrier_;
+    /** one team of all threads unless the pool is split */
+    std::vector<std::unique_ptr<Team>> teams_;
+    std::atomic<uint32_t> switched_num_;
+    EventCount switch_event_;
+    uint32_t spin_count_ = 0;
+#ifdef PPLCOMMON_ENABLE_THREADPOOL_STATS
+    ThreadStats* stats_ = nullptr;
+#endif
+
+private:
+    StaticThreadPool(const StaticThreadPool&) = delete;
+    StaticThreadPool(StaticThreadPool&&) = delete;
+    void operator=(const StaticThreadPool&) = delete;
+    void operator=(StaticThreadPool&&) = delete;
 };
 
+template <typename T, typename MapFunc, typename CombineFunc>
+T StaticThreadPool::Team::ParallelReduce(int64_t begin, int64_t end, int64_t grain, const T& identity,
+                                         const MapFunc& map, const CombineFunc& combine, Schedule schedule) {
+    if (grain < 1) {
+        grain = 1;
+    }
+    if (end - begin <= grain) {
+        T result(identity);
+        if (begin < end) {
+            map(begin, end, &result);
+        }
+        return result;
+    }
+
+    std::unique_ptr<ReducePartial<T>[]> partials(new ReducePartial<T>[GetNumThreads()]);
+    std::atomic<int64_t> next(begin);
+
+    Run([begin, end, grain, schedule, &identity, &map, &combine, &partials, &next](uint32_t nr_threads,
+                                                                                  uint32_t thread_idx) {
+        // constructed by the thread which uses it
+        T* partial = new (partials[thread_idx].Get()) T(identity);
+        ForEachChunk(begin, end, grain, schedule, nr_threads, thread_idx, &next,
+                     [&map, partial](int64_t b, int64_t e) {
+                         map(b, e, partial);
+                     });
+
+        /*
+          at level `i`, partial `left + 2^i` is merged into `left` by the one which arrives later of the two
+          threads holding them, and the other one leaves. the result is in partial 0 when all threads finish.
+        */
+        uint32_t idx = thread_idx;
+        for (uint32_t level = 0, stride = 1; stride < nr_threads; ++level, stride <<= 1) {
+            const uint32_t left = idx & ~(2 * stride - 1);
+            const uint32_t right = left + stride;
+            if (right >= nr_threads) {
+                continue;
+            }
+            const uint32_t bit = (1u << level);
+            if (!(partials[left].merged.fetch_or(bit, std::memory_order_acq_rel) & bit)) {
+                return;
+            }
+            T* src = partials[right].Get();
+            combine(partials[left].Get(), *src);
+            src->~T();
+            idx = left;
+        }
+    });
+
+    T* partial = partials[0].Get();
+    T result(std::move(*partial));
+    partial->~T();
+    return result;
+}
+
 }}
 
 #endif
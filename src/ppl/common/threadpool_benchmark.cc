@@ -0,0 +1,352 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "ppl/common/threadpool.h"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+using namespace std;
+using namespace ppl::common;
+
+static constexpr uint32_t TASK_NUM = 1 << 14;
+
+class EmptyTask final : public ThreadTask {
+public:
+    EmptyTask(atomic<uint32_t>* counter) : counter_(counter) {}
+    shared_ptr<ThreadTask> Run() override {
+        counter_->fetch_add(1, memory_order_relaxed);
+        return shared_ptr<ThreadTask>();
+    }
+
+private:
+    atomic<uint32_t>* counter_;
+};
+
+/** spawns two subtasks until `depth` reaches 0 */
+class ForkTask final : public ThreadTask {
+public:
+    ForkTask(ThreadPool* tp, uint32_t queue_num, atomic<uint32_t>* counter, uint32_t depth)
+        : tp_(tp), queue_num_(queue_num), counter_(counter), depth_(depth) {}
+    shared_ptr<ThreadTask> Run() override {
+        counter_->fetch_add(1, memory_order_relaxed);
+        if (depth_ == 0) {
+            return shared_ptr<ThreadTask>();
+        }
+        const uint32_t queue_idx = depth_ % queue_num_;
+        tp_->AddTask(make_shared<ForkTask>(tp_, queue_num_, counter_, depth_ - 1), queue_idx);
+        tp_->AddTask(make_shared<ForkTask>(tp_, queue_num_, counter_, depth_ - 1), queue_idx);
+        return shared_ptr<ThreadTask>();
+    }
+
+private:
+    ThreadPool* tp_;
+    uint32_t queue_num_;
+    atomic<uint32_t>* counter_;
+    uint32_t depth_;
+};
+
+static void WaitForCount(const atomic<uint32_t>& counter, uint32_t expected) {
+    while (counter.load(memory_order_acquire) < expected) {
+        this_thread::yield();
+    }
+}
+
+static void BM_ThreadPoolSubmit(benchmark::State& state, ThreadPool::SchedPolicy policy) {
+    const uint32_t thread_num = state.range(0);
+    ThreadPool tp;
+    tp.Init(thread_num, policy);
+
+    const uint32_t queue_num = (policy == ThreadPool::SCHED_PER_THREAD_QUEUE) ? thread_num : 1;
+
+    atomic<uint32_t> counter(0);
+    for (auto _ : state) {
+        counter.store(0, memory_order_relaxed);
+        for (uint32_t i = 0; i < TASK_NUM; ++i) {
+            tp.AddTask(make_shared<EmptyTask>(&counter), i % queue_num);
+        }
+        WaitForCount(counter, TASK_NUM);
+    }
+    state.SetItemsProcessed(state.iterations() * TASK_NUM);
+}
+
+static void BM_ThreadPoolFork(benchmark::State& state, ThreadPool::SchedPolicy policy) {
+    const uint32_t thread_num = state.range(0);
+    const uint32_t depth = 13;
+    const uint32_t total = (1u << (depth + 1)) - 1;
+
+    ThreadPool tp;
+    tp.Init(thread_num, policy);
+
+    const uint32_t queue_num = (policy == ThreadPool::SCHED_PER_THREAD_QUEUE) ? thread_num : 1;
+
+    atomic<uint32_t> counter(0);
+    for (auto _ : state) {
+        counter.store(0, memory_order_relaxed);
+        tp.AddTask(make_shared<ForkTask>(&tp, queue_num, &counter, depth));
+        WaitForCount(counter, total);
+    }
+    state.SetItemsProcessed(state.iterations() * total);
+}
+
+BENCHMARK_CAPTURE(BM_ThreadPoolSubmit, shared_queue, ThreadPool::SCHED_SHARED_QUEUE)
+    ->RangeMultiplier(2)->Range(1, 64)->UseRealTime();
+BENCHMARK_CAPTURE(BM_ThreadPoolSubmit, per_thread_queue, ThreadPool::SCHED_PER_THREAD_QUEUE)
+    ->RangeMultiplier(2)->Range(1, 64)->UseRealTime();
+BENCHMARK_CAPTURE(BM_ThreadPoolSubmit, work_stealing, ThreadPool::SCHED_WORK_STEALING)
+    ->RangeMultiplier(2)->Range(1, 64)->UseRealTime();
+BENCHMARK_CAPTURE(BM_ThreadPoolSubmit, lock_free_queue, ThreadPool::SCHED_LOCK_FREE_QUEUE)
+    ->RangeMultiplier(2)->Range(1, 64)->UseRealTime();
+
+BENCHMARK_CAPTURE(BM_ThreadPoolFork, shared_queue, ThreadPool::SCHED_SHARED_QUEUE)
+    ->RangeMultiplier(2)->Range(1, 64)->UseRealTime();
+BENCHMARK_CAPTURE(BM_ThreadPoolFork, per_thread_queue, ThreadPool::SCHED_PER_THREAD_QUEUE)
+    ->RangeMultiplier(2)->Range(1, 64)->UseRealTime();
+BENCHMARK_CAPTURE(BM_ThreadPoolFork, work_stealing, ThreadPool::SCHED_WORK_STEALING)
+    ->RangeMultiplier(2)->Range(1, 64)->UseRealTime();
+BENCHMARK_CAPTURE(BM_ThreadPoolFork, lock_free_queue, ThreadPool::SCHED_LOCK_FREE_QUEUE)
+    ->RangeMultiplier(2)->Range(1, 64)->UseRealTime();
+
+/* ------------------------------------------------------------------------- */
+
+/** submission overhead of fine-grained tasks from a worker thread, which is the common case of fork-join */
+static void BM_ThreadPoolAddTaskFromWorker(benchmark::State& state) {
+    ThreadPool tp;
+    tp.Init(state.range(0), ThreadPool::SCHED_WORK_STEALING);
+
+    atomic<uint32_t> counter(0);
+    for (auto _ : state) {
+        counter.store(0, memory_order_relaxed);
+        atomic<bool> done(false);
+        tp.AddFunc([&tp, &counter, &done]() {
+            for (uint32_t i = 0; i < TASK_NUM; ++i) {
+                tp.AddTask(make_shared<EmptyTask>(&counter));
+            }
+            done.store(true, memory_order_release);
+        });
+        WaitForCount(counter, TASK_NUM);
+        while (!done.load(memory_order_acquire)) {
+            this_thread::yield();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * TASK_NUM);
+}
+
+static void BM_ThreadPoolAddFuncFromWorker(benchmark::State& state) {
+    ThreadPool tp;
+    tp.Init(state.range(0), ThreadPool::SCHED_WORK_STEALING);
+
+    atomic<uint32_t> counter(0);
+    for (auto _ : state) {
+        counter.store(0, memory_order_relaxed);
+        atomic<bool> done(false);
+        tp.AddFunc([&tp, &counter, &done]() {
+            for (uint32_t i = 0; i < TASK_NUM; ++i) {
+                tp.AddFunc([&counter]() {
+                    counter.fetch_add(1, memory_order_relaxed);
+                });
+            }
+            done.store(true, memory_order_release);
+        });
+        WaitForCount(counter, TASK_NUM);
+        while (!done.load(memory_order_acquire)) {
+            this_thread::yield();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * TASK_NUM);
+}
+
+static void BM_ThreadPoolAddFuncFromExternal(benchmark::State& state) {
+    ThreadPool tp;
+    tp.Init(state.range(0), ThreadPool::SCHED_WORK_STEALING);
+
+    atomic<uint32_t> counter(0);
+    for (auto _ : state) {
+        counter.store(0, memory_order_relaxed);
+        for (uint32_t i = 0; i < TASK_NUM; ++i) {
+            tp.AddFunc([&counter]() {
+                counter.fetch_add(1, memory_order_relaxed);
+            });
+        }
+        WaitForCount(counter, TASK_NUM);
+    }
+    state.SetItemsProcessed(state.iterations() * TASK_NUM);
+}
+
+BENCHMARK(BM_ThreadPoolAddTaskFromWorker)->RangeMultiplier(2)->Range(1, 64)->UseRealTime();
+BENCHMARK(BM_ThreadPoolAddFuncFromWorker)->RangeMultiplier(2)->Range(1, 64)->UseRealTime();
+BENCHMARK(BM_ThreadPoolAddFuncFromExternal)->RangeMultiplier(2)->Range(1, 64)->UseRealTime();
+
+/* ------------------------------------------------------------------------- */
+
+static void BusyWaitUs(uint32_t us) {
+    const auto end = chrono::steady_clock::now() + chrono::microseconds(us);
+    while (chrono::steady_clock::now() < end) {
+    }
+}
+
+/** a background task of normal priority which adds itself again until `stop` is set */
+static void BackgroundTask(ThreadPool* tp, const atomic<bool>* stop, atomic<uint32_t>* running) {
+    if (stop->load(memory_order_relaxed)) {
+        running->fetch_sub(1, memory_order_relaxed);
+        return;
+    }
+    BusyWaitUs(10);
+    tp->AddFunc([tp, stop, running]() {
+        BackgroundTask(tp, stop, running);
+    });
+}
+
+/** latency between adding a task and starting it while the pool is saturated by background tasks */
+static void BM_ThreadPoolPriorityLatency(benchmark::State& state, ThreadPool::Priority priority) {
+    const uint32_t thread_num = state.range(0);
+    const uint32_t background_num = thread_num * 16;
+
+    ThreadPool tp;
+    tp.Init(thread_num, ThreadPool::SCHED_WORK_STEALING);
+
+    atomic<bool> stop(false);
+    atomic<uint32_t> running(background_num);
+    for (uint32_t i = 0; i < background_num; ++i) {
+        tp.AddFunc([&tp, &stop, &running]() {
+            BackgroundTask(&tp, &stop, &running);
+        });
+    }
+
+    vector<double> latencies;
+    for (auto _ : state) {
+        atomic<int64_t> start_ns(0);
+        const auto submit = chrono::steady_clock::now();
+        tp.AddFunc([&start_ns]() {
+            start_ns.store(chrono::steady_clock::now().time_since_epoch().count(), memory_order_release);
+        }, priority);
+        while (start_ns.load(memory_order_acquire) == 0) {
+            this_thread::yield();
+        }
+        latencies.push_back((start_ns.load() - submit.time_since_epoch().count()) / 1000.0);
+    }
+
+    stop.store(true);
+    while (running.load() > 0) {
+        this_thread::yield();
+    }
+
+    sort(latencies.begin(), latencies.end());
+    state.counters["p50_us"] = latencies[latencies.size() / 2];
+    state.counters["p99_us"] = latencies[latencies.size() * 99 / 100];
+}
+
+BENCHMARK_CAPTURE(BM_ThreadPoolPriorityLatency, high, ThreadPool::PRIORITY_HIGH)
+    ->RangeMultiplier(2)->Range(1, 8)->Iterations(2000)->UseRealTime();
+BENCHMARK_CAPTURE(BM_ThreadPoolPriorityLatency, normal, ThreadPool::PRIORITY_NORMAL)
+    ->RangeMultiplier(2)->Range(1, 8)->Iterations(2000)->UseRealTime();
+
+/* ------------------------------------------------------------------------- */
+
+static void BM_StaticThreadPoolRun(benchmark::State& state) {
+    StaticThreadPool tp;
+    tp.Init(state.range(0));
+    for (auto _ : state) {
+        tp.Run([](uint32_t, uint32_t) {});
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+/** back-to-back independent jobs, in which threads go to the next job without waiting for each other */
+static void BM_StaticThreadPoolRunAsync(benchmark::State& state) {
+    StaticThreadPool tp;
+    tp.Init(state.range(0));
+    for (auto _ : state) {
+        tp.RunAsync([](uint32_t, uint32_t) {});
+    }
+    tp.Wait();
+    state.SetItemsProcessed(state.iterations());
+}
+
+/** two callers run jobs concurrently on two halves of the pool */
+static void BM_StaticThreadPoolSplitRun(benchmark::State& state) {
+    StaticThreadPool tp;
+    tp.Init(state.range(0) * 2);
+    vector<StaticThreadPool::Team*> teams;
+    tp.Split({(uint32_t)state.range(0), (uint32_t)state.range(0)}, &teams);
+
+    atomic<bool> stop(false);
+    thread other([&teams, &stop]() {
+        while (!stop.load(memory_order_relaxed)) {
+            teams[1]->Run([](uint32_t, uint32_t) {});
+        }
+    });
+    for (auto _ : state) {
+        teams[0]->Run([](uint32_t, uint32_t) {});
+    }
+    stop.store(true);
+    other.join();
+    state.SetItemsProcessed(state.iterations());
+}
+
+static const int64_t REDUCE_SIZE = 1 << 20;
+
+/** sums into adjacent per-thread slots, which share cache lines */
+static void BM_StaticThreadPoolReduceUnpadded(benchmark::State& state) {
+    StaticThreadPool tp;
+    tp.Init(state.range(0));
+    vector<int64_t> data(REDUCE_SIZE, 1);
+    for (auto _ : state) {
+        vector<int64_t> partials(tp.GetNumThreads(), 0);
+        tp.Run([&data, &partials](uint32_t nr_threads, uint32_t thread_idx) {
+            const int64_t b = REDUCE_SIZE * thread_idx / nr_threads;
+            const int64_t e = REDUCE_SIZE * (thread_idx + 1) / nr_threads;
+            for (int64_t i = b; i < e; ++i) {
+                benchmark::DoNotOptimize(partials[thread_idx] += data[i]);
+            }
+        });
+        int64_t sum = 0;
+        for (auto x = partials.begin(); x != partials.end(); ++x) {
+            sum += *x;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * REDUCE_SIZE);
+}
+
+static void BM_StaticThreadPoolParallelReduce(benchmark::State& state) {
+    StaticThreadPool tp;
+    tp.Init(state.range(0));
+    vector<int64_t> data(REDUCE_SIZE, 1);
+    for (auto _ : state) {
+        const int64_t sum = tp.ParallelReduce(
+            0, REDUCE_SIZE, 4096, (int64_t)0,
+            [&data](int64_t b, int64_t e, int64_t* acc) {
+                for (int64_t i = b; i < e; ++i) {
+                    benchmark::DoNotOptimize(*acc += data[i]);
+                }
+            },
+            [](int64_t* dst, int64_t src) {
+                *dst += src;
+            });
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * REDUCE_SIZE);
+}
+
+BENCHMARK(BM_StaticThreadPoolRun)->RangeMultiplier(2)->Range(1, 64)->UseRealTime();
+BENCHMARK(BM_StaticThreadPoolSplitRun)->RangeMultiplier(2)->Range(1, 32)->UseRealTime();
+BENCHMARK(BM_StaticThreadPoolRunAsync)->RangeMultiplier(2)->Range(1, 64)->UseRealTime();
+BENCHMARK(BM_StaticThreadPoolReduceUnpadded)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+BENCHMARK(BM_StaticThreadPoolParallelReduce)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
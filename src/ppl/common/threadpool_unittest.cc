@@ -1,5 +1,13 @@
 #include "ppl/common/threadpool.h"
+#include "ppl/common/object_pool.h"
+#include "ppl/common/tensor_quant_param.h"
 #include "gtest/gtest.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
 using namespace std;
 using namespace ppl::common;
 
@@ -24,3 +32,797 @@ TEST(ThreadPoolTest, all) {
     const uint32_t core_list[] = {0, 1};
     ASSERT_TRUE(tp.SetAffinity(0, core_list, 2) == RC_SUCCESS);
 }
+
+class CountingThreadTask final : public ThreadTask {
+public:
+    CountingThreadTask(ThreadPool* tp, std::atomic<uint32_t>* counter, uint32_t depth)
+        : tp_(tp), counter_(counter), depth_(depth) {}
+    shared_ptr<ThreadTask> Run() override {
+        if (depth_ > 0) {
+            tp_->AddTask(make_shared<CountingThreadTask>(tp_, counter_, depth_ - 1));
+            counter_->fetch_add(1);
+            // continuation
+            return make_shared<CountingThreadTask>(tp_, counter_, depth_ - 1);
+        }
+        counter_->fetch_add(1);
+        return shared_ptr<ThreadTask>();
+    }
+
+private:
+    ThreadPool* tp_;
+    std::atomic<uint32_t>* counter_;
+    uint32_t depth_;
+};
+
+TEST(ThreadPoolTest, work_stealing) {
+    std::atomic<uint32_t> counter(0);
+    const uint32_t depth = 10;
+    const uint32_t root_num = 4;
+
+    {
+        ThreadPool tp;
+        ASSERT_EQ(RC_SUCCESS, tp.Init(4, ThreadPool::SCHED_WORK_STEALING));
+        for (uint32_t i = 0; i < root_num; ++i) {
+            ASSERT_EQ(RC_SUCCESS, tp.AddTask(make_shared<CountingThreadTask>(&tp, &counter, depth)));
+        }
+        // pending tasks are finished before threads exit
+    }
+
+    // each task spawns two subtasks, so a tree of `depth` has 2^(depth + 1) - 1 nodes
+    ASSERT_EQ(root_num * ((1u << (depth + 1)) - 1), counter.load());
+}
+
+class MutexLock final {
+public:
+    void ReadLock() {
+        mutex_.lock();
+    }
+    void WriteLock() {
+        mutex_.lock();
+    }
+    void Unlock() {
+        mutex_.unlock();
+    }
+
+private:
+    std::mutex mutex_;
+};
+
+class CountingIntrusiveTask final : public IntrusiveThreadTask {
+public:
+    typedef ObjectPool<CountingIntrusiveTask, MutexLock> TaskPool;
+
+    CountingIntrusiveTask(ThreadPool* tp, TaskPool* pool, std::atomic<uint32_t>* counter, uint32_t depth)
+        : tp_(tp), pool_(pool), counter_(counter), depth_(depth) {}
+
+    IntrusiveThreadTask* Run() override {
+        counter_->fetch_add(1);
+        IntrusiveThreadTask* next = nullptr;
+        if (depth_ > 0) {
+            EXPECT_EQ(RC_SUCCESS, tp_->AddTask(pool_->Alloc(tp_, pool_, counter_, depth_ - 1)));
+            next = pool_->Alloc(tp_, pool_, counter_, depth_ - 1);
+        }
+        // this task is not touched by the pool after it is released
+        pool_->Free(this);
+        return next;
+    }
+
+private:
+    ThreadPool* tp_;
+    TaskPool* pool_;
+    std::atomic<uint32_t>* counter_;
+    uint32_t depth_;
+};
+
+TEST(ThreadPoolTest, intrusive_task) {
+    std::atomic<uint32_t> counter(0);
+    const uint32_t depth = 10;
+    CountingIntrusiveTask::TaskPool task_pool;
+
+    {
+        ThreadPool tp;
+        ASSERT_EQ(RC_SUCCESS, tp.Init(4, ThreadPool::SCHED_WORK_STEALING));
+        ASSERT_EQ(RC_SUCCESS, tp.AddTask(task_pool.Alloc(&tp, &task_pool, &counter, depth)));
+    }
+
+    ASSERT_EQ((1u << (depth + 1)) - 1, counter.load());
+
+    ThreadPool tp;
+    ASSERT_EQ(RC_SUCCESS, tp.Init(1, ThreadPool::SCHED_SHARED_QUEUE));
+    auto task = task_pool.Alloc(&tp, &task_pool, &counter, 0);
+    EXPECT_EQ(RC_UNSUPPORTED, tp.AddTask(task));
+    task_pool.Free(task);
+}
+
+static void SpawnFuncs(ThreadPool* tp, std::atomic<uint32_t>* counter, uint32_t depth) {
+    counter->fetch_add(1);
+    if (depth > 0) {
+        for (uint32_t i = 0; i < 2; ++i) {
+            EXPECT_EQ(RC_SUCCESS, tp->AddFunc([tp, counter, depth]() {
+                SpawnFuncs(tp, counter, depth - 1);
+            }));
+        }
+    }
+}
+
+TEST(ThreadPoolTest, add_func) {
+    std::atomic<uint32_t> counter(0);
+    std::atomic<uint32_t> large_counter(0);
+    const uint32_t depth = 10;
+    const uint32_t root_num = 4;
+
+    {
+        ThreadPool tp;
+        ASSERT_EQ(RC_SUCCESS, tp.Init(4, ThreadPool::SCHED_WORK_STEALING));
+        for (uint32_t i = 0; i < root_num; ++i) {
+            ASSERT_EQ(RC_SUCCESS, tp.AddFunc([&tp, &counter, depth]() {
+                SpawnFuncs(&tp, &counter, depth);
+            }));
+        }
+
+        // closures larger than FUNC_TASK_INLINE_SIZE
+        struct {
+            char data[ThreadPool::FUNC_TASK_INLINE_SIZE];
+        } payload;
+        payload.data[0] = 1;
+        for (uint32_t i = 0; i < root_num; ++i) {
+            ASSERT_EQ(RC_SUCCESS, tp.AddFunc([payload, &large_counter]() {
+                large_counter.fetch_add(payload.data[0]);
+            }));
+        }
+    }
+
+    ASSERT_EQ(root_num * ((1u << (depth + 1)) - 1), counter.load());
+    ASSERT_EQ(root_num, large_counter.load());
+
+    ThreadPool tp;
+    ASSERT_EQ(RC_SUCCESS, tp.Init(1, ThreadPool::SCHED_LOCK_FREE_QUEUE));
+    EXPECT_EQ(RC_UNSUPPORTED, tp.AddFunc([]() {}));
+}
+
+TEST(ThreadPoolTest, lock_free_queue) {
+    std::atomic<uint32_t> counter(0);
+    const uint32_t depth = 10;
+
+    {
+        ThreadPool tp;
+        // small capacity so that workers have to run subtasks in place
+        ASSERT_EQ(RC_SUCCESS, tp.Init(4, ThreadPool::SCHED_LOCK_FREE_QUEUE, 16));
+        ASSERT_EQ(RC_SUCCESS, tp.AddTask(make_shared<CountingThreadTask>(&tp, &counter, depth)));
+        while (counter.load() < (1u << (depth + 1)) - 1) {
+            std::this_thread::yield();
+        }
+    }
+
+    ASSERT_EQ((1u << (depth + 1)) - 1, counter.load());
+}
+
+TEST(StaticThreadPoolTest, parallel_for) {
+    StaticThreadPool tp;
+    ASSERT_EQ(RC_SUCCESS, tp.Init(4));
+
+    const int64_t begin = 3, end = 1003;
+    const StaticThreadPool::Schedule schedules[] = {
+        StaticThreadPool::SCHEDULE_STATIC,
+        StaticThreadPool::SCHEDULE_DYNAMIC,
+        StaticThreadPool::SCHEDULE_GUIDED,
+    };
+    for (auto s : schedules) {
+        vector<std::atomic<uint32_t>> visited(end);
+        for (auto v = visited.begin(); v != visited.end(); ++v) {
+            v->store(0);
+        }
+        tp.ParallelFor(
+            begin, end, 7,
+            [&visited](int64_t b, int64_t e) {
+                for (int64_t i = b; i < e; ++i) {
+                    visited[i].fetch_add(1);
+                }
+            },
+            s);
+        for (int64_t i = 0; i < end; ++i) {
+            ASSERT_EQ((i < begin) ? 0u : 1u, visited[i].load());
+        }
+    }
+}
+
+TEST(StaticThreadPoolTest, parallel_for_3d) {
+    StaticThreadPool tp;
+    ASSERT_EQ(RC_SUCCESS, tp.Init(3));
+
+    const int64_t n0 = 5, n1 = 7, n2 = 9;
+    vector<std::atomic<uint32_t>> visited(n0 * n1 * n2);
+    for (auto v = visited.begin(); v != visited.end(); ++v) {
+        v->store(0);
+    }
+    tp.ParallelFor3D(
+        n0, n1, n2, 2, 3, 4,
+        [&](int64_t b0, int64_t e0, int64_t b1, int64_t e1, int64_t b2, int64_t e2) {
+            for (int64_t i = b0; i < e0; ++i) {
+                for (int64_t j = b1; j < e1; ++j) {
+                    for (int64_t k = b2; k < e2; ++k) {
+                        visited[(i * n1 + j) * n2 + k].fetch_add(1);
+                    }
+                }
+            }
+        },
+        StaticThreadPool::SCHEDULE_DYNAMIC);
+    for (auto v = visited.begin(); v != visited.end(); ++v) {
+        ASSERT_EQ(1u, v->load());
+    }
+}
+
+TEST(StaticThreadPoolTest, parallel_reduce) {
+    StaticThreadPool tp;
+    ASSERT_EQ(RC_SUCCESS, tp.Init(5));
+
+    const StaticThreadPool::Schedule schedules[] = {
+        StaticThreadPool::SCHEDULE_STATIC,
+        StaticThreadPool::SCHEDULE_DYNAMIC,
+        StaticThreadPool::SCHEDULE_GUIDED,
+    };
+    for (auto s : schedules) {
+        const int64_t sum = tp.ParallelReduce(
+            1, 1001, 7, (int64_t)0,
+            [](int64_t b, int64_t e, int64_t* acc) {
+                for (int64_t i = b; i < e; ++i) {
+                    *acc += i;
+                }
+            },
+            [](int64_t* dst, int64_t src) {
+                *dst += src;
+            },
+            s);
+        ASSERT_EQ(500500, sum);
+    }
+
+    // empty range and a single chunk
+    auto add = [](int64_t b, int64_t e, int64_t* acc) {
+        *acc += e - b;
+    };
+    auto merge = [](int64_t* dst, int64_t src) {
+        *dst += src;
+    };
+    ASSERT_EQ(3, tp.ParallelReduce(5, 5, 1, (int64_t)3, add, merge));
+    ASSERT_EQ(13, tp.ParallelReduce(0, 10, 100, (int64_t)3, add, merge));
+
+    // partials are merged in order with SCHEDULE_STATIC, so concatenation keeps the order of the range
+    const vector<int64_t> seq = tp.ParallelReduce(
+        0, 1000, 3, vector<int64_t>(),
+        [](int64_t b, int64_t e, vector<int64_t>* acc) {
+            for (int64_t i = b; i < e; ++i) {
+                acc->push_back(i);
+            }
+        },
+        [](vector<int64_t>* dst, const vector<int64_t>& src) {
+            dst->insert(dst->end(), src.begin(), src.end());
+        });
+    ASSERT_EQ(1000u, seq.size());
+    for (int64_t i = 0; i < 1000; ++i) {
+        ASSERT_EQ(i, seq[i]);
+    }
+}
+
+TEST(StaticThreadPoolTest, parallel_reduce_per_channel) {
+    StaticThreadPool tp;
+    ASSERT_EQ(RC_SUCCESS, tp.Init(4));
+
+    // per-channel min/max of a [n, c] tensor, as in quantization calibration
+    const int64_t n = 997, c = 16;
+    vector<float> data(n * c);
+    for (int64_t i = 0; i < n; ++i) {
+        for (int64_t j = 0; j < c; ++j) {
+            data[i * c + j] = (float)(((i * 31 + j * 17) % 101) - 50) * (float)(j + 1);
+        }
+    }
+
+    TensorQuantParam identity;
+    identity.min.assign(c, 1e30f);
+    identity.max.assign(c, -1e30f);
+    const TensorQuantParam param = tp.ParallelReduce(
+        0, n, 16, identity,
+        [&data](int64_t b, int64_t e, TensorQuantParam* acc) {
+            for (int64_t i = b; i < e; ++i) {
+                for (int64_t j = 0; j < c; ++j) {
+                    const float v = data[i * c + j];
+                    acc->min[j] = std::min(acc->min[j], v);
+                    acc->max[j] = std::max(acc->max[j], v);
+                }
+            }
+        },
+        [](TensorQuantParam* dst, const TensorQuantParam& src) {
+            for (int64_t j = 0; j < c; ++j) {
+                dst->min[j] = std::min(dst->min[j], src.min[j]);
+                dst->max[j] = std::max(dst->max[j], src.max[j]);
+            }
+        },
+        StaticThreadPool::SCHEDULE_DYNAMIC);
+
+    for (int64_t j = 0; j < c; ++j) {
+        float mn = 1e30f, mx = -1e30f;
+        for (int64_t i = 0; i < n; ++i) {
+            mn = std::min(mn, data[i * c + j]);
+            mx = std::max(mx, data[i * c + j]);
+        }
+        ASSERT_EQ(mn, param.min[j]);
+        ASSERT_EQ(mx, param.max[j]);
+    }
+}
+
+TEST(ThreadPoolTest, numa) {
+    std::atomic<uint32_t> counter(0);
+    const uint32_t depth = 8;
+
+    {
+        ThreadPool tp;
+        // uses real topology of the current machine
+        ASSERT_EQ(RC_SUCCESS, tp.InitNuma(3));
+        ASSERT_FALSE(tp.GetNumaNodes().empty());
+        for (uint32_t i = 0; i < tp.GetNumaNodes().size(); ++i) {
+            ASSERT_EQ(RC_SUCCESS, tp.AddTask(make_shared<CountingThreadTask>(&tp, &counter, depth), i));
+        }
+        while (counter.load() < tp.GetNumaNodes().size() * ((1u << (depth + 1)) - 1)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+TEST(ThreadPoolTest, elastic) {
+    ThreadPool::ElasticOptions options;
+    options.min_thread_num = 1;
+    options.max_thread_num = 4;
+    options.grow_latency_us = 200;
+    options.idle_timeout_ms = 20;
+
+    ThreadPool tp;
+    ASSERT_EQ(RC_SUCCESS, tp.InitElastic(options));
+    ASSERT_EQ(ThreadPool::SCHED_ELASTIC, tp.GetSchedPolicy());
+    ASSERT_EQ(1u, tp.GetThreadNum());
+
+    // blocking tasks keep all threads busy so that the pool grows
+    const uint32_t task_num = 64;
+    std::atomic<uint32_t> counter(0);
+    uint32_t max_thread_num = 0;
+    for (uint32_t i = 0; i < task_num; ++i) {
+        ASSERT_EQ(RC_SUCCESS, tp.AddFunc([&counter]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            counter.fetch_add(1);
+        }));
+    }
+    while (counter.load() < task_num) {
+        max_thread_num = std::max(max_thread_num, tp.GetThreadNum());
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_GT(max_thread_num, 1u);
+    EXPECT_LE(max_thread_num, options.max_thread_num);
+
+    // idle threads exit
+    for (uint32_t i = 0; i < 500 && tp.GetThreadNum() > options.min_thread_num; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(options.min_thread_num, tp.GetThreadNum());
+
+    std::vector<ThreadPool::ElasticThreadInfo> info_list;
+    ASSERT_EQ(RC_SUCCESS, tp.GetElasticThreadInfo(&info_list));
+    ASSERT_EQ(options.max_thread_num, info_list.size());
+    uint64_t total_task_num = 0;
+    uint64_t total_busy_us = 0;
+    uint32_t total_start_num = 0;
+    uint32_t total_retire_num = 0;
+    uint32_t running_num = 0;
+    for (auto info = info_list.begin(); info != info_list.end(); ++info) {
+        total_task_num += info->task_num;
+        total_busy_us += info->busy_us;
+        total_start_num += info->start_num;
+        total_retire_num += info->retire_num;
+        running_num += info->running;
+    }
+    EXPECT_EQ(task_num, total_task_num);
+    EXPECT_GE(total_busy_us, task_num * 2000);
+    EXPECT_EQ(options.min_thread_num, running_num);
+    EXPECT_EQ(total_start_num - options.min_thread_num, total_retire_num);
+
+    // the pool works after shrinking
+    ASSERT_EQ(RC_SUCCESS, tp.AddFunc([&counter]() {
+        counter.fetch_add(1);
+    }));
+    while (counter.load() < task_num + 1) {
+        std::this_thread::yield();
+    }
+}
+
+TEST(ThreadPoolTest, priority) {
+    ThreadPool tp;
+    ASSERT_EQ(RC_SUCCESS, tp.Init(1, ThreadPool::SCHED_WORK_STEALING));
+
+    // blocks the only thread until all tasks are added
+    std::atomic<bool> started(false), gate(false);
+    ASSERT_EQ(RC_SUCCESS, tp.AddFunc([&started, &gate]() {
+        started.store(true);
+        while (!gate.load()) {
+            std::this_thread::yield();
+        }
+    }));
+    while (!started.load()) {
+        std::this_thread::yield();
+    }
+
+    std::mutex mutex;
+    std::vector<int> order;
+    auto record = [&mutex, &order](int v) {
+        return [&mutex, &order, v]() {
+            std::lock_guard<std::mutex> guard(mutex);
+            order.push_back(v);
+        };
+    };
+
+    // low: 0-3, normal: 10-13, high: 20-23, high with deadlines: 30-32
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_EQ(RC_SUCCESS, tp.AddFunc(record(i), ThreadPool::PRIORITY_LOW));
+        ASSERT_EQ(RC_SUCCESS, tp.AddFunc(record(10 + i), ThreadPool::PRIORITY_NORMAL));
+        ASSERT_EQ(RC_SUCCESS, tp.AddFunc(record(20 + i), ThreadPool::PRIORITY_HIGH));
+    }
+    ASSERT_EQ(RC_SUCCESS, tp.AddFunc(record(32), ThreadPool::PRIORITY_HIGH, 30000));
+    ASSERT_EQ(RC_SUCCESS, tp.AddFunc(record(30), ThreadPool::PRIORITY_HIGH, 10000));
+    ASSERT_EQ(RC_SUCCESS, tp.AddFunc(record(31), ThreadPool::PRIORITY_HIGH, 20000));
+    gate.store(true);
+
+    while (true) {
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            if (order.size() == 15) {
+                break;
+            }
+        }
+        std::this_thread::yield();
+    }
+
+    // one search in `PRIORITY_AGING_INTERVAL` starts from the lowest class
+    std::vector<int> position(40, -1);
+    for (uint32_t i = 0; i < order.size(); ++i) {
+        position[order[i]] = i;
+    }
+    EXPECT_LT(position[30], position[31]);
+    EXPECT_LT(position[31], position[32]);
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_LT(position[i], position[i + 1]);
+        EXPECT_LT(position[10 + i], position[10 + i + 1]);
+        EXPECT_LT(position[20 + i], position[20 + i + 1]);
+    }
+    uint32_t nr_aged = 0;
+    for (int i = 0; i < 4; ++i) {
+        nr_aged += (position[i] < position[23]) + (position[10 + i] < position[23]);
+    }
+    EXPECT_LE(nr_aged, 1u);
+
+    EXPECT_EQ(RC_INVALID_VALUE, tp.AddFunc([]() {}, ThreadPool::PRIORITY_NUM));
+}
+
+/** keeps adding high priority tasks until the low priority one runs */
+static void FloodHighPriority(ThreadPool* tp, std::atomic<bool>* low_done, std::atomic<uint32_t>* counter) {
+    if (low_done->load() || counter->fetch_add(1) >= 100000) {
+        return;
+    }
+    tp->AddFunc([tp, low_done, counter]() {
+        FloodHighPriority(tp, low_done, counter);
+    }, ThreadPool::PRIORITY_HIGH);
+}
+
+TEST(ThreadPoolTest, priority_aging) {
+    std::atomic<bool> low_done(false);
+    std::atomic<uint32_t> counter(0);
+    {
+        ThreadPool tp;
+        ASSERT_EQ(RC_SUCCESS, tp.Init(1, ThreadPool::SCHED_WORK_STEALING));
+        ASSERT_EQ(RC_SUCCESS, tp.AddFunc([&tp, &low_done, &counter]() {
+            FloodHighPriority(&tp, &low_done, &counter);
+            ASSERT_EQ(RC_SUCCESS, tp.AddFunc([&low_done]() {
+                low_done.store(true);
+            }, ThreadPool::PRIORITY_LOW));
+        }, ThreadPool::PRIORITY_HIGH));
+    }
+    EXPECT_TRUE(low_done.load());
+    EXPECT_LT(counter.load(), 100000u);
+}
+
+class TimestampThreadTask final : public ThreadTask {
+public:
+    shared_ptr<ThreadTask> Run() override {
+        std::lock_guard<std::mutex> guard(lock);
+        times.push_back(std::chrono::steady_clock::now());
+        return shared_ptr<ThreadTask>();
+    }
+
+    size_t GetRunNum() {
+        std::lock_guard<std::mutex> guard(lock);
+        return times.size();
+    }
+
+    std::mutex lock;
+    std::vector<std::chrono::steady_clock::time_point> times;
+};
+
+TEST(ThreadPoolTest, delayed_task) {
+    const ThreadPool::SchedPolicy policies[] = {ThreadPool::SCHED_SHARED_QUEUE, ThreadPool::SCHED_WORK_STEALING};
+    for (auto policy : policies) {
+        ThreadPool tp;
+        ASSERT_EQ(RC_SUCCESS, tp.Init(2, policy));
+
+        const uint64_t delays_us[] = {0, 1000, 5000, 20000};
+        std::vector<shared_ptr<TimestampThreadTask>> tasks;
+        const auto start = std::chrono::steady_clock::now();
+        for (auto delay : delays_us) {
+            tasks.push_back(make_shared<TimestampThreadTask>());
+            ASSERT_EQ(RC_SUCCESS, tp.AddDelayedTask(tasks.back(), delay));
+        }
+
+        uint64_t cancelled_id = 0;
+        auto cancelled = make_shared<TimestampThreadTask>();
+        ASSERT_EQ(RC_SUCCESS, tp.AddDelayedTask(cancelled, 10000, &cancelled_id));
+        ASSERT_EQ(RC_SUCCESS, tp.CancelTimer(cancelled_id));
+        ASSERT_EQ(RC_NOT_FOUND, tp.CancelTimer(cancelled_id));
+
+        for (uint32_t i = 0; i < 1000 && tasks.back()->GetRunNum() == 0; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        for (uint32_t i = 0; i < tasks.size(); ++i) {
+            ASSERT_EQ(1u, tasks[i]->GetRunNum());
+            ASSERT_GE(tasks[i]->times[0] - start, std::chrono::microseconds(delays_us[i]));
+        }
+        ASSERT_EQ(0u, cancelled->GetRunNum());
+    }
+}
+
+TEST(ThreadPoolTest, periodic_task) {
+    ThreadPool tp;
+    ASSERT_EQ(RC_SUCCESS, tp.Init(2, ThreadPool::SCHED_WORK_STEALING));
+
+    const uint64_t period_us = 2000;
+    auto task = make_shared<TimestampThreadTask>();
+    uint64_t timer_id = 0;
+    ASSERT_EQ(RC_SUCCESS, tp.AddPeriodicTask(task, period_us, &timer_id));
+    ASSERT_EQ(RC_INVALID_VALUE, tp.AddPeriodicTask(task, 0));
+
+    for (uint32_t i = 0; i < 1000 && task->GetRunNum() < 5; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_EQ(RC_SUCCESS, tp.CancelTimer(timer_id));
+    // a run may be in progress
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    const size_t run_num = task->GetRunNum();
+    ASSERT_GE(run_num, 5u);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ASSERT_EQ(run_num, task->GetRunNum());
+}
+
+TEST(ThreadPoolTest, stats) {
+    const uint32_t task_num = 100;
+    const ThreadPool::SchedPolicy policies[] = {ThreadPool::SCHED_SHARED_QUEUE, ThreadPool::SCHED_LOCK_FREE_QUEUE,
+                                                ThreadPool::SCHED_WORK_STEALING};
+    for (auto policy : policies) {
+        ThreadPool tp;
+        ASSERT_EQ(RC_SUCCESS, tp.Init(2, policy));
+
+        std::vector<ThreadPoolThreadStats> stats_list;
+#ifndef PPLCOMMON_ENABLE_THREADPOOL_STATS
+        ASSERT_EQ(RC_UNSUPPORTED, tp.GetStats(&stats_list));
+        return;
+#endif
+
+        std::atomic<uint32_t> counter(0);
+        for (uint32_t i = 0; i < task_num; ++i) {
+            ASSERT_EQ(RC_SUCCESS, tp.AddTask(make_shared<CountingThreadTask>(&tp, &counter, 0)));
+        }
+
+        // stats of a task are recorded after it returns
+        uint64_t total_task_num = 0;
+        for (uint32_t i = 0; i < 1000 && total_task_num < task_num; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            ASSERT_EQ(RC_SUCCESS, tp.GetStats(&stats_list));
+            ASSERT_EQ(2u, stats_list.size());
+            total_task_num = stats_list[0].task_num + stats_list[1].task_num;
+        }
+        ASSERT_EQ(task_num, total_task_num);
+
+        uint64_t total_wait_num = 0;
+        for (auto s = stats_list.begin(); s != stats_list.end(); ++s) {
+            total_wait_num += s->wait_ns.count;
+            EXPECT_EQ(s->task_num, s->run_ns.count);
+            EXPECT_EQ(s->task_num, s->queue_depth.count);
+        }
+        EXPECT_EQ(task_num, total_wait_num);
+    }
+}
+
+TEST(StaticThreadPoolTest, run_async) {
+    const uint32_t thread_num = 4;
+    const uint32_t job_num = 100;
+    StaticThreadPool tp;
+    ASSERT_EQ(RC_SUCCESS, tp.Init(thread_num));
+
+    // each thread sees its own parts of jobs in order
+    std::vector<std::vector<uint32_t>> seen(thread_num);
+    std::vector<uint64_t> ids;
+    for (uint32_t i = 0; i < job_num; ++i) {
+        ids.push_back(tp.RunAsync([i, &seen](uint32_t, uint32_t thread_idx) {
+            seen[thread_idx].push_back(i);
+        }));
+    }
+    for (uint32_t i = 1; i < ids.size(); ++i) {
+        ASSERT_EQ(ids[i - 1] + 1, ids[i]);
+    }
+    tp.Wait();
+    for (uint32_t t = 0; t < thread_num; ++t) {
+        ASSERT_EQ(job_num, seen[t].size());
+        for (uint32_t i = 0; i < job_num; ++i) {
+            ASSERT_EQ(i, seen[t][i]);
+        }
+    }
+}
+
+TEST(StaticThreadPoolTest, run_async_after_previous) {
+    const uint32_t thread_num = 4;
+    const uint32_t job_num = 50;
+    StaticThreadPool tp;
+    ASSERT_EQ(RC_SUCCESS, tp.Init(thread_num));
+
+    // job i reads what all threads wrote in job i - 1
+    std::vector<std::atomic<uint32_t>> values(thread_num);
+    for (uint32_t t = 0; t < thread_num; ++t) {
+        values[t].store(0);
+    }
+    std::atomic<bool> ok(true);
+    uint64_t last_id = 0;
+    for (uint32_t i = 0; i < job_num; ++i) {
+        last_id = tp.RunAsync(
+            [i, &values, &ok](uint32_t nr_threads, uint32_t thread_idx) {
+                for (uint32_t t = 0; t < nr_threads; ++t) {
+                    if (values[t].load() < i) {
+                        ok.store(false);
+                    }
+                }
+                if (thread_idx == 0) {
+                    std::this_thread::yield();
+                }
+                values[thread_idx].store(i + 1);
+            },
+            true);
+    }
+    tp.Wait(last_id);
+    ASSERT_TRUE(ok.load());
+    for (uint32_t t = 0; t < thread_num; ++t) {
+        ASSERT_EQ(job_num, values[t].load());
+    }
+}
+
+TEST(StaticThreadPoolTest, wait_job) {
+    StaticThreadPool tp;
+    ASSERT_EQ(RC_SUCCESS, tp.Init(2));
+
+    std::atomic<uint32_t> first(0), second(0);
+    const uint64_t id1 = tp.RunAsync([&first](uint32_t, uint32_t) {
+        first.fetch_add(1);
+    });
+    const uint64_t id2 = tp.RunAsync([&second](uint32_t, uint32_t) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        second.fetch_add(1);
+    });
+    tp.Wait(id1);
+    ASSERT_EQ(2u, first.load());
+    tp.Wait(id2);
+    ASSERT_EQ(2u, second.load());
+}
+
+TEST(StaticThreadPoolTest, split) {
+    const uint32_t thread_num = 4;
+    StaticThreadPool tp;
+    ASSERT_EQ(RC_SUCCESS, tp.Init(thread_num));
+
+    std::vector<StaticThreadPool::Team*> teams;
+    ASSERT_EQ(RC_INVALID_VALUE, tp.Split({1, 2}, &teams));
+    ASSERT_EQ(RC_INVALID_VALUE, tp.Split({4, 0}, &teams));
+    ASSERT_EQ(RC_SUCCESS, tp.Split({1, 3}, &teams));
+    ASSERT_TRUE(tp.IsSplit());
+    ASSERT_EQ(2u, teams.size());
+    ASSERT_EQ(1u, teams[0]->GetNumThreads());
+    ASSERT_EQ(3u, teams[1]->GetNumThreads());
+
+    // teams are disjoint and cover all threads
+    std::vector<uint32_t> owners(thread_num, 0);
+    for (auto t = teams.begin(); t != teams.end(); ++t) {
+        for (auto idx : (*t)->GetThreadIndices()) {
+            ++owners[idx];
+        }
+    }
+    for (uint32_t i = 0; i < thread_num; ++i) {
+        ASSERT_EQ(1u, owners[i]);
+    }
+
+    // teams run jobs concurrently from different threads
+    std::atomic<uint32_t> counters[2];
+    std::vector<std::thread> callers;
+    for (uint32_t i = 0; i < 2; ++i) {
+        counters[i].store(0);
+        callers.emplace_back([&teams, &counters, i]() {
+            auto team = teams[i];
+            for (uint32_t j = 0; j < 100; ++j) {
+                team->Run([team, &counters, i](uint32_t nr_threads, uint32_t thread_idx) {
+                    EXPECT_EQ(team->GetNumThreads(), nr_threads);
+                    EXPECT_LT(thread_idx, nr_threads);
+                    counters[i].fetch_add(1);
+                });
+            }
+            std::atomic<int64_t> sum(0);
+            team->ParallelFor(0, 1000, 10, [&sum](int64_t b, int64_t e) {
+                for (int64_t k = b; k < e; ++k) {
+                    sum.fetch_add(k);
+                }
+            });
+            EXPECT_EQ(999 * 1000 / 2, sum.load());
+        });
+    }
+    for (auto t = callers.begin(); t != callers.end(); ++t) {
+        t->join();
+    }
+    ASSERT_EQ(100u * 1, counters[0].load());
+    ASSERT_EQ(100u * 3, counters[1].load());
+
+    // splits again without merging
+    ASSERT_EQ(RC_SUCCESS, tp.Split({2, 2}, &teams));
+    ASSERT_EQ(2u, teams[0]->GetNumThreads());
+
+    ASSERT_EQ(RC_SUCCESS, tp.Merge());
+    ASSERT_FALSE(tp.IsSplit());
+    std::atomic<uint32_t> counter(0);
+    tp.Run([&counter, thread_num](uint32_t nr_threads, uint32_t) {
+        EXPECT_EQ(thread_num, nr_threads);
+        counter.fetch_add(1);
+    });
+    ASSERT_EQ(thread_num, counter.load());
+}
+
+TEST(StaticThreadPoolTest, split_placement) {
+    const uint32_t thread_num = 3;
+    StaticThreadPool tp;
+    ASSERT_EQ(RC_SUCCESS, tp.Init(thread_num));
+
+    // pinned threads come before threads which are not pinned
+    const uint32_t core = 0;
+    auto rc = tp.SetAffinity(2, &core, 1);
+    if (rc == RC_UNSUPPORTED) {
+        return;
+    }
+    ASSERT_EQ(RC_SUCCESS, rc);
+
+    std::vector<StaticThreadPool::Team*> teams;
+    ASSERT_EQ(RC_SUCCESS, tp.Split({1, 2}, &teams));
+    ASSERT_EQ(std::vector<uint32_t>({2}), teams[0]->GetThreadIndices());
+    ASSERT_EQ(std::vector<uint32_t>({0, 1}), teams[1]->GetThreadIndices());
+
+    // `SetAffinity()` works in split pools
+    ASSERT_EQ(RC_SUCCESS, tp.SetAffinity(1, &core, 1));
+}
+
+TEST(StaticThreadPoolTest, stats) {
+    const uint32_t run_num = 10;
+    StaticThreadPool tp;
+    ASSERT_EQ(RC_SUCCESS, tp.Init(2));
+    for (uint32_t i = 0; i < run_num; ++i) {
+        tp.Run([](uint32_t, uint32_t) {});
+    }
+
+    std::vector<StaticThreadPoolThreadStats> stats_list;
+#ifndef PPLCOMMON_ENABLE_THREADPOOL_STATS
+    ASSERT_EQ(RC_UNSUPPORTED, tp.GetStats(&stats_list));
+    return;
+#endif
+
+    // stats of a job are recorded before it completes
+    ASSERT_EQ(RC_SUCCESS, tp.GetStats(&stats_list));
+    ASSERT_EQ(2u, stats_list.size());
+    for (auto s = stats_list.begin(); s != stats_list.end(); ++s) {
+        EXPECT_EQ(run_num, s->run_num);
+        EXPECT_EQ(run_num, s->run_ns.count);
+        EXPECT_EQ(run_num, s->idle_ns.count);
+    }
+}
@@ -0,0 +1,190 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "ppl/common/timer_wheel.h"
+#include <cstring>
+using namespace std;
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace ppl { namespace common {
+
+static inline uint32_t CountTrailingZeros(uint64_t value) {
+#ifdef _MSC_VER
+    unsigned long idx;
+    _BitScanForward64(&idx, value);
+    return idx;
+#else
+    return __builtin_ctzll(value);
+#endif
+}
+
+TimerWheel::TimerWheel(uint64_t start_tick) : now_(start_tick), size_(0) {
+    memset(bitmaps_, 0, sizeof(bitmaps_));
+    memset(slots_, 0, sizeof(slots_));
+}
+
+void TimerWheel::Link(Timer* timer, uint32_t level, uint32_t idx) {
+    auto head = slots_[level][idx];
+    timer->prev = nullptr;
+    timer->next = head;
+    if (head) {
+        head->prev = timer;
+    }
+    slots_[level][idx] = timer;
+    bitmaps_[level] |= ((uint64_t)1 << idx);
+    timer->slot = level * SLOT_NUM + idx;
+    ++size_;
+}
+
+void TimerWheel::Add(Timer* timer, uint64_t expire_tick) {
+    if (expire_tick <= now_) {
+        expire_tick = now_ + 1;
+    }
+    timer->expire_tick = expire_tick;
+
+    // a timer of level l expires in [SLOT_NUM^l, SLOT_NUM^(l+1)) ticks, and is put in the slot of its expiration,
+    // which is reached before the wheel of that level wraps around.
+    uint64_t delta = expire_tick - now_;
+    uint32_t level = 0;
+    while (level < LEVEL_NUM - 1 && delta >= ((uint64_t)1 << (SLOT_BITS * (level + 1)))) {
+        ++level;
+    }
+    const uint64_t max_delta = ((uint64_t)1 << (SLOT_BITS * LEVEL_NUM)) - 1;
+    if (delta > max_delta) {
+        // out of range. it will be added again when the wheel reaches the last slot it can reach.
+        expire_tick = now_ + max_delta;
+    }
+    Link(timer, level, (expire_tick >> (SLOT_BITS * level)) & (SLOT_NUM - 1));
+}
+
+void TimerWheel::Remove(Timer* timer) {
+    if (!timer->IsPending()) {
+        return;
+    }
+
+    const uint32_t level = timer->slot / SLOT_NUM;
+    const uint32_t idx = timer->slot % SLOT_NUM;
+    if (timer->prev) {
+        timer->prev->next = timer->next;
+    } else {
+        slots_[level][idx] = timer->next;
+        if (!timer->next) {
+            bitmaps_[level] &= ~((uint64_t)1 << idx);
+        }
+    }
+    if (timer->next) {
+        timer->next->prev = timer->prev;
+    }
+    timer->prev = nullptr;
+    timer->next = nullptr;
+    timer->slot = INVALID_SLOT;
+    --size_;
+}
+
+void TimerWheel::Cascade(uint32_t level, uint32_t idx) {
+    auto timer = slots_[level][idx];
+    slots_[level][idx] = nullptr;
+    bitmaps_[level] &= ~((uint64_t)1 << idx);
+    while (timer) {
+        auto next = timer->next;
+        --size_;
+        if (timer->expire_tick <= now_) {
+            // due in this tick. `Add()` would postpone it to the next tick, so it is put in the current slot of
+            // level 0, which is expired after cascading.
+            Link(timer, 0, now_ & (SLOT_NUM - 1));
+        } else {
+            Add(timer, timer->expire_tick);
+        }
+        timer = next;
+    }
+}
+
+void TimerWheel::Expire(uint32_t idx, vector<Timer*>* expired) {
+    auto timer = slots_[0][idx];
+    slots_[0][idx] = nullptr;
+    bitmaps_[0] &= ~((uint64_t)1 << idx);
+    while (timer) {
+        auto next = timer->next;
+        timer->prev = nullptr;
+        timer->next = nullptr;
+        timer->slot = INVALID_SLOT;
+        --size_;
+        expired->push_back(timer);
+        timer = next;
+    }
+}
+
+void TimerWheel::Advance(uint64_t tick, vector<Timer*>* expired) {
+    while (true) {
+        const uint64_t next = GetNextEventTick();
+        if (next > tick) {
+            if (tick > now_) {
+                now_ = tick;
+            }
+            return;
+        }
+
+        now_ = next;
+        // higher levels first, so that timers can be moved down level by level in the same tick
+        for (uint32_t level = LEVEL_NUM - 1; level > 0; --level) {
+            const uint32_t shift = SLOT_BITS * level;
+            if ((now_ & (((uint64_t)1 << shift) - 1)) == 0) {
+                const uint32_t idx = (now_ >> shift) & (SLOT_NUM - 1);
+                if (bitmaps_[level] & ((uint64_t)1 << idx)) {
+                    Cascade(level, idx);
+                }
+            }
+        }
+        const uint32_t idx = now_ & (SLOT_NUM - 1);
+        if (bitmaps_[0] & ((uint64_t)1 << idx)) {
+            Expire(idx, expired);
+        }
+    }
+}
+
+uint64_t TimerWheel::GetNextEventTick() const {
+    uint64_t res = UINT64_MAX;
+    if (size_ == 0) {
+        return res;
+    }
+
+    for (uint32_t level = 0; level < LEVEL_NUM; ++level) {
+        const uint64_t bitmap = bitmaps_[level];
+        if (!bitmap) {
+            continue;
+        }
+
+        // the first non-empty slot after the current one. the current slot itself comes last as it is reached
+        // again after a whole round.
+        const uint32_t shift = SLOT_BITS * level;
+        const uint32_t first = ((now_ >> shift) + 1) & (SLOT_NUM - 1);
+        const uint64_t rotated = (first == 0) ? bitmap : ((bitmap >> first) | (bitmap << (SLOT_NUM - first)));
+        const uint64_t distance = CountTrailingZeros(rotated) + 1;
+        const uint64_t tick = ((now_ >> shift) + distance) << shift;
+        if (tick < res) {
+            res = tick;
+        }
+    }
+
+    return res;
+}
+
+}} // namespace ppl::common
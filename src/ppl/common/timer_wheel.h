@@ -0,0 +1,108 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#ifndef _ST_HPC_PPL_COMMON_TIMER_WHEEL_H_
+#define _ST_HPC_PPL_COMMON_TIMER_WHEEL_H_
+
+#include <stdint.h>
+#include <cstddef>
+#include <vector>
+
+namespace ppl { namespace common {
+
+/**
+   a hierarchical timing wheel of intrusive timers with O(1) `Add()` and `Remove()`. time is measured in
+   abstract ticks. each level has `SLOT_NUM` slots, and a slot of level `l` covers `SLOT_NUM^l` ticks. timers are
+   moved to lower levels when the wheel reaches their slots, so each timer is touched at most `LEVEL_NUM` times.
+   occupancy bitmaps let `Advance()` jump over empty slots. NOT thread-safe.
+   based on
+     - G. Varghese and T. Lauck, Hashed and Hierarchical Timing Wheels, SOSP 1987
+*/
+
+class TimerWheel final {
+public:
+    struct Timer {
+        Timer() : prev(nullptr), next(nullptr), expire_tick(0), slot(INVALID_SLOT) {}
+
+        bool IsPending() const {
+            return (slot != INVALID_SLOT);
+        }
+
+        Timer* prev;
+        Timer* next;
+        uint64_t expire_tick;
+        uint32_t slot; // level * SLOT_NUM + index, or INVALID_SLOT
+    };
+
+public:
+    static constexpr uint32_t SLOT_BITS = 6;
+    static constexpr uint32_t SLOT_NUM = 1u << SLOT_BITS;
+    static constexpr uint32_t LEVEL_NUM = 5;
+    static constexpr uint32_t INVALID_SLOT = UINT32_MAX;
+
+public:
+    TimerWheel(uint64_t start_tick = 0);
+
+    /**
+       @brief schedules `timer` which MUST NOT be pending. timers which expire at or before the current tick expire
+       in the next tick. timers beyond the range of the wheel are kept in the last level until they get in range.
+    */
+    void Add(Timer* timer, uint64_t expire_tick);
+    /** does nothing if `timer` is not pending */
+    void Remove(Timer* timer);
+
+    /**
+       @brief moves the wheel to `tick` and appends expired timers, which are no longer pending, to `expired`.
+       a timer may be added or removed again by callers after it is returned.
+    */
+    void Advance(uint64_t tick, std::vector<Timer*>* expired);
+
+    /**
+       returns a tick no later than the earliest expiration, at which `Advance()` has something to do,
+       or UINT64_MAX if there are no pending timers.
+    */
+    uint64_t GetNextEventTick() const;
+
+    uint64_t GetCurrentTick() const {
+        return now_;
+    }
+    size_t GetSize() const {
+        return size_;
+    }
+
+private:
+    void Link(Timer*, uint32_t level, uint32_t idx);
+    void Cascade(uint32_t level, uint32_t idx);
+    void Expire(uint32_t idx, std::vector<Timer*>* expired);
+
+private:
+    uint64_t now_;
+    size_t size_;
+    uint64_t bitmaps_[LEVEL_NUM];
+    Timer* slots_[LEVEL_NUM][SLOT_NUM];
+
+private:
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel(TimerWheel&&) = delete;
+    void operator=(const TimerWheel&) = delete;
+    void operator=(TimerWheel&&) = delete;
+};
+
+}} // namespace ppl::common
+
+#endif
@@ -0,0 +1,102 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "ppl/common/timer_wheel.h"
+#include <benchmark/benchmark.h>
+#include <functional>
+#include <queue>
+#include <random>
+#include <utility>
+#include <vector>
+using namespace std;
+using namespace ppl::common;
+
+/*
+  a typical timeout workload: `timer_num` timers with random delays in [1, 2^20) ticks are pending, and each
+  iteration adds a timer, cancels the oldest one, and moves time forward by one tick. most timers are cancelled
+  before they expire, as timeouts of requests usually are.
+*/
+
+static vector<uint64_t> GenerateDelays(uint32_t n) {
+    mt19937_64 rng(12345);
+    vector<uint64_t> delays(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        delays[i] = 1 + rng() % (1 << 20);
+    }
+    return delays;
+}
+
+static void BM_TimerWheel(benchmark::State& state) {
+    const uint32_t timer_num = state.range(0);
+    const auto delays = GenerateDelays(timer_num);
+
+    TimerWheel wheel;
+    vector<TimerWheel::Timer> timers(timer_num);
+    for (uint32_t i = 0; i < timer_num; ++i) {
+        wheel.Add(&timers[i], delays[i]);
+    }
+
+    vector<TimerWheel::Timer*> expired;
+    uint64_t tick = 0;
+    uint32_t idx = 0;
+    for (auto _ : state) {
+        auto timer = &timers[idx];
+        wheel.Remove(timer);
+        wheel.Add(timer, tick + delays[idx]);
+        ++tick;
+        wheel.Advance(tick, &expired);
+        expired.clear();
+        idx = (idx + 1 == timer_num) ? 0 : idx + 1;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+/** the baseline: a binary heap where cancelled timers are dropped lazily when they reach the top */
+static void BM_PriorityQueue(benchmark::State& state) {
+    const uint32_t timer_num = state.range(0);
+    const auto delays = GenerateDelays(timer_num);
+
+    typedef pair<uint64_t, uint32_t> Item; // (expire_tick, timer idx)
+    priority_queue<Item, vector<Item>, greater<Item>> heap;
+    vector<uint64_t> expire_ticks(timer_num); // 0 if cancelled
+    for (uint32_t i = 0; i < timer_num; ++i) {
+        expire_ticks[i] = delays[i];
+        heap.push(Item(delays[i], i));
+    }
+
+    uint64_t tick = 0;
+    uint32_t idx = 0;
+    for (auto _ : state) {
+        expire_ticks[idx] = tick + delays[idx];
+        heap.push(Item(expire_ticks[idx], idx));
+        ++tick;
+        while (!heap.empty() && heap.top().first <= tick) {
+            const auto item = heap.top();
+            heap.pop();
+            if (expire_ticks[item.second] == item.first) {
+                expire_ticks[item.second] = 0;
+            }
+        }
+        idx = (idx + 1 == timer_num) ? 0 : idx + 1;
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["heap_size"] = heap.size();
+}
+
+BENCHMARK(BM_TimerWheel)->RangeMultiplier(8)->Range(1 << 10, 1 << 19);
+BENCHMARK(BM_PriorityQueue)->RangeMultiplier(8)->Range(1 << 10, 1 << 19);
@@ -0,0 +1,166 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "ppl/common/timer_wheel.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+using namespace std;
+using namespace ppl::common;
+
+TEST(TimerWheelTest, expire) {
+    TimerWheel wheel;
+    TimerWheel::Timer timers[4];
+    wheel.Add(&timers[0], 1);
+    wheel.Add(&timers[1], 63);
+    wheel.Add(&timers[2], 64);
+    wheel.Add(&timers[3], 5000);
+    ASSERT_EQ(4, wheel.GetSize());
+    ASSERT_EQ(1, wheel.GetNextEventTick());
+
+    vector<TimerWheel::Timer*> expired;
+    wheel.Advance(63, &expired);
+    ASSERT_EQ(2, expired.size());
+    ASSERT_FALSE(timers[0].IsPending());
+    ASSERT_FALSE(timers[1].IsPending());
+    ASSERT_TRUE(timers[2].IsPending());
+
+    expired.clear();
+    wheel.Advance(4999, &expired);
+    ASSERT_EQ(1, expired.size());
+    ASSERT_EQ(&timers[2], expired[0]);
+
+    expired.clear();
+    wheel.Advance(5000, &expired);
+    ASSERT_EQ(1, expired.size());
+    ASSERT_EQ(&timers[3], expired[0]);
+    ASSERT_EQ(0, wheel.GetSize());
+    ASSERT_EQ(UINT64_MAX, wheel.GetNextEventTick());
+}
+
+TEST(TimerWheelTest, past) {
+    TimerWheel wheel(100);
+    TimerWheel::Timer timer;
+    wheel.Add(&timer, 10);
+    ASSERT_EQ(101, timer.expire_tick);
+
+    vector<TimerWheel::Timer*> expired;
+    wheel.Advance(100, &expired);
+    ASSERT_TRUE(expired.empty());
+    wheel.Advance(101, &expired);
+    ASSERT_EQ(1, expired.size());
+}
+
+TEST(TimerWheelTest, out_of_range) {
+    TimerWheel wheel;
+    TimerWheel::Timer timer;
+    const uint64_t expire_tick = ((uint64_t)1 << (TimerWheel::SLOT_BITS * TimerWheel::LEVEL_NUM)) * 3 + 7;
+    wheel.Add(&timer, expire_tick);
+
+    vector<TimerWheel::Timer*> expired;
+    wheel.Advance(expire_tick - 1, &expired);
+    ASSERT_TRUE(expired.empty());
+    ASSERT_TRUE(timer.IsPending());
+    wheel.Advance(expire_tick, &expired);
+    ASSERT_EQ(1, expired.size());
+}
+
+TEST(TimerWheelTest, random) {
+    const uint32_t timer_num = 20000;
+    mt19937_64 rng(12345);
+    TimerWheel wheel;
+    vector<TimerWheel::Timer> timers(timer_num);
+    vector<uint64_t> expire_ticks(timer_num);
+    vector<bool> removed(timer_num, false);
+
+    for (uint32_t i = 0; i < timer_num; ++i) {
+        // mixes all levels
+        const uint32_t bits = rng() % 26;
+        expire_ticks[i] = 1 + rng() % ((uint64_t)1 << bits);
+        wheel.Add(&timers[i], expire_ticks[i]);
+    }
+    for (uint32_t i = 0; i < timer_num; i += 3) {
+        wheel.Remove(&timers[i]);
+        removed[i] = true;
+    }
+
+    vector<TimerWheel::Timer*> expired;
+    uint64_t tick = 0;
+    uint32_t expired_num = 0;
+    while (wheel.GetSize() > 0) {
+        tick += 1 + rng() % 100000;
+        expired.clear();
+        wheel.Advance(tick, &expired);
+        for (auto x = expired.begin(); x != expired.end(); ++x) {
+            const uint32_t idx = *x - timers.data();
+            ASSERT_FALSE(removed[idx]);
+            // never early, and late by less than one step
+            ASSERT_LE(expire_ticks[idx], tick);
+            ASSERT_GT(expire_ticks[idx] + 100001, tick);
+            removed[idx] = true;
+            ++expired_num;
+        }
+    }
+    ASSERT_EQ(timer_num - (timer_num + 2) / 3, expired_num);
+}
+
+TEST(TimerWheelTest, exact) {
+    const uint32_t timer_num = 5000;
+    mt19937_64 rng(54321);
+    TimerWheel wheel;
+    vector<TimerWheel::Timer> timers(timer_num);
+    for (uint32_t i = 0; i < timer_num; ++i) {
+        wheel.Add(&timers[i], 1 + rng() % 300000);
+    }
+
+    // jumping to the next event tick every time expires each timer exactly on time
+    vector<TimerWheel::Timer*> expired;
+    uint32_t expired_num = 0;
+    while (wheel.GetSize() > 0) {
+        const uint64_t tick = wheel.GetNextEventTick();
+        expired.clear();
+        wheel.Advance(tick, &expired);
+        for (auto x = expired.begin(); x != expired.end(); ++x) {
+            ASSERT_EQ(tick, (*x)->expire_tick);
+        }
+        expired_num += expired.size();
+    }
+    ASSERT_EQ(timer_num, expired_num);
+}
+
+TEST(TimerWheelTest, boundary) {
+    // timers due at the first tick of a slot of a higher level are cascaded in the tick they expire
+    const uint64_t boundaries[] = {64, 128, 4096, 64 * 4096};
+    for (auto start : {(uint64_t)0, (uint64_t)64}) {
+        for (auto b : boundaries) {
+            TimerWheel wheel(start);
+            TimerWheel::Timer timer;
+            const uint64_t expire_tick = start + b;
+            wheel.Add(&timer, expire_tick);
+
+            vector<TimerWheel::Timer*> expired;
+            wheel.Advance(expire_tick - 1, &expired);
+            ASSERT_TRUE(expired.empty());
+            wheel.Advance(expire_tick, &expired);
+            ASSERT_EQ(1, expired.size());
+            ASSERT_EQ(expire_tick, timer.expire_tick);
+            ASSERT_EQ(0, wheel.GetSize());
+        }
+    }
+}
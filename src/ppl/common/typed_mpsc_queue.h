@@ -19,8 +19,18 @@
 #define _ST_HPC_PPL_COMMON_TYPED_MPSC_QUEUE_H_
 
 #include "mpsc_queue.h"
+#include "mpmc_ring_buffer.h"
+#include "event_count.h"
+#include "retcode.h"
+#include <stdint.h>
 #include <atomic>
+#include <chrono>
+#include <memory>
 #include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace ppl { namespace common {
 
@@ -29,7 +39,19 @@ namespace ppl { namespace common {
 template <typename T>
 class TypedMPSCQueue final {
 public:
-    TypedMPSCQueue() : size_(0) {}
+    /**
+       @param node_cache_size max number of consumed nodes kept for later `Push()`, so that nodes are not allocated
+       and freed for each item when producers contend for the allocator. 0 disables the cache.
+    */
+    TypedMPSCQueue(uint32_t node_cache_size = 0) : size_(0) {
+        if (node_cache_size > 0) {
+            // the cache is only an optimization. the queue works without it if it cannot be allocated.
+            node_cache_.reset(new (std::nothrow) MPMCRingBuffer<void*>());
+            if (node_cache_ && node_cache_->Init(node_cache_size) != ppl::common::RC_SUCCESS) {
+                node_cache_.reset();
+            }
+        }
+    }
 
     ~TypedMPSCQueue() {
         bool is_empty;
@@ -38,19 +60,29 @@ public:
         while (true) {
             node = queue_.Pop(&is_empty);
             if (!node) {
-                return;
+                break;
+            }
+            auto item = static_cast<Item*>(node);
+            item->~Item();
+            ::operator delete(item);
+        }
+
+        if (node_cache_) {
+            void* p;
+            while (node_cache_->Pop(&p)) {
+                ::operator delete(p);
             }
-            delete static_cast<Item*>(node);
         }
     }
 
     template <typename ValueType>
     ppl::common::RetCode Push(ValueType&& value) {
-        auto item = new (std::nothrow) Item(std::forward<T>(value));
-        if (!item) {
+        auto p = AllocNode();
+        if (!p) {
             return ppl::common::RC_OUT_OF_MEMORY;
         }
 
+        auto item = new (p) Item(std::forward<ValueType>(value));
         queue_.Push(item);
         size_.fetch_add(1, std::memory_order_relaxed);
 
@@ -73,11 +105,50 @@ public:
 
         auto item = static_cast<Item*>(node);
         *res = std::move(item->value);
-        delete item;
+        item->~Item();
+        FreeNode(item);
+
+        return true;
+    }
+
+    /** like `Pop()`, but returns false instead of waiting if an item is being inserted */
+    template <typename ValueType>
+    bool TryPop(ValueType* res) {
+        bool is_empty;
+        auto node = queue_.Pop(&is_empty);
+        if (!node) {
+            return false;
+        }
+
+        size_.fetch_sub(1, std::memory_order_relaxed);
+
+        auto item = static_cast<Item*>(node);
+        *res = std::move(item->value);
+        item->~Item();
+        FreeNode(item);
 
         return true;
     }
 
+    /** appends all items that are ready to `values` and returns the number of them */
+    uint32_t PopAll(std::vector<T>* values) {
+        uint32_t n = 0;
+        bool is_empty;
+        MPSCQueue::Node* node;
+        while ((node = queue_.Pop(&is_empty))) {
+            auto item = static_cast<Item*>(node);
+            values->push_back(std::move(item->value));
+            item->~Item();
+            FreeNode(item);
+            ++n;
+        }
+
+        if (n > 0) {
+            size_.fetch_sub(n, std::memory_order_relaxed);
+        }
+        return n;
+    }
+
     // approximate size
     uint32_t Size() const {
         return size_.load(std::memory_order_relaxed);
@@ -85,13 +156,30 @@ public:
 
 private:
     struct Item final : public MPSCQueue::Node {
-        Item(T&& v) : value(std::forward<T>(v)) {}
+        template <typename ValueType>
+        Item(ValueType&& v) : value(std::forward<ValueType>(v)) {}
         T value;
     };
 
+    void* AllocNode() {
+        void* p;
+        if (node_cache_ && node_cache_->Pop(&p)) {
+            return p;
+        }
+        return ::operator new(sizeof(Item), std::nothrow);
+    }
+
+    void FreeNode(void* p) {
+        if (!node_cache_ || !node_cache_->Push(p)) {
+            ::operator delete(p);
+        }
+    }
+
 private:
     MPSCQueue queue_;
     std::atomic<uint32_t> size_;
+    /** raw memory of consumed nodes. freed by the consumer and reused by producers. */
+    std::unique_ptr<MPMCRingBuffer<void*>> node_cache_;
 
 private:
     TypedMPSCQueue(const TypedMPSCQueue&) = delete;
@@ -100,6 +188,155 @@ private:
     void operator=(TypedMPSCQueue&&) = delete;
 };
 
+/**
+   a wrapper of `TypedMPSCQueue` in which `Pop()` spins for a while and then sleeps until an item arrives.
+   producers wake up the consumer only if it is sleeping.
+*/
+
+template <typename T>
+class BlockingMPSCQueue final {
+public:
+    /** @see `TypedMPSCQueue::TypedMPSCQueue()` */
+    BlockingMPSCQueue(uint32_t node_cache_size = 0) : queue_(node_cache_size) {}
+
+    template <typename ValueType>
+    ppl::common::RetCode Push(ValueType&& value) {
+        auto rc = queue_.Push(std::forward<ValueType>(value));
+        if (rc == ppl::common::RC_SUCCESS) {
+            not_empty_.NotifyOneIfWaiting();
+        }
+        return rc;
+    }
+
+    /** MUST be called by the consumer. returns false if no item is ready. */
+    template <typename ValueType>
+    bool TryPop(ValueType* res) {
+        return queue_.TryPop(res);
+    }
+
+    /** MUST be called by the consumer. blocks until an item is popped. */
+    template <typename ValueType>
+    void Pop(ValueType* res) {
+        if (!SpinFor([this, res]() -> bool {
+                return queue_.TryPop(res);
+            })) {
+            not_empty_.Wait([this, res]() -> bool {
+                return queue_.TryPop(res);
+            });
+        }
+    }
+
+    /** MUST be called by the consumer. returns false if no item is popped within `timeout_us`. */
+    template <typename ValueType>
+    bool Pop(ValueType* res, uint64_t timeout_us) {
+        if (SpinFor([this, res]() -> bool {
+                return queue_.TryPop(res);
+            })) {
+            return true;
+        }
+
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(timeout_us);
+        while (true) {
+            auto key = not_empty_.PrepareWait();
+            if (queue_.TryPop(res)) {
+                not_empty_.CancelWait();
+                return true;
+            }
+            const auto now = std::chrono::steady_clock::now();
+            if (now >= deadline) {
+                not_empty_.CancelWait();
+                return false;
+            }
+            not_empty_.CommitWait(
+                key, std::chrono::duration_cast<std::chrono::microseconds>(deadline - now).count() + 1);
+        }
+    }
+
+    /** MUST be called by the consumer. @see `TypedMPSCQueue::PopAll()` */
+    uint32_t PopAll(std::vector<T>* values) {
+        return queue_.PopAll(values);
+    }
+
+    // approximate size
+    uint32_t Size() const {
+        return queue_.Size();
+    }
+
+private:
+    /** retries `f` for a while before falling back to futex waiting */
+    template <typename Func>
+    static bool SpinFor(Func&& f) {
+        for (uint32_t i = 0; i < SPIN_COUNT; ++i) {
+            if (f()) {
+                return true;
+            }
+            std::this_thread::yield();
+        }
+        return false;
+    }
+
+private:
+    static constexpr uint32_t SPIN_COUNT = 64;
+
+    TypedMPSCQueue<T> queue_;
+    EventCount not_empty_;
+
+private:
+    BlockingMPSCQueue(const BlockingMPSCQueue&) = delete;
+    BlockingMPSCQueue(BlockingMPSCQueue&&) = delete;
+    void operator=(const BlockingMPSCQueue&) = delete;
+    void operator=(BlockingMPSCQueue&&) = delete;
+};
+
+/**
+   a typed wrapper in which items embed `MPSCQueue::Node`, so nothing is allocated. callers own the items, and an
+   item MUST NOT be pushed again before it is popped.
+*/
+
+template <typename T>
+class IntrusiveMPSCQueue final {
+public:
+    static_assert(std::is_base_of<MPSCQueue::Node, T>::value, "T MUST derive from MPSCQueue::Node");
+
+public:
+    IntrusiveMPSCQueue() : size_(0) {}
+
+    void Push(T* item) {
+        queue_.Push(item);
+        size_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+       returns nullptr instead of waiting if the queue is empty or the next item is still being inserted, like
+       `TypedMPSCQueue::TryPop()`. MUST be called by the consumer.
+    */
+    T* Pop() {
+        bool is_empty;
+        auto node = queue_.Pop(&is_empty);
+        if (!node) {
+            return nullptr;
+        }
+
+        size_.fetch_sub(1, std::memory_order_relaxed);
+        return static_cast<T*>(node);
+    }
+
+    // approximate size
+    uint32_t Size() const {
+        return size_.load(std::memory_order_relaxed);
+    }
+
+private:
+    MPSCQueue queue_;
+    std::atomic<uint32_t> size_;
+
+private:
+    IntrusiveMPSCQueue(const IntrusiveMPSCQueue&) = delete;
+    IntrusiveMPSCQueue(IntrusiveMPSCQueue&&) = delete;
+    void operator=(const IntrusiveMPSCQueue&) = delete;
+    void operator=(IntrusiveMPSCQueue&&) = delete;
+};
+
 }}
 
 #endif
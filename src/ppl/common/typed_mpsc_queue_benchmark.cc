@@ -0,0 +1,91 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "ppl/common/typed_mpsc_queue.h"
+#include <benchmark/benchmark.h>
+#include <thread>
+#include <vector>
+using namespace std;
+using namespace ppl::common;
+
+static constexpr uint32_t ITEM_NUM = 1 << 18;
+
+/** `state.range(0)` producers push ITEM_NUM items in total while the current thread pops them */
+static void BM_TypedMPSCQueue(benchmark::State& state, uint32_t node_cache_size) {
+    const uint32_t nr_producers = state.range(0);
+    for (auto _ : state) {
+        TypedMPSCQueue<uint64_t> queue(node_cache_size);
+        vector<thread> producers;
+        for (uint32_t i = 0; i < nr_producers; ++i) {
+            producers.emplace_back([&queue, nr_producers]() {
+                for (uint32_t j = 0; j < ITEM_NUM / nr_producers; ++j) {
+                    queue.Push((uint64_t)j);
+                }
+            });
+        }
+        uint64_t value;
+        for (uint32_t i = 0; i < ITEM_NUM / nr_producers * nr_producers;) {
+            if (queue.Pop(&value)) {
+                benchmark::DoNotOptimize(value);
+                ++i;
+            }
+        }
+        for (auto t = producers.begin(); t != producers.end(); ++t) {
+            t->join();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * ITEM_NUM);
+}
+
+struct IntrusiveItem final : public MPSCQueue::Node {
+    uint64_t value;
+};
+
+static void BM_IntrusiveMPSCQueue(benchmark::State& state) {
+    const uint32_t nr_producers = state.range(0);
+    vector<IntrusiveItem> items(ITEM_NUM);
+    for (auto _ : state) {
+        IntrusiveMPSCQueue<IntrusiveItem> queue;
+        vector<thread> producers;
+        for (uint32_t i = 0; i < nr_producers; ++i) {
+            producers.emplace_back([&queue, &items, nr_producers, i]() {
+                const uint32_t n = ITEM_NUM / nr_producers;
+                for (uint32_t j = 0; j < n; ++j) {
+                    auto item = &items[i * n + j];
+                    item->value = j;
+                    queue.Push(item);
+                }
+            });
+        }
+        for (uint32_t i = 0; i < ITEM_NUM / nr_producers * nr_producers;) {
+            auto item = queue.Pop();
+            if (item) {
+                benchmark::DoNotOptimize(item->value);
+                ++i;
+            }
+        }
+        for (auto t = producers.begin(); t != producers.end(); ++t) {
+            t->join();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * ITEM_NUM);
+}
+
+BENCHMARK_CAPTURE(BM_TypedMPSCQueue, allocating, 0)->RangeMultiplier(2)->Range(1, 16)->UseRealTime();
+BENCHMARK_CAPTURE(BM_TypedMPSCQueue, node_cache, 1024)->RangeMultiplier(2)->Range(1, 16)->UseRealTime();
+BENCHMARK(BM_IntrusiveMPSCQueue)->RangeMultiplier(2)->Range(1, 16)->UseRealTime();
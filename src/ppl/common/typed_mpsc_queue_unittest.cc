@@ -0,0 +1,200 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "ppl/common/typed_mpsc_queue.h"
+#include "gtest/gtest.h"
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+using namespace ppl::common;
+
+static void ProduceConsume(TypedMPSCQueue<uint64_t>* queue) {
+    const uint32_t producer_num = 4;
+    const uint64_t n = 20000;
+    vector<thread> producers;
+    for (uint32_t p = 0; p < producer_num; ++p) {
+        producers.emplace_back([queue, p]() {
+            for (uint64_t i = 0; i < n; ++i) {
+                ASSERT_EQ(RC_SUCCESS, queue->Push((uint64_t)p * n + i));
+            }
+        });
+    }
+
+    // items of each producer arrive in order
+    vector<uint64_t> next(producer_num, 0);
+    for (uint64_t k = 0; k < producer_num * n;) {
+        uint64_t value;
+        if (!queue->Pop(&value)) {
+            this_thread::yield();
+            continue;
+        }
+        const uint64_t p = value / n;
+        ASSERT_LT(p, producer_num);
+        ASSERT_EQ(next[p], value % n);
+        ++next[p];
+        ++k;
+    }
+    for (auto t = producers.begin(); t != producers.end(); ++t) {
+        t->join();
+    }
+    ASSERT_EQ(0u, queue->Size());
+}
+
+TEST(TypedMPSCQueueTest, producers_consumer) {
+    TypedMPSCQueue<uint64_t> queue;
+    ProduceConsume(&queue);
+}
+
+TEST(TypedMPSCQueueTest, node_cache) {
+    TypedMPSCQueue<uint64_t> queue(64);
+    ProduceConsume(&queue);
+}
+
+TEST(TypedMPSCQueueTest, destructor) {
+    // remaining items and cached nodes are released
+    TypedMPSCQueue<shared_ptr<string>> queue(4);
+    auto value = make_shared<string>("hello");
+    for (int i = 0; i < 8; ++i) {
+        ASSERT_EQ(RC_SUCCESS, queue.Push(value));
+    }
+    ASSERT_EQ(9, value.use_count());
+
+    shared_ptr<string> res;
+    for (int i = 0; i < 6; ++i) {
+        ASSERT_TRUE(queue.Pop(&res));
+    }
+    res.reset();
+    ASSERT_EQ(3, value.use_count());
+    ASSERT_EQ(2u, queue.Size());
+
+    // lvalues are copied
+    string s("world");
+    TypedMPSCQueue<string> queue2;
+    ASSERT_EQ(RC_SUCCESS, queue2.Push(s));
+    ASSERT_EQ("world", s);
+}
+
+struct IntrusiveItem final : public MPSCQueue::Node {
+    uint32_t producer;
+    uint32_t seq;
+};
+
+TEST(IntrusiveMPSCQueueTest, producers_consumer) {
+    const uint32_t producer_num = 4;
+    const uint32_t n = 20000;
+    vector<IntrusiveItem> items(producer_num * n);
+    IntrusiveMPSCQueue<IntrusiveItem> queue;
+    ASSERT_EQ(nullptr, queue.Pop());
+
+    vector<thread> producers;
+    for (uint32_t p = 0; p < producer_num; ++p) {
+        producers.emplace_back([&queue, &items, p]() {
+            for (uint32_t i = 0; i < n; ++i) {
+                auto item = &items[p * n + i];
+                item->producer = p;
+                item->seq = i;
+                queue.Push(item);
+            }
+        });
+    }
+
+    vector<uint32_t> next(producer_num, 0);
+    for (uint32_t k = 0; k < producer_num * n;) {
+        auto item = queue.Pop();
+        if (!item) {
+            this_thread::yield();
+            continue;
+        }
+        ASSERT_EQ(&items[item->producer * n + item->seq], item);
+        ASSERT_EQ(next[item->producer], item->seq);
+        ++next[item->producer];
+        ++k;
+    }
+    for (auto t = producers.begin(); t != producers.end(); ++t) {
+        t->join();
+    }
+    ASSERT_EQ(nullptr, queue.Pop());
+}
+
+TEST(BlockingMPSCQueueTest, producers_consumer) {
+    const uint32_t producer_num = 4;
+    const uint32_t n = 10000;
+    BlockingMPSCQueue<uint32_t> queue(64);
+
+    vector<thread> producers;
+    for (uint32_t p = 0; p < producer_num; ++p) {
+        producers.emplace_back([&queue, p]() {
+            for (uint32_t i = 0; i < n; ++i) {
+                queue.Push(p * n + i);
+                if (i % 1000 == 0) {
+                    // lets the consumer fall asleep
+                    this_thread::sleep_for(chrono::microseconds(200));
+                }
+            }
+        });
+    }
+
+    vector<uint32_t> next(producer_num, 0);
+    vector<uint32_t> values;
+    for (uint32_t k = 0; k < producer_num * n;) {
+        values.clear();
+        if (k % 3 == 0) {
+            uint32_t value;
+            queue.Pop(&value);
+            values.push_back(value);
+        } else if (queue.PopAll(&values) == 0) {
+            continue;
+        }
+        for (auto v = values.begin(); v != values.end(); ++v) {
+            const uint32_t p = *v / n;
+            ASSERT_LT(p, producer_num);
+            ASSERT_EQ(next[p], *v % n);
+            ++next[p];
+            ++k;
+        }
+    }
+    for (auto t = producers.begin(); t != producers.end(); ++t) {
+        t->join();
+    }
+    ASSERT_EQ(0u, queue.Size());
+}
+
+TEST(BlockingMPSCQueueTest, timed_pop) {
+    BlockingMPSCQueue<string> queue;
+    string value;
+    ASSERT_FALSE(queue.TryPop(&value));
+
+    auto start = chrono::steady_clock::now();
+    ASSERT_FALSE(queue.Pop(&value, 20000));
+    ASSERT_GE(chrono::steady_clock::now() - start, chrono::microseconds(20000));
+
+    thread producer([&queue]() {
+        this_thread::sleep_for(chrono::milliseconds(10));
+        queue.Push(string("hello"));
+    });
+    ASSERT_TRUE(queue.Pop(&value, 10000000));
+    ASSERT_EQ("hello", value);
+    producer.join();
+
+    queue.Push(string("world"));
+    ASSERT_TRUE(queue.TryPop(&value));
+    ASSERT_EQ("world", value);
+}
@@ -0,0 +1,198 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef _ST_HPC_PPL_COMMON_WORK_STEALING_DEQUE_H_
+#define _ST_HPC_PPL_COMMON_WORK_STEALING_DEQUE_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+#include <new>
+
+namespace ppl { namespace common {
+
+/**
+   a lock-free work-stealing deque of pointers. the owner thread pushes and pops at the bottom
+   while other threads steal from the top.
+   based on
+     - D. Chase and Y. Lev, Dynamic Circular Work-Stealing Deque, SPAA 2005
+     - N. M. Le et al., Correct and Efficient Work-Stealing for Weak Memory Models, PPoPP 2013
+*/
+
+template <typename T>
+class WorkStealingDeque final {
+public:
+    /** `capacity` is rounded up to a power of 2 and grows on demand. */
+    WorkStealingDeque(uint32_t capacity = 256) : top_(0), bottom_(0), array_(nullptr) {
+        uint64_t cap = 1;
+        while (cap < capacity) {
+            cap <<= 1;
+        }
+        array_.store(Array::Create(cap), std::memory_order_relaxed);
+    }
+
+    ~WorkStealingDeque() {
+        Array::Destroy(array_.load(std::memory_order_relaxed));
+        for (auto x = retired_.begin(); x != retired_.end(); ++x) {
+            Array::Destroy(*x);
+        }
+    }
+
+    /** MUST be called by the owner thread. returns false if the deque is full and cannot grow. */
+    bool Push(T* item) {
+        const int64_t b = bottom_.load(std::memory_order_relaxed);
+        const int64_t t = top_.load(std::memory_order_acquire);
+        auto a = array_.load(std::memory_order_relaxed);
+        if (b - t > (int64_t)a->mask) {
+            a = Grow(a, t, b);
+            if (!a) {
+                return false;
+            }
+        }
+        a->Put(b, item);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /** MUST be called by the owner thread. returns the most recently pushed item, or nullptr if empty. */
+    T* Pop() {
+        const int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        auto a = array_.load(std::memory_order_relaxed);
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top_.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        T* item = a->Get(b);
+        if (t == b) {
+            // the last item. race with thieves.
+            if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                item = nullptr;
+            }
+            bottom_.store(b + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    /**
+       can be called by any thread. returns the least recently pushed item, or nullptr if the deque
+       is empty or this thread loses a race with another thief or the owner.
+    */
+    T* Steal() {
+        int64_t t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t b = bottom_.load(std::memory_order_acquire);
+        if (t >= b) {
+            return nullptr;
+        }
+
+        auto a = array_.load(std::memory_order_acquire);
+        T* item = a->Get(t);
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return item;
+    }
+
+    // approximate size
+    uint64_t Size() const {
+        const int64_t b = bottom_.load(std::memory_order_relaxed);
+        const int64_t t = top_.load(std::memory_order_relaxed);
+        return (b > t) ? (b - t) : 0;
+    }
+
+    bool IsEmpty() const {
+        return (Size() == 0);
+    }
+
+private:
+    struct Array final {
+        uint64_t mask;
+        std::atomic<T*>* items;
+
+        static Array* Create(uint64_t capacity) {
+            auto a = new (std::nothrow) Array();
+            if (!a) {
+                return nullptr;
+            }
+            a->items = new (std::nothrow) std::atomic<T*>[capacity];
+            if (!a->items) {
+                delete a;
+                return nullptr;
+            }
+            a->mask = capacity - 1;
+            return a;
+        }
+
+        static void Destroy(Array* a) {
+            delete[] a->items;
+            delete a;
+        }
+
+        T* Get(int64_t idx) const {
+            return items[idx & mask].load(std::memory_order_relaxed);
+        }
+
+        void Put(int64_t idx, T* item) {
+            items[idx & mask].store(item, std::memory_order_relaxed);
+        }
+    };
+
+    Array* Grow(Array* old_array, int64_t t, int64_t b) {
+        auto a = Array::Create((old_array->mask + 1) << 1);
+        if (!a) {
+            return nullptr;
+        }
+        for (int64_t i = t; i < b; ++i) {
+            a->Put(i, old_array->Get(i));
+        }
+        array_.store(a, std::memory_order_release);
+        // thieves may still be reading the old array. it is released in destructor.
+        retired_.push_back(old_array);
+        return a;
+    }
+
+private:
+    // l1 cache line size for most CPUs
+    static constexpr int CACHELINE_SIZE = 64;
+
+    union {
+        std::atomic<int64_t> top_;
+        char padding1[CACHELINE_SIZE];
+    };
+    union {
+        std::atomic<int64_t> bottom_;
+        char padding2[CACHELINE_SIZE];
+    };
+    std::atomic<Array*> array_;
+    std::vector<Array*> retired_;
+
+private:
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque(WorkStealingDeque&&) = delete;
+    void operator=(const WorkStealingDeque&) = delete;
+    void operator=(WorkStealingDeque&&) = delete;
+};
+
+}} // namespace ppl::common
+
+#endif
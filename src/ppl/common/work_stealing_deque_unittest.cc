@@ -0,0 +1,104 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "ppl/common/work_stealing_deque.h"
+#include "gtest/gtest.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace ppl::common;
+
+TEST(WorkStealingDequeTest, push_pop_steal) {
+    int values[4] = {0, 1, 2, 3};
+    WorkStealingDeque<int> q(2);
+
+    ASSERT_TRUE(q.IsEmpty());
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(q.Push(&values[i])); // grows
+    }
+    ASSERT_EQ(4, q.Size());
+
+    ASSERT_EQ(&values[0], q.Steal()); // fifo for thieves
+    ASSERT_EQ(&values[3], q.Pop()); // lifo for the owner
+    ASSERT_EQ(&values[2], q.Pop());
+    ASSERT_EQ(&values[1], q.Steal());
+    ASSERT_EQ(nullptr, q.Pop());
+    ASSERT_EQ(nullptr, q.Steal());
+    ASSERT_TRUE(q.IsEmpty());
+}
+
+TEST(WorkStealingDequeTest, concurrent_steal) {
+    const int n = 100000;
+    const int nr_thieves = 3;
+    std::vector<int> values(n);
+    std::vector<std::atomic<int>> visited(n);
+    for (int i = 0; i < n; ++i) {
+        values[i] = i;
+        visited[i].store(0);
+    }
+
+    WorkStealingDeque<int> q(16);
+    std::atomic<bool> done(false);
+    std::atomic<int> total(0);
+
+    auto thief = [&]() {
+        while (!done.load() || !q.IsEmpty()) {
+            auto v = q.Steal();
+            if (v) {
+                visited[*v].fetch_add(1);
+                total.fetch_add(1);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    };
+
+    std::vector<std::thread> thieves;
+    for (int i = 0; i < nr_thieves; ++i) {
+        thieves.emplace_back(thief);
+    }
+
+    for (int i = 0; i < n; ++i) {
+        ASSERT_TRUE(q.Push(&values[i]));
+        if (i % 3 == 0) {
+            auto v = q.Pop();
+            if (v) {
+                visited[*v].fetch_add(1);
+                total.fetch_add(1);
+            }
+        }
+    }
+    while (true) {
+        auto v = q.Pop();
+        if (!v) {
+            break;
+        }
+        visited[*v].fetch_add(1);
+        total.fetch_add(1);
+    }
+    done.store(true);
+
+    for (auto t = thieves.begin(); t != thieves.end(); ++t) {
+        t->join();
+    }
+
+    ASSERT_EQ(n, total.load());
+    for (int i = 0; i < n; ++i) {
+        ASSERT_EQ(1, visited[i].load());
+    }
+}